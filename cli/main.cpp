@@ -10,6 +10,7 @@
 #include <string>
 #include <via/via.hpp>
 #include "logger.hpp"
+#include "module/binary.hpp"
 #include "module/module.hpp"
 #include "options.hpp"
 #include "support/ansi.hpp"
@@ -25,6 +26,14 @@ translate_module_flags(via::ModuleFlags& flags, const via::cli::ProgramOptions&
         flags |= NO_EXECUTION;
     if (options.debugger)
         flags |= LAUNCH_DEBUGGER;
+    if (options.record_profile)
+        flags |= RECORD_PROFILE;
+    if (options.use_profile)
+        flags |= USE_PROFILE;
+    if (options.emit_binary)
+        flags |= EMIT_BINARY;
+    if (options.lazy_functions)
+        flags |= LAZY_FUNCTIONS;
 
     constexpr std::pair<std::string_view, via::ModuleFlags> dump_flags[] = {
         {"token-tree", DUMP_TTREE},
@@ -49,7 +58,14 @@ int main(int argc, char* argv[])
     using namespace via::operators;
 
     via::Logger& logger = via::Logger::stdout_logger();
-    ProgramOptions options;
+
+    auto parsed = ProgramOptions::parse(argc, argv);
+    if (!parsed.has_value()) {
+        logger.error("{}", parsed.error());
+        return 1;
+    }
+
+    ProgramOptions& options = *parsed;
 
     ModuleFlags flags = ModuleFlags::NONE;
     translate_module_flags(flags, options);
@@ -83,8 +99,20 @@ int main(int argc, char* argv[])
         manager.push_import_path(path);
     }
 
-    // Instantiate root module
-    auto module = Module::load_source_file(
+    if (!options.no_cache) {
+        manager.set_cache(via::get_cache_dir());
+    }
+
+    manager.set_profile_dir(via::get_cache_dir() / "profiles");
+
+    manager.set_jobs(options.jobs);
+
+    // Instantiate root module, compiled modules are run without recompiling
+    auto load = options.input.extension() == via::config::BINARY_EXTENSION
+                    ? Module::load_binary_file
+                    : Module::load_source_file;
+
+    auto module = load(
         manager,
         nullptr,
         options.input.stem().c_str(),
@@ -99,6 +127,18 @@ int main(int argc, char* argv[])
         return 1;
     }
 
+    if (auto* cache = manager.cache(); cache && options.verbosity > 0) {
+        const auto& stats = cache->stats();
+        logger.info(
+            "compile cache '{}': {} hits, {} misses, {} written, {} failed writes",
+            cache->directory().string(),
+            stats.hits.load(),
+            stats.misses.load(),
+            stats.writes.load(),
+            stats.failed_writes.load()
+        );
+    }
+
     if (options.dump.contains("symbol-table")) {
         std::cout << manager.symbol_table().to_string();
     } else if (options.dump.contains("import-dirs")) {
@@ -8,10 +8,80 @@
 ** ===================================================== */
 
 #include "options.hpp"
+#include <charconv>
 #include <numeric>
+#include <string_view>
 
-void via::cli::ProgramOptions::register_to(ArgumentParser& parser)
-{}
+std::expected<via::cli::ProgramOptions, std::string>
+via::cli::ProgramOptions::parse(int argc, char* argv[])
+{
+    ProgramOptions options;
+    std::vector<std::string_view> args(argv + 1, argv + argc);
+
+    // `run` is the only command, and the default one
+    size_t first = !args.empty() && args.front() == "run" ? 1 : 0;
+
+    for (size_t i = first; i < args.size(); i++) {
+        auto arg = args[i];
+
+        // Options that take a value read it from the next argument
+        auto value = [&]() -> std::expected<std::string_view, std::string> {
+            if (i + 1 >= args.size())
+                return std::unexpected(std::format("missing value for '{}'", arg));
+            return args[++i];
+        };
+
+        if (arg == "-v" || arg == "--verbose") {
+            options.verbosity++;
+        } else if (arg == "--no-execute") {
+            options.no_execute = true;
+        } else if (arg == "--debug") {
+            options.debugger = true;
+        } else if (arg == "--i-am-stupid") {
+            options.supress_missing_core_warning = true;
+        } else if (arg == "--record-profile") {
+            options.record_profile = true;
+        } else if (arg == "--use-profile") {
+            options.use_profile = true;
+        } else if (arg == "--emit-binary") {
+            options.emit_binary = true;
+        } else if (arg == "--no-cache") {
+            options.no_cache = true;
+        } else if (arg == "--lazy-functions") {
+            options.lazy_functions = true;
+        } else if (arg == "-j" || arg == "--jobs") {
+            auto jobs = value();
+            if (!jobs.has_value())
+                return std::unexpected(jobs.error());
+
+            auto [end, ec] =
+                std::from_chars(jobs->data(), jobs->data() + jobs->size(), options.jobs);
+            if (ec != std::errc() || end != jobs->data() + jobs->size() ||
+                options.jobs == 0)
+                return std::unexpected(std::format("invalid job count '{}'", *jobs));
+        } else if (arg == "--dump") {
+            auto dump = value();
+            if (!dump.has_value())
+                return std::unexpected(dump.error());
+            options.dump.emplace(*dump);
+        } else if (arg == "-i" || arg == "--import") {
+            auto import = value();
+            if (!import.has_value())
+                return std::unexpected(import.error());
+            options.imports.emplace_back(*import);
+        } else if (arg.starts_with("-")) {
+            return std::unexpected(std::format("unknown option '{}'", arg));
+        } else if (options.input.empty()) {
+            options.input = arg;
+        } else {
+            return std::unexpected(std::format("unexpected argument '{}'", arg));
+        }
+    }
+
+    if (options.input.empty())
+        return std::unexpected("no input files");
+    return options;
+}
 
 std::string via::cli::ProgramOptions::to_string() const
 {
@@ -20,12 +90,23 @@ std::string via::cli::ProgramOptions::to_string() const
         "  verbosity:   {}\n"
         "  no_execute:  {}\n"
         "  debugger:    {}\n"
+        "  profile:     record={} use={}\n"
+        "  emit_binary: {}\n"
+        "  no_cache:    {}\n"
+        "  lazy_fns:    {}\n"
+        "  jobs:        {}\n"
         "  input:       {}\n"
         "  dump:        [{}]\n"
         "  imports:     [{}]",
         verbosity,
         no_execute,
         debugger,
+        record_profile,
+        use_profile,
+        emit_binary,
+        no_cache,
+        lazy_functions,
+        jobs,
         input.string(),
         dump.empty() ? ""
                      : std::accumulate(
@@ -10,9 +10,11 @@
 #pragma once
 
 #include <cstdint>
+#include <expected>
 #include <filesystem>
 #include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace via {
@@ -24,10 +26,19 @@ struct ProgramOptions
     bool no_execute = false;
     bool debugger = false;
     bool supress_missing_core_warning = false;
+    bool record_profile = false;
+    bool use_profile = false;
+    bool emit_binary = false;
+    bool no_cache = false;
+    bool lazy_functions = false; // Only compile and check function bodies that are used
+    size_t jobs = std::thread::hardware_concurrency(); // Threads compiling imports
     std::filesystem::path input;
     std::set<std::string> dump;
     std::vector<std::string> imports;
 
+    // Parses `via [run] [options] <input>`
+    static std::expected<ProgramOptions, std::string> parse(int argc, char* argv[]);
+
     std::string to_string() const;
 };
 
@@ -61,3 +61,19 @@ std::filesystem::path via::get_lang_dir()
     return sys_dir;
 #endif
 }
+
+// Gets the directory compiled modules are cached in
+std::filesystem::path via::get_cache_dir()
+{
+#ifdef _WIN32
+    if (const char* local = std::getenv("LOCALAPPDATA")) {
+        return std::filesystem::path(local) / "via" / "cache";
+    }
+    return get_home_dir() / "AppData" / "Local" / "via" / "cache";
+#else
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME")) {
+        return std::filesystem::path(xdg) / "via";
+    }
+    return get_home_dir() / ".cache" / "via";
+#endif
+}
@@ -15,5 +15,6 @@ namespace via {
 
 std::filesystem::path get_home_dir();
 std::filesystem::path get_lang_dir();
+std::filesystem::path get_cache_dir();
 
 } // namespace via
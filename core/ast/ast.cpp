@@ -30,6 +30,35 @@ std::string via::ast::Parameter::to_string() const
     return std::format("{}: {}", symbol->to_string(), type->to_string());
 }
 
+std::string via::ast::Attribute::to_string() const
+{
+    if (args.empty())
+        return std::format("#{}", name->to_string());
+
+    return std::format(
+        "#{}{}",
+        name->to_string(),
+        via::to_string(
+            args,
+            [](const auto& arg) { return arg->to_string(); },
+            "(",
+            ")",
+            " "
+        )
+    );
+}
+
+static std::string attrs_to_string(const via::ast::AttributeList& attrs)
+{
+    return via::to_string(
+        attrs,
+        [](const auto& attr) { return attr.to_string() + " "; },
+        "",
+        "",
+        ""
+    );
+}
+
 std::string via::ast::Scope::to_string(size_t depth) const
 {
     return via::to_string(
@@ -138,7 +167,8 @@ std::string via::ast::ExprLambda::to_string(size_t depth) const
 std::string via::ast::StmtVarDecl::to_string(size_t depth) const
 {
     return INDENT(depth) + std::format(
-                               "var {}: {} = {}",
+                               "{}var {}: {} = {}",
+                               attrs_to_string(attrs),
                                lval->to_string(),
                                type ? type->to_string() : "<infered>",
                                rval ? rval->to_string() : "<none>"
@@ -247,8 +277,17 @@ std::string via::ast::StmtImport::to_string(size_t depth) const
 std::string via::ast::StmtFunctionDecl::to_string(size_t depth) const
 {
     return INDENT(depth) + std::format(
-                               "fn {}{} -> {} {}",
+                               "{}fn {}{}{} -> {} {}",
+                               attrs_to_string(attrs),
                                name->to_string(),
+                               type_parms.empty()
+                                   ? ""
+                                   : via::to_string(
+                                         type_parms,
+                                         [](const auto& tok) { return tok->to_string(); },
+                                         "<",
+                                         ">"
+                                     ),
                                via::to_string(
                                    parms,
                                    [](const auto& arg) { return arg->to_string(); },
@@ -256,7 +295,7 @@ std::string via::ast::StmtFunctionDecl::to_string(size_t depth) const
                                    ")"
                                ),
                                ret != nullptr ? ret->to_string() : "<infered>",
-                               body->to_string(depth)
+                               body ? body->to_string(depth) : "{ <deferred> }"
                            );
 }
 
@@ -287,6 +326,11 @@ std::string via::ast::TypeBuiltin::to_string(size_t) const
     return token->to_string();
 }
 
+std::string via::ast::TypeSymbol::to_string(size_t) const
+{
+    return symbol->to_string();
+}
+
 std::string via::ast::TypeArray::to_string(size_t) const
 {
     return std::format("[{}]", type->to_string());
@@ -59,6 +59,16 @@ struct Parameter
     std::string to_string() const;
 };
 
+struct Attribute
+{
+    const Token* name;
+    std::vector<const Token*> args;
+    SourceLoc loc;
+    std::string to_string() const;
+};
+
+using AttributeList = std::vector<Attribute>;
+
 struct Scope
 {
     std::vector<const Stmt*> stmts;
@@ -166,6 +176,7 @@ struct ExprLambda: public Expr
 struct StmtVarDecl: public Stmt
 {
     NODE_FIELDS(StmtVarDecl);
+    AttributeList attrs;
     const Token* decl;
     const Expr* lval;
     const Expr* rval;
@@ -249,10 +260,13 @@ struct StmtImport: public Stmt
 struct StmtFunctionDecl: public Stmt
 {
     NODE_FIELDS(StmtFunctionDecl);
+    AttributeList attrs;
     const Token* name;
+    std::vector<const Token*> type_parms; // Empty unless the function is generic
     const Type* ret;
     std::vector<const Parameter*> parms;
     const Scope* body;
+    const Token* const* deferred = nullptr; // Body skipped by a lazy parse
 };
 
 struct StmtStructDecl: public Stmt
@@ -286,6 +300,12 @@ struct TypeBuiltin: public Type
     const Token* token;
 };
 
+struct TypeSymbol: public Type
+{
+    NODE_FIELDS(TypeSymbol);
+    const Token* symbol;
+};
+
 struct TypeArray: public Type
 {
     NODE_FIELDS(TypeArray);
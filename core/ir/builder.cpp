@@ -8,6 +8,7 @@
 ** ===================================================== */
 
 #include "builder.hpp"
+#include <algorithm>
 #include <cpptrace/basic.hpp>
 #include <format>
 #include <vector>
@@ -22,6 +23,7 @@
 #include "sema/stack.hpp"
 #include "sema/types.hpp"
 #include "support/ansi.hpp"
+#include "support/enum.hpp"
 #include "support/traits.hpp"
 #include "vm/instruction.hpp"
 
@@ -213,6 +215,9 @@ via::QualType via::detail::ast_type_of<via::ast::ExprStaticAccess>(
             auto high = builder.intern_symbol(ast_expr_st_access->index->to_string());
 
             if (auto def = module->lookup(high)) {
+                if TRY_COERCE (const ConstantDef, const_def, *def)
+                    return const_def->type;
+
                 if TRY_COERCE (const FunctionDef, func_def, *def) {
                     std::vector<via::QualType> parm_types;
 
@@ -264,6 +269,15 @@ via::QualType via::detail::ast_type_of<via::ast::ExprCall>(
     const ast::ExprCall* ast_expr_call
 ) noexcept
 {
+    if (auto* generic = builder.find_generic(ast_expr_call->callee)) {
+        std::vector<QualType> args;
+        if (!builder.infer_type_args(generic, ast_expr_call, args, false))
+            return nullptr;
+
+        auto* instance = builder.instance_type(generic, args);
+        return instance ? instance->returns() : nullptr;
+    }
+
     auto callee = builder.type_of(ast_expr_call->callee);
     if TRY_COERCE (const FunctionType, function, callee.unwrap())
         return function->returns();
@@ -323,6 +337,28 @@ via::QualType via::detail::ast_type_of<via::ast::TypeBuiltin>(
     return BuiltinType::instance(builder.m_type_ctx, kind);
 }
 
+template <>
+via::QualType via::detail::ast_type_of<via::ast::TypeSymbol>(
+    IRBuilder& builder,
+    const ast::TypeSymbol* ast_type_symbol
+) noexcept
+{
+    auto name = ast_type_symbol->symbol->to_string();
+
+    // Type parameters are bound while a generic instance is being lowered
+    if (!builder.m_generic_scopes.empty()) {
+        auto& type_args = builder.m_generic_scopes.back().type_args;
+        if (auto it = type_args.find(name); it != type_args.end())
+            return it->second;
+    }
+
+    builder.m_diags.report<Level::ERROR>(
+        ast_type_symbol->loc,
+        std::format("unknown type '{}'", name)
+    );
+    return {};
+}
+
 via::QualType via::IRBuilder::type_of(const ast::Expr* expr) noexcept
 {
 #define VISIT_EXPR(TYPE)                                                                 \
@@ -371,6 +407,7 @@ via::QualType via::IRBuilder::type_of(const ast::Type* type) noexcept
     }
 
     VISIT_TYPE(ast::TypeBuiltin)
+    VISIT_TYPE(ast::TypeSymbol)
     VISIT_TYPE(ast::TypeArray)
     VISIT_TYPE(ast::TypeMap)
     VISIT_TYPE(ast::TypeFunc)
@@ -412,7 +449,34 @@ const via::ir::Expr* via::detail::ast_lower_expr<via::ast::ExprSymbol>(
     ast_expr_symbol->symbol = builder.m_symbol_table.intern(symbol);
     ast_expr_symbol->type = ast_type_of(builder, ast_symbol_expr);
 
-    if (!frame.get_local(ast_expr_symbol->symbol).has_value()) {
+    if (auto local = frame.get_local(ast_expr_symbol->symbol)) {
+        // Deferred bodies are only lowered once something refers to them
+        if TRY_COERCE (const ir::StmtFuncDecl, fn_decl, local->local->get_ir_decl())
+            builder.reference(fn_decl);
+
+        // Uses of '#comptime' constants are replaced by their value
+        if TRY_COERCE (const ir::StmtVarDecl, var_decl, local->local->get_ir_decl()) {
+            if ((var_decl->attrs & VarAttrs::COMPTIME) &&
+                TRY_IS(const ir::ExprConstant, var_decl->expr)) {
+                auto* constant_expr = builder.m_alloc.emplace<ir::ExprConstant>();
+                constant_expr->loc = ast_symbol_expr->loc;
+                constant_expr->value =
+                    dynamic_cast<const ir::ExprConstant*>(var_decl->expr)->value;
+                constant_expr->type = var_decl->type;
+                return constant_expr;
+            }
+        }
+    } else if (builder.m_generics.contains(ast_expr_symbol->symbol)) {
+        builder.m_diags.report<Level::ERROR>(
+            ast_expr_symbol->loc,
+            std::format("generic function '{}' can only be called", symbol),
+            Footnote(
+                FootnoteKind::NOTE,
+                "generic functions are instantiated from the arguments of each call"
+            )
+        );
+        return nullptr;
+    } else {
         builder.poison_symbol(ast_expr_symbol->symbol);
         builder.m_diags.report<Level::ERROR>(
             ast_expr_symbol->loc,
@@ -444,6 +508,15 @@ const via::ir::Expr* via::detail::ast_lower_expr<via::ast::ExprStaticAccess>(
             auto low = builder.intern_symbol(ast_stc_access_expr->index->to_string());
 
             if (auto def = module->lookup(low)) {
+                // Constants of imported modules are propagated into this one
+                if TRY_COERCE (const ConstantDef, const_def, *def) {
+                    auto* constant_expr = builder.m_alloc.emplace<ir::ExprConstant>();
+                    constant_expr->loc = ast_stc_access_expr->loc;
+                    constant_expr->value = const_def->value;
+                    constant_expr->type = const_def->type;
+                    return constant_expr;
+                }
+
                 auto* maccess = builder.m_alloc.emplace<ir::ExprModuleAccess>();
                 maccess->module = module;
                 maccess->mod_id = high;
@@ -562,7 +635,27 @@ const via::ir::Expr* via::detail::ast_lower_expr<via::ast::ExprCall>(
 ) noexcept
 {
     auto* call_expr = builder.m_alloc.emplace<ir::ExprCall>();
-    call_expr->callee = builder.lower_expr(ast_expr_call->callee);
+    const ir::StmtFuncDecl* instance = nullptr;
+
+    // Calls to generic functions are bound to the instance for their arguments
+    if (auto* generic = builder.find_generic(ast_expr_call->callee)) {
+        std::vector<QualType> type_args;
+        if (!builder.infer_type_args(generic, ast_expr_call, type_args, true))
+            return nullptr;
+
+        instance = builder.instantiate(generic, type_args, ast_expr_call);
+        if (instance == nullptr)
+            return nullptr;
+
+        auto* symbol = builder.m_alloc.emplace<ir::ExprSymbol>();
+        symbol->loc = ast_expr_call->callee->loc;
+        symbol->symbol = instance->symbol;
+        symbol->type = builder.instance_type(generic, type_args);
+        call_expr->callee = symbol;
+    } else {
+        call_expr->callee = builder.lower_expr(ast_expr_call->callee);
+    }
+
     call_expr->loc = ast_expr_call->loc;
     call_expr->args = [&]() {
         std::vector<const ir::Expr*> args;
@@ -574,7 +667,8 @@ const via::ir::Expr* via::detail::ast_lower_expr<via::ast::ExprCall>(
     if (!call_expr->callee)
         return nullptr;
 
-    auto callee = builder.type_of(ast_expr_call->callee);
+    auto callee = instance ? call_expr->callee->type
+                           : builder.type_of(ast_expr_call->callee);
 
     if TRY_COERCE (const FunctionType, func, callee.unwrap()) {
         const size_t arg_count = ast_expr_call->args.size(),
@@ -649,6 +743,19 @@ const via::ir::Expr* via::detail::ast_lower_expr<via::ast::ExprCall>(
             )
         );
     }
+
+    if TRY_COERCE (const ast::ExprSymbol, callee_symbol, ast_expr_call->callee) {
+        auto id = instance ? instance->symbol
+                           : builder.intern_symbol(*callee_symbol->symbol);
+        if (auto local = builder.m_stack.top().get_local(id)) {
+            if TRY_COERCE (const ir::StmtFuncDecl,
+                           func_decl,
+                           local->local->get_ir_decl()) {
+                if (func_decl->attrs & FuncAttrs::COMPTIME)
+                    return builder.fold_comptime_call(call_expr, func_decl);
+            }
+        }
+    }
     return call_expr;
 }
 
@@ -842,6 +949,99 @@ const via::ir::Stmt* via::detail::ast_lower_stmt<via::ast::StmtWhile>(
     return merge_block;
 }
 
+template <>
+const via::ir::Stmt* via::detail::ast_lower_stmt<via::ast::StmtFor>(
+    IRBuilder& builder,
+    const ast::StmtFor* ast_stmt_for
+) noexcept
+{
+    auto* merge_block = builder.m_alloc.emplace<ir::StmtBlock>();
+    merge_block->id = builder.m_block_id++;
+
+    auto* prep_block = builder.m_alloc.emplace<ir::StmtBlock>();
+    prep_block->id = builder.m_block_id++;
+
+    auto* body_block = builder.m_alloc.emplace<ir::StmtBlock>();
+    body_block->id = builder.m_block_id++;
+
+    const auto* ast_init = ast_stmt_for->init;
+
+    // The loop variable is declared by the loop terminators rather than by a
+    // statement, this declaration only carries its symbol, type and initial
+    // value.
+    auto* var_decl = builder.m_alloc.emplace<ir::StmtVarDecl>();
+    var_decl->loc = ast_init->loc;
+    var_decl->expr = builder.lower_expr(ast_init->rval);
+    var_decl->type = builder.type_of(ast_init->rval);
+
+    if TRY_COERCE (const ast::ExprSymbol, lval, ast_init->lval) {
+        var_decl->symbol = builder.intern_symbol(lval->symbol->to_string());
+    } else {
+        debug::bug("bad lvalue");
+    }
+
+    for (const ast::Expr* bound:
+         {ast_init->rval, ast_stmt_for->target, ast_stmt_for->step}) {
+        if (bound == nullptr)
+            continue;
+
+        auto type = builder.type_of(bound);
+        if (type.unwrap() == nullptr || !type.unwrap()->is_integral()) {
+            builder.m_diags.report<Level::ERROR>(
+                bound->loc,
+                std::format(
+                    "ranged for loop bound of type '{}' is not an integer",
+                    builder.dump_type(type)
+                )
+            );
+        }
+    }
+
+    auto* prep_term = builder.m_alloc.emplace<ir::TrForPrep>();
+    prep_term->loc = ast_stmt_for->loc;
+    prep_term->var = var_decl;
+    prep_term->limit = builder.lower_expr(ast_stmt_for->target);
+    prep_term->step =
+        ast_stmt_for->step ? builder.lower_expr(ast_stmt_for->step) : nullptr;
+    prep_term->body = body_block;
+    prep_term->exit = merge_block;
+    prep_block->term = prep_term;
+
+    body_block->term = ({
+        auto* loop_term = builder.m_alloc.emplace<ir::TrForLoop>();
+        loop_term->loc = ast_stmt_for->loc;
+        loop_term->prep = prep_term;
+        loop_term;
+    });
+
+    auto* current_block = builder.m_current_block;
+    builder.m_current_block = body_block;
+
+    builder.m_current_block->stmts.push_back(({
+        auto* save = builder.m_alloc.emplace<ir::StmtInstruction>();
+        save->instr = {OpCode::SAVE, 0, 0, 0};
+        save;
+    }));
+
+    builder.m_stack.top().set_local(var_decl->symbol, ast_init, var_decl);
+
+    for (const auto& stmt: ast_stmt_for->body->stmts) {
+        builder.m_current_block->stmts.push_back(builder.lower_stmt(stmt));
+    }
+
+    builder.m_current_block->stmts.push_back(({
+        auto* restore = builder.m_alloc.emplace<ir::StmtInstruction>();
+        restore->instr = {OpCode::RESTORE, 0, 0, 0};
+        restore;
+    }));
+
+    builder.m_current_block = current_block;
+
+    current_block->stmts.push_back(prep_block);
+    current_block->stmts.push_back(body_block);
+    return merge_block;
+}
+
 template <>
 const via::ir::Stmt* via::detail::ast_lower_stmt<via::ast::StmtVarDecl>(
     IRBuilder& builder,
@@ -852,6 +1052,23 @@ const via::ir::Stmt* via::detail::ast_lower_stmt<via::ast::StmtVarDecl>(
     decl_stmt->expr = builder.lower_expr(ast_stmt_var_decl->rval);
     decl_stmt->loc = ast_stmt_var_decl->loc;
 
+    if (ast_stmt_var_decl->decl->kind == TokenKind::KW_CONST)
+        decl_stmt->attrs |= VarAttrs::CONST;
+
+    for (const auto& attr: ast_stmt_var_decl->attrs) {
+        if (attr.name->to_string() != "comptime") {
+            builder.report_unknown_attribute(attr);
+        } else if (ast_stmt_var_decl->decl->kind != TokenKind::KW_CONST) {
+            builder.m_diags.report<Level::ERROR>(
+                attr.loc,
+                "'#comptime' can only be applied to constant declarations",
+                Footnote(FootnoteKind::SUGGESTION, "Replace 'var' with 'const'")
+            );
+        } else {
+            decl_stmt->attrs |= VarAttrs::COMPTIME;
+        }
+    }
+
     if TRY_COERCE (const ast::ExprSymbol, lval, ast_stmt_var_decl->lval) {
         auto rval_type = builder.type_of(ast_stmt_var_decl->rval);
 
@@ -888,6 +1105,23 @@ fallback:
         debug::bug("bad lvalue");
     }
 
+    if ((decl_stmt->attrs & VarAttrs::COMPTIME) && decl_stmt->expr != nullptr) {
+        auto result = builder.m_comptime.evaluate(decl_stmt->expr);
+        if (result.has_value()) {
+            auto* constant_expr = builder.m_alloc.emplace<ir::ExprConstant>();
+            constant_expr->loc = decl_stmt->expr->loc;
+            constant_expr->value = *result;
+            constant_expr->type = decl_stmt->type;
+            decl_stmt->expr = constant_expr;
+        } else {
+            builder.m_diags.report<Level::ERROR>(
+                ast_stmt_var_decl->rval->loc,
+                "failed to evaluate '#comptime' declaration",
+                Footnote(FootnoteKind::NOTE, result.error())
+            );
+        }
+    }
+
     builder.m_stack.top().set_local(decl_stmt->symbol, ast_stmt_var_decl, decl_stmt);
     return decl_stmt;
 }
@@ -933,7 +1167,19 @@ const via::ir::Stmt* via::detail::ast_lower_stmt<via::ast::StmtImport>(
         return nullptr;
     }
 
-    if (auto module = builder.m_module->manager().get_module_by_name(name)) {
+    // Source modules loaded for another import statement, of this module or
+    // through a diamond, are imported more than once. A graph loads them before
+    // compiling, so the statement that loaded one is not a repeat.
+    auto* module = builder.m_module->manager().get_module_by_name(name);
+    bool repeated = module != nullptr && module->ast_decl() != ast_stmt_import;
+
+    // Native and compiled modules are shared, only this module may not repeat them
+    if (repeated && module->kind() != ModuleKind::SOURCE) {
+        auto& imports = builder.m_module->imports();
+        repeated = std::ranges::find(imports, module) != imports.end();
+    }
+
+    if (repeated) {
         builder.poison_symbol(name);
         builder.m_diags.report<Level::ERROR>(
             ast_stmt_import->loc,
@@ -962,9 +1208,41 @@ const via::ir::Stmt* via::detail::ast_lower_stmt<via::ast::StmtFunctionDecl>(
     const ast::StmtFunctionDecl* ast_stmt_function_decl
 ) noexcept
 {
+    auto& scopes = builder.m_generic_scopes;
+    bool instancing = !scopes.empty() && scopes.back().generic == ast_stmt_function_decl;
+
+    // Generic functions are only lowered once instantiated by a call
+    if (!ast_stmt_function_decl->type_parms.empty() && !instancing) {
+        if (builder.m_stack.size() > 1) {
+            builder.m_diags.report<Level::ERROR>(
+                ast_stmt_function_decl->loc,
+                "generic functions cannot be nested"
+            );
+            return nullptr;
+        }
+
+        auto symbol = builder.intern_symbol(*ast_stmt_function_decl->name);
+        builder.m_generics[symbol] = ast_stmt_function_decl;
+        return nullptr;
+    }
+
     auto* decl_stmt = builder.m_alloc.emplace<ir::StmtFuncDecl>();
     decl_stmt->kind = ImplKind::SOURCE;
-    decl_stmt->symbol = builder.intern_symbol(ast_stmt_function_decl->name->to_string());
+    decl_stmt->symbol = instancing ? scopes.back().symbol
+                                   : builder.intern_symbol(*ast_stmt_function_decl->name);
+
+    for (const auto& attr: ast_stmt_function_decl->attrs) {
+        if (attr.name->to_string() == "inline") {
+            decl_stmt->attrs |= FuncAttrs::INLINE;
+        } else if (attr.name->to_string() == "comptime") {
+            decl_stmt->attrs |= FuncAttrs::COMPTIME;
+        } else if (attr.name->to_string() == "memoize") {
+            decl_stmt->attrs |= FuncAttrs::MEMOIZE;
+        } else {
+            builder.report_unknown_attribute(attr);
+        }
+    }
+
     decl_stmt->ret = ast_stmt_function_decl->ret
                          ? builder.type_of(ast_stmt_function_decl->ret)
                          : nullptr;
@@ -986,49 +1264,102 @@ const via::ir::Stmt* via::detail::ast_lower_stmt<via::ast::StmtFunctionDecl>(
         decl_stmt->parms.push_back(new_parm);
     }
 
-    auto* block = builder.m_alloc.emplace<ir::StmtBlock>();
-    block->id = builder.m_block_id++;
+    // Bodies skipped by a lazy parse are lowered once the function is referenced
+    if (ast_stmt_function_decl->deferred != nullptr) {
+        builder.m_deferred[decl_stmt] = {
+            .decl = decl_stmt,
+            .ast_decl = ast_stmt_function_decl,
+            .block = builder.m_current_block,
+        };
+    } else {
+        builder.lower_body(decl_stmt, ast_stmt_function_decl->body);
+    }
 
-    builder.m_stack.push({});
+    // Instances are looked up by `instantiate`, in the frame they are declared in
+    if (!instancing) {
+        auto& frame = builder.m_stack.top();
+        frame.set_local(
+            decl_stmt->symbol,
+            ast_stmt_function_decl,
+            decl_stmt,
+            IRLocal::Qual::CONST
+        );
+    }
 
-    for (const auto& stmt: ast_stmt_function_decl->body->stmts) {
+    decl_stmt->loc = ast_stmt_function_decl->loc;
+    return decl_stmt;
+}
+
+template <>
+const via::ir::Stmt* via::detail::ast_lower_stmt<via::ast::StmtExpr>(
+    IRBuilder& builder,
+    const ast::StmtExpr* ast_stmt_expr
+) noexcept
+{
+    auto* expr = builder.m_alloc.emplace<ir::StmtExpr>();
+    expr->expr = builder.lower_expr(ast_stmt_expr->expr);
+    expr->loc = ast_stmt_expr->loc;
+    return expr;
+}
+
+void via::IRBuilder::lower_body(ir::StmtFuncDecl* decl, const ast::Scope* body) noexcept
+{
+    auto* block = m_alloc.emplace<ir::StmtBlock>();
+    block->id = m_block_id++;
+
+    auto* frame_block = m_frame_block;
+    m_frame_block = block;
+    m_stack.push({});
+
+    // Bodies see their own function, so that it can call itself
+    m_stack.top().set_local(decl->symbol, nullptr, decl, IRLocal::Qual::CONST);
+
+    // Parameters are read with GETARG, their declarations only carry the type
+    // and are not statements of any block
+    for (const auto& parm: decl->parms) {
+        auto* parm_decl = m_alloc.emplace<ir::StmtVarDecl>();
+        parm_decl->loc = decl->loc;
+        parm_decl->symbol = parm.symbol;
+        parm_decl->expr = nullptr;
+        parm_decl->type = parm.type;
+        m_stack.top().set_local(parm.symbol, nullptr, parm_decl, IRLocal::Qual::CONST);
+    }
+
+    for (const auto& stmt: body->stmts) {
         if TRY_COERCE (const ast::StmtReturn, ret, stmt) {
-            auto* term = builder.m_alloc.emplace<ir::TrReturn>();
+            auto* term = m_alloc.emplace<ir::TrReturn>();
             term->implicit = false;
             term->loc = ret->loc;
-            term->val = ret->expr ? builder.lower_expr(ret->expr) : nullptr;
-            term->type =
-                ret->expr ? builder.type_of(ret->expr)
-                          : BuiltinType::instance(builder.m_type_ctx, BuiltinKind::NIL);
+            term->val = ret->expr ? lower_expr(ret->expr) : nullptr;
+            term->type = ret->expr ? type_of(ret->expr)
+                                   : BuiltinType::instance(m_type_ctx, BuiltinKind::NIL);
             block->term = term;
             break;
         }
 
-        block->stmts.push_back(builder.lower_stmt(stmt));
+        block->stmts.push_back(lower_stmt(stmt));
     }
 
-    builder.m_stack.pop();
+    m_stack.pop();
+    m_frame_block = frame_block;
 
     if (block->term == nullptr) {
-        SourceLoc loc{
-            ast_stmt_function_decl->body->loc.end - 1,
-            ast_stmt_function_decl->body->loc.end
-        };
+        SourceLoc loc{body->loc.end - 1, body->loc.end};
 
-        auto* nil = builder.m_alloc.emplace<ir::ExprConstant>();
+        auto* nil = m_alloc.emplace<ir::ExprConstant>();
         nil->loc = loc;
-        nil->type = BuiltinType::instance(builder.m_type_ctx, BuiltinKind::NIL);
+        nil->type = BuiltinType::instance(m_type_ctx, BuiltinKind::NIL);
         nil->value = ConstValue();
 
-        auto* term = builder.m_alloc.emplace<ir::TrReturn>();
+        auto* term = m_alloc.emplace<ir::TrReturn>();
         term->implicit = true;
         term->loc = loc;
         term->val = nil;
-        term->type = BuiltinType::instance(builder.m_type_ctx, BuiltinKind::NIL);
+        term->type = BuiltinType::instance(m_type_ctx, BuiltinKind::NIL);
         block->term = term;
     }
 
-    QualType expected_ret_type = decl_stmt->ret;
+    QualType expected_ret_type = decl->ret;
 
     for (const auto& term: get_control_paths(block)) {
         if TRY_COERCE (const ir::TrReturn, ret, term) {
@@ -1048,21 +1379,21 @@ const via::ir::Stmt* via::detail::ast_lower_stmt<via::ast::StmtFunctionDecl>(
                           )
                         : Footnote();
 
-                if (decl_stmt->ret) {
-                    builder.poison_symbol(decl_stmt->symbol);
-                    builder.m_diags.report<Level::ERROR>(
+                if (decl->ret) {
+                    poison_symbol(decl->symbol);
+                    m_diags.report<Level::ERROR>(
                         ret->loc,
                         std::format(
                             "function return type '{}' does not match type "
                             "'{}' returned by control path",
-                            decl_stmt->ret.to_string(),
+                            decl->ret.to_string(),
                             ret->type.to_string()
                         ),
                         implicit_return_node
                     );
                 } else {
-                    builder.poison_symbol(decl_stmt->symbol);
-                    builder.m_diags.report<Level::ERROR>(
+                    poison_symbol(decl->symbol);
+                    m_diags.report<Level::ERROR>(
                         ret->loc,
                         "all code paths must return the same type "
                         "in function with inferred return type",
@@ -1072,8 +1403,8 @@ const via::ir::Stmt* via::detail::ast_lower_stmt<via::ast::StmtFunctionDecl>(
                 break;
             }
         } else {
-            builder.poison_symbol(decl_stmt->symbol);
-            builder.m_diags.report<Level::ERROR>(
+            poison_symbol(decl->symbol);
+            m_diags.report<Level::ERROR>(
                 term->loc,
                 "all control paths must return from function"
             );
@@ -1081,42 +1412,51 @@ const via::ir::Stmt* via::detail::ast_lower_stmt<via::ast::StmtFunctionDecl>(
         }
     }
 
-    if (decl_stmt->ret && expected_ret_type && decl_stmt->ret != expected_ret_type) {
-        builder.poison_symbol(decl_stmt->symbol);
-        builder.m_diags.report<Level::ERROR>(
+    if (decl->ret && expected_ret_type && decl->ret != expected_ret_type) {
+        poison_symbol(decl->symbol);
+        m_diags.report<Level::ERROR>(
             block->loc,
             std::format(
                 "Function return type '{}' does not match inferred "
                 "return type '{}' from all control paths",
-                builder.dump_type(decl_stmt->ret),
-                builder.dump_type(expected_ret_type)
+                dump_type(decl->ret),
+                dump_type(expected_ret_type)
             )
         );
     }
 
-    auto& frame = builder.m_stack.top();
-    frame.set_local(
-        decl_stmt->symbol,
-        ast_stmt_function_decl,
-        decl_stmt,
-        IRLocal::Qual::CONST
-    );
+    decl->body = block;
+}
 
-    decl_stmt->body = block;
-    decl_stmt->loc = ast_stmt_function_decl->loc;
-    return decl_stmt;
+void via::IRBuilder::reference(const ir::StmtFuncDecl* fn) noexcept
+{
+    if (auto it = m_deferred.find(fn); it != m_deferred.end() && !it->second.referenced) {
+        it->second.referenced = true;
+        m_referenced.push_back(&it->second);
+    }
 }
 
-template <>
-const via::ir::Stmt* via::detail::ast_lower_stmt<via::ast::StmtExpr>(
-    IRBuilder& builder,
-    const ast::StmtExpr* ast_stmt_expr
-) noexcept
+// Deferred bodies are lowered in the block their function was declared in,
+// bodies do not see the locals around them
+void via::IRBuilder::lower_deferred(DeferredBody& deferred) noexcept
 {
-    auto* expr = builder.m_alloc.emplace<ir::StmtExpr>();
-    expr->expr = builder.lower_expr(ast_stmt_expr->expr);
-    expr->loc = ast_stmt_expr->loc;
-    return expr;
+    if (!m_parser.has_value())
+        m_parser.emplace(m_module->source(), m_diags);
+
+    const ast::Scope* body = m_parser->parse_deferred(deferred.ast_decl);
+    if (body == nullptr) {
+        poison_symbol(deferred.decl->symbol);
+        return;
+    }
+
+    auto* current_block = m_current_block;
+    bool should_push_block = m_should_push_block;
+    m_current_block = deferred.block;
+
+    lower_body(deferred.decl, body);
+
+    m_current_block = current_block;
+    m_should_push_block = should_push_block;
 }
 
 via::ir::StmtBlock* via::IRBuilder::end_block() noexcept
@@ -1165,6 +1505,246 @@ std::string via::IRBuilder::dump_expr(const ast::Expr* expr) noexcept
     );
 }
 
+void via::IRBuilder::report_unknown_attribute(const ast::Attribute& attr) noexcept
+{
+    m_diags.report<Level::WARNING>(
+        attr.loc,
+        std::format("unknown attribute '#{}' ignored", attr.name->to_string())
+    );
+}
+
+const via::ir::Expr* via::IRBuilder::fold_comptime_call(
+    const ir::ExprCall* call,
+    const ir::StmtFuncDecl* fn
+) noexcept
+{
+    std::vector<ConstValue> args;
+    for (const auto& arg: call->args) {
+        if TRY_COERCE (const ir::ExprConstant, constant, arg) {
+            args.push_back(constant->value);
+        } else {
+            m_diags.report<Level::ERROR>(
+                arg ? arg->loc : call->loc,
+                "argument to '#comptime' function is not a compile-time constant"
+            );
+            return call;
+        }
+    }
+
+    auto result = m_comptime.call(fn, args);
+    if (!result.has_value()) {
+        m_diags.report<Level::ERROR>(
+            call->loc,
+            "failed to evaluate call to '#comptime' function",
+            Footnote(FootnoteKind::NOTE, result.error())
+        );
+        return call;
+    }
+
+    auto* constant_expr = m_alloc.emplace<ir::ExprConstant>();
+    constant_expr->loc = call->loc;
+    constant_expr->value = *result;
+    constant_expr->type = call->type;
+    return constant_expr;
+}
+
+// Returns the generic function `callee` names, or null if it names anything else
+const via::ast::StmtFunctionDecl*
+via::IRBuilder::find_generic(const ast::Expr* callee) noexcept
+{
+    auto* symbol = dynamic_cast<const ast::ExprSymbol*>(callee);
+    if (symbol == nullptr)
+        return nullptr;
+
+    // Locals shadow generic functions of the same name
+    auto id = intern_symbol(*symbol->symbol);
+    if (m_stack.top().get_local(id))
+        return nullptr;
+
+    auto it = m_generics.find(id);
+    return it != m_generics.end() ? it->second : nullptr;
+}
+
+// Infers the type arguments of `call` from the types of its arguments, in the
+// order the type parameters of `generic` are declared.
+bool via::IRBuilder::infer_type_args(
+    const ast::StmtFunctionDecl* generic,
+    const ast::ExprCall* call,
+    std::vector<QualType>& args,
+    bool report
+) noexcept
+{
+    TypeArgs bindings;
+    for (const Token* parm: generic->type_parms)
+        bindings[parm->to_string()] = {};
+
+    for (size_t i = 0; i < call->args.size() && i < generic->parms.size(); i++) {
+        auto* arg = call->args[i];
+        auto arg_type = type_of(arg);
+        if (!arg_type || unify(generic->parms[i]->type, arg_type, bindings))
+            continue;
+
+        if (report) {
+            m_diags.report<Level::ERROR>(
+                arg->loc,
+                std::format(
+                    "in function call to '{}': argument #{} of type '{}' conflicts "
+                    "with the type parameters inferred from previous arguments",
+                    generic->name->to_string(),
+                    i,
+                    dump_type(arg_type)
+                )
+            );
+        }
+        return false;
+    }
+
+    for (const Token* parm: generic->type_parms) {
+        auto type = bindings[parm->to_string()];
+        if (!type) {
+            if (report) {
+                m_diags.report<Level::ERROR>(
+                    call->loc,
+                    std::format(
+                        "in function call to '{}': cannot infer type parameter '{}'",
+                        generic->name->to_string(),
+                        parm->to_string()
+                    ),
+                    Footnote(
+                        FootnoteKind::HINT,
+                        std::format(
+                            "'{}' must appear in the type of a parameter",
+                            parm->to_string()
+                        )
+                    )
+                );
+            }
+            return false;
+        }
+        args.push_back(type);
+    }
+    return true;
+}
+
+// Binds the type parameters in `parm` to the matching parts of `arg`. Returns
+// false if a parameter is already bound to a different type; any other mismatch
+// is left to the argument type check.
+bool via::IRBuilder::unify(
+    const ast::Type* parm,
+    QualType arg,
+    TypeArgs& bindings
+) noexcept
+{
+    if (parm == nullptr || !arg)
+        return true;
+
+    if TRY_COERCE (const ast::TypeSymbol, symbol, parm) {
+        auto it = bindings.find(symbol->symbol->to_string());
+        if (it == bindings.end())
+            return true;
+        if (!it->second)
+            it->second = arg;
+        return it->second == arg;
+    } else if TRY_COERCE (const ast::TypeArray, array, parm) {
+        if TRY_COERCE (const ArrayType, array_type, arg.unwrap())
+            return unify(array->type, array_type->unwrap(), bindings);
+    } else if TRY_COERCE (const ast::TypeMap, map, parm) {
+        if TRY_COERCE (const MapType, map_type, arg.unwrap())
+            return unify(map->key, map_type->key(), bindings) &&
+                   unify(map->value, map_type->value(), bindings);
+    } else if TRY_COERCE (const ast::TypeFunc, func, parm) {
+        if TRY_COERCE (const FunctionType, func_type, arg.unwrap()) {
+            auto parms = func_type->parameters();
+            for (size_t i = 0; i < func->parms.size() && i < parms.size(); i++) {
+                if (!unify(func->parms[i]->type, parms[i], bindings))
+                    return false;
+            }
+            return unify(func->ret, func_type->returns(), bindings);
+        }
+    }
+    return true;
+}
+
+// Signature of `generic` instantiated with `args`. Signatures are cached in the
+// type context, so each is only computed once per type argument tuple.
+const via::FunctionType* via::IRBuilder::instance_type(
+    const ast::StmtFunctionDecl* generic,
+    const std::vector<QualType>& args
+) noexcept
+{
+    if (auto* type = m_type_ctx.get_instance(generic, args))
+        return type;
+
+    GenericScope scope{generic, 0, {}};
+    for (size_t i = 0; const Token* parm: generic->type_parms)
+        scope.type_args[parm->to_string()] = args[i++];
+
+    m_generic_scopes.push_back(std::move(scope));
+
+    std::vector<QualType> parms;
+    for (const auto& parm: generic->parms)
+        parms.push_back(type_of(parm->type));
+
+    QualType ret = generic->ret ? type_of(generic->ret) : nullptr;
+    m_generic_scopes.pop_back();
+
+    if (!ret || std::ranges::any_of(parms, [](QualType type) { return !type; }))
+        return nullptr;
+
+    auto* type = FunctionType::instance(m_type_ctx, ret, std::move(parms));
+    m_type_ctx.add_instance(generic, args, type);
+    return type;
+}
+
+// Returns the instance of `generic` for `args` visible in the current frame,
+// lowering it into the outermost block of the frame on first use. Frames cannot
+// see each other's locals, so each frame calling an instance declares its own.
+const via::ir::StmtFuncDecl* via::IRBuilder::instantiate(
+    const ast::StmtFunctionDecl* generic,
+    const std::vector<QualType>& args,
+    const ast::ExprCall* call
+) noexcept
+{
+    auto symbol = intern_symbol(
+        generic->name->to_string() +
+        via::to_string(args, [](const auto& type) { return type.to_string(); }, "<", ">")
+    );
+
+    // Frames cannot see each other's locals, each one declares its own instance
+    auto& instances = m_instances[m_frame_block];
+    if (auto it = instances.find(symbol); it != instances.end())
+        return it->second;
+
+    for (const auto& scope: m_generic_scopes) {
+        if (scope.generic == generic) {
+            m_diags.report<Level::ERROR>(
+                call->loc,
+                std::format(
+                    "generic function '{}' cannot be instantiated recursively",
+                    generic->name->to_string()
+                )
+            );
+            return nullptr;
+        }
+    }
+
+    GenericScope scope{generic, symbol, {}};
+    for (size_t i = 0; const Token* parm: generic->type_parms)
+        scope.type_args[parm->to_string()] = args[i++];
+
+    m_generic_scopes.push_back(std::move(scope));
+    auto* decl = dynamic_cast<const ir::StmtFuncDecl*>(
+        detail::ast_lower_stmt<ast::StmtFunctionDecl>(*this, generic)
+    );
+    m_generic_scopes.pop_back();
+
+    if (decl != nullptr) {
+        m_frame_block->stmts.insert(m_frame_block->stmts.begin(), decl);
+        instances[symbol] = decl;
+    }
+    return decl;
+}
+
 const via::ir::Stmt* via::IRBuilder::lower_stmt(const ast::Stmt* stmt)
 {
 #define VISIT_STMT(TYPE)                                                                 \
@@ -1199,6 +1779,7 @@ via::IRTree via::IRBuilder::build()
 {
     m_stack.push({});        // Push root stack frame
     new_block(m_block_id++); // Push block
+    m_frame_block = m_current_block;
 
     IRTree tree;
 
@@ -1212,6 +1793,10 @@ via::IRTree via::IRBuilder::build()
         }
     }
 
+    // Lowering a deferred body may reference more functions
+    for (size_t i = 0; i < m_referenced.size(); i++)
+        lower_deferred(*m_referenced[i]);
+
     // Push last block (it likely will not have a terminator)
     tree.push_back(end_block());
     return tree;
@@ -10,13 +10,18 @@
 #pragma once
 
 #include <cstddef>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 #include <via/config.hpp>
 #include "ast/ast.hpp"
+#include "ir/comptime.hpp"
 #include "module/manager.hpp"
 #include "module/module.hpp"
 #include "module/symbol.hpp"
+#include "parser/parser.hpp"
 #include "sema/local_ir.hpp"
 #include "sema/types.hpp"
 #include "support/traits.hpp"
@@ -69,12 +74,33 @@ class IRBuilder final
           m_alloc(module->allocator()),
           m_diags(diags),
           m_type_ctx(module->manager().type_context()),
-          m_symbol_table(module->manager().symbol_table())
+          m_symbol_table(module->manager().symbol_table()),
+          m_comptime(module, diags)
     {}
 
   public:
     IRTree build();
 
+  private:
+    using TypeArgs = std::unordered_map<std::string, QualType>;
+
+    // Generic function instance whose signature or body is being lowered
+    struct GenericScope
+    {
+        const ast::StmtFunctionDecl* generic;
+        SymbolId symbol;
+        TypeArgs type_args;
+    };
+
+    // Function whose body was skipped by a lazy parse
+    struct DeferredBody
+    {
+        ir::StmtFuncDecl* decl;
+        const ast::StmtFunctionDecl* ast_decl;
+        ir::StmtBlock* block; // Block the function was declared in
+        bool referenced = false;
+    };
+
   protected:
     // clang-format off
     void poison_symbol(SymbolId symbol) noexcept { m_poisoned_ids.insert(symbol); }
@@ -95,6 +121,31 @@ class IRBuilder final
     ir::StmtBlock* new_block(size_t id) noexcept;
     std::string dump_type(QualType type) noexcept;
     std::string dump_expr(const ast::Expr* expr) noexcept;
+    void report_unknown_attribute(const ast::Attribute& attr) noexcept;
+    const ir::Expr*
+    fold_comptime_call(const ir::ExprCall* call, const ir::StmtFuncDecl* fn) noexcept;
+
+    void lower_body(ir::StmtFuncDecl* decl, const ast::Scope* body) noexcept;
+    void reference(const ir::StmtFuncDecl* fn) noexcept;
+    void lower_deferred(DeferredBody& deferred) noexcept;
+
+    const ast::StmtFunctionDecl* find_generic(const ast::Expr* callee) noexcept;
+    bool infer_type_args(
+        const ast::StmtFunctionDecl* generic,
+        const ast::ExprCall* call,
+        std::vector<QualType>& args,
+        bool report
+    ) noexcept;
+    bool unify(const ast::Type* parm, QualType arg, TypeArgs& bindings) noexcept;
+    const FunctionType* instance_type(
+        const ast::StmtFunctionDecl* generic,
+        const std::vector<QualType>& args
+    ) noexcept;
+    const ir::StmtFuncDecl* instantiate(
+        const ast::StmtFunctionDecl* generic,
+        const std::vector<QualType>& args,
+        const ast::ExprCall* call
+    ) noexcept;
 
     // clang-format off
     SymbolId intern_symbol(std::string symbol) noexcept { return m_symbol_table.intern(symbol); }
@@ -113,7 +164,20 @@ class IRBuilder final
     bool m_should_push_block;
     uint32_t m_block_id = 0;
     ir::StmtBlock* m_current_block;
+    ir::StmtBlock* m_frame_block; // Outermost block of the frame being lowered
     std::unordered_set<SymbolId> m_poisoned_ids;
+    ComptimeEngine m_comptime;
+    std::unordered_map<SymbolId, const ast::StmtFunctionDecl*> m_generics;
+    std::vector<GenericScope> m_generic_scopes;
+
+    // Instances declared by each frame, keyed by the frame's outermost block
+    std::unordered_map<
+        const ir::StmtBlock*,
+        std::unordered_map<SymbolId, const ir::StmtFuncDecl*>>
+        m_instances;
+    std::unordered_map<const ir::StmtFuncDecl*, DeferredBody> m_deferred;
+    std::vector<DeferredBody*> m_referenced; // Deferred bodies to lower, in order
+    std::optional<Parser> m_parser;          // Parses deferred bodies
 };
 
 } // namespace via
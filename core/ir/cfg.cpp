@@ -0,0 +1,279 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "cfg.hpp"
+#include <algorithm>
+#include "debug.hpp"
+#include "rewrite.hpp"
+
+via::ir::ControlFlowGraph::ControlFlowGraph(
+    ScopedAllocator& alloc,
+    uint32_t& next_id,
+    const IRTree& region
+)
+    : m_alloc(alloc),
+      m_next_id(next_id)
+{
+    for (const Stmt* stmt: region) {
+        if TRY_COERCE (const StmtBlock, block, stmt) {
+            split(as_mutable(block));
+            collect(as_mutable(block));
+        }
+    }
+
+    link();
+    compute_dominators();
+    compute_frontiers();
+}
+
+bool via::ir::ControlFlowGraph::dominates(size_t a, size_t b) const noexcept
+{
+    if (!is_reachable(a) || !is_reachable(b))
+        return false;
+
+    for (size_t id = b; id != NONE; id = m_idom[id]) {
+        if (id == a)
+            return true;
+    }
+    return false;
+}
+
+size_t via::ir::ControlFlowGraph::head_size(size_t id) const noexcept
+{
+    auto& stmts = m_blocks[id]->stmts;
+    auto it = std::find_if(stmts.begin(), stmts.end(), [](const Stmt* stmt) {
+        return TRY_IS(const StmtBlock, stmt);
+    });
+    return static_cast<size_t>(it - stmts.begin());
+}
+
+// Statements that follow a nested block are moved into a block of their own, and
+// the terminator is moved to the last of those. Lowering is unaffected since
+// blocks are emitted in place.
+void via::ir::ControlFlowGraph::split(StmtBlock* block)
+{
+    std::vector<const Stmt*> stmts;
+    StmtBlock* run = nullptr;
+    bool nested = false;
+
+    auto new_run = [&](SourceLoc loc) {
+        run = m_alloc.emplace<StmtBlock>();
+        run->id = m_next_id++;
+        run->loc = loc;
+        stmts.push_back(run);
+    };
+
+    for (const Stmt* stmt: block->stmts) {
+        if TRY_COERCE (const StmtBlock, child, stmt) {
+            split(as_mutable(child));
+            stmts.push_back(child);
+            nested = true;
+            run = nullptr;
+        } else if (!nested) {
+            stmts.push_back(stmt);
+        } else {
+            if (run == nullptr)
+                new_run(stmt->loc);
+            run->stmts.push_back(stmt);
+        }
+    }
+
+    if (nested && block->term != nullptr) {
+        if (run == nullptr)
+            new_run(block->term->loc);
+        run->term = block->term;
+        block->term = nullptr;
+    }
+
+    block->stmts = std::move(stmts);
+}
+
+void via::ir::ControlFlowGraph::collect(StmtBlock* block)
+{
+    m_index[block] = m_blocks.size();
+    m_blocks.push_back(block);
+
+    for (const Stmt* stmt: block->stmts) {
+        if TRY_COERCE (const StmtBlock, child, stmt)
+            collect(as_mutable(child));
+    }
+}
+
+void via::ir::ControlFlowGraph::link() noexcept
+{
+    m_preds.assign(m_blocks.size(), {});
+    m_succs.assign(m_blocks.size(), {});
+
+    auto add_edge = [&](size_t from, const StmtBlock* to) {
+        auto it = m_index.find(to);
+        debug::require(it != m_index.end(), "branch target outside of region");
+
+        auto& succs = m_succs[from];
+        if (std::find(succs.begin(), succs.end(), it->second) == succs.end()) {
+            succs.push_back(it->second);
+            m_preds[it->second].push_back(from);
+        }
+    };
+
+    for (size_t id = 0; id < m_blocks.size(); id++) {
+        const Term* term = m_blocks[id]->term;
+
+        if (term == nullptr) {
+            // Falls through to the next block in layout order
+            if (id + 1 < m_blocks.size())
+                add_edge(id, m_blocks[id + 1]);
+        } else if TRY_COERCE (const TrBranch, br, term) {
+            add_edge(id, br->target);
+        } else if TRY_COERCE (const TrCondBranch, cond_br, term) {
+            add_edge(id, cond_br->iftrue);
+            add_edge(id, cond_br->iffalse);
+        } else if TRY_COERCE (const TrForPrep, prep, term) {
+            add_edge(id, prep->body);
+            add_edge(id, prep->exit);
+        } else if TRY_COERCE (const TrForLoop, loop, term) {
+            add_edge(id, loop->prep->body);
+            add_edge(id, loop->prep->exit);
+        }
+    }
+}
+
+// Cooper, Harvey & Kennedy, "A Simple, Fast Dominance Algorithm"
+void via::ir::ControlFlowGraph::compute_dominators() noexcept
+{
+    size_t size = m_blocks.size();
+    m_idom.assign(size, NONE);
+    m_rpo_index.assign(size, NONE);
+    m_children.assign(size, {});
+    m_rpo.clear();
+
+    if (size == 0)
+        return;
+
+    std::vector<bool> visited(size, false);
+    std::vector<std::pair<size_t, size_t>> stack{{0, 0}};
+    visited[0] = true;
+
+    while (!stack.empty()) {
+        auto& [id, next] = stack.back();
+        if (next < m_succs[id].size()) {
+            size_t succ = m_succs[id][next++];
+            if (!visited[succ]) {
+                visited[succ] = true;
+                stack.emplace_back(succ, 0);
+            }
+        } else {
+            m_rpo.push_back(id);
+            stack.pop_back();
+        }
+    }
+
+    std::reverse(m_rpo.begin(), m_rpo.end());
+    for (size_t i = 0; i < m_rpo.size(); i++)
+        m_rpo_index[m_rpo[i]] = i;
+
+    auto intersect = [&](size_t a, size_t b) {
+        while (a != b) {
+            while (m_rpo_index[a] > m_rpo_index[b])
+                a = m_idom[a];
+            while (m_rpo_index[b] > m_rpo_index[a])
+                b = m_idom[b];
+        }
+        return a;
+    };
+
+    m_idom[0] = 0;
+
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t id: m_rpo) {
+            if (id == 0)
+                continue;
+
+            size_t new_idom = NONE;
+            for (size_t pred: m_preds[id]) {
+                if (m_idom[pred] == NONE)
+                    continue;
+                new_idom = (new_idom == NONE) ? pred : intersect(pred, new_idom);
+            }
+
+            if (new_idom != m_idom[id]) {
+                m_idom[id] = new_idom;
+                changed = true;
+            }
+        }
+    }
+
+    m_idom[0] = NONE;
+    for (size_t id: m_rpo) {
+        if (m_idom[id] != NONE)
+            m_children[m_idom[id]].push_back(id);
+    }
+}
+
+void via::ir::ControlFlowGraph::compute_frontiers() noexcept
+{
+    m_frontier.assign(m_blocks.size(), {});
+
+    for (size_t id: m_rpo) {
+        if (m_preds[id].size() < 2)
+            continue;
+
+        for (size_t pred: m_preds[id]) {
+            if (!is_reachable(pred))
+                continue;
+
+            for (size_t runner = pred; runner != m_idom[id]; runner = m_idom[runner]) {
+                auto& frontier = m_frontier[runner];
+                if (std::find(frontier.begin(), frontier.end(), id) == frontier.end())
+                    frontier.push_back(id);
+            }
+        }
+    }
+}
+
+static void max_block_id(const via::ir::Stmt* stmt, uint32_t& max) noexcept
+{
+    if TRY_COERCE (const via::ir::StmtBlock, block, stmt) {
+        max = std::max(max, block->id);
+        for (const via::ir::Stmt* child: block->stmts)
+            max_block_id(child, max);
+    } else if TRY_COERCE (const via::ir::StmtFuncDecl, func_decl, stmt) {
+        max_block_id(func_decl->body, max);
+    }
+}
+
+uint32_t via::ir::next_block_id(const IRTree& tree) noexcept
+{
+    uint32_t max = 0;
+    for (const Stmt* stmt: tree)
+        max_block_id(stmt, max);
+    return max + 1;
+}
+
+static void
+collect_functions(const via::ir::Stmt* stmt, std::vector<via::IRTree>& regions)
+{
+    if TRY_COERCE (const via::ir::StmtBlock, block, stmt) {
+        for (const via::ir::Stmt* child: block->stmts)
+            collect_functions(child, regions);
+    } else if TRY_COERCE (const via::ir::StmtFuncDecl, func_decl, stmt) {
+        if (func_decl->body != nullptr) {
+            regions.push_back({func_decl->body});
+            collect_functions(func_decl->body, regions);
+        }
+    }
+}
+
+std::vector<via::IRTree> via::ir::get_regions(const IRTree& tree) noexcept
+{
+    std::vector<IRTree> regions{tree};
+    for (const Stmt* stmt: tree)
+        collect_functions(stmt, regions);
+    return regions;
+}
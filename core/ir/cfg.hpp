@@ -0,0 +1,83 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+#include <via/config.hpp>
+#include "ir.hpp"
+#include "support/memory.hpp"
+
+namespace via {
+namespace ir {
+
+// Control flow graph of a single region (the top level of a module or a function
+// body). Nodes are indexed in layout order, index 0 being the entry block.
+class ControlFlowGraph final
+{
+  public:
+    static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+  public:
+    // Splits the blocks of `region` so that every block holds one run of
+    // straight-line statements followed by its nested blocks, then builds the
+    // graph. Fresh block ids are taken from `next_id`.
+    ControlFlowGraph(ScopedAllocator& alloc, uint32_t& next_id, const IRTree& region);
+
+  public:
+    size_t size() const noexcept { return m_blocks.size(); }
+    size_t index_of(const StmtBlock* block) const { return m_index.at(block); }
+    StmtBlock* block(size_t id) const noexcept { return m_blocks[id]; }
+
+    auto& preds(size_t id) const noexcept { return m_preds[id]; }
+    auto& succs(size_t id) const noexcept { return m_succs[id]; }
+    auto& frontier(size_t id) const noexcept { return m_frontier[id]; }
+    auto& children(size_t id) const noexcept { return m_children[id]; }
+    auto& reverse_postorder() const noexcept { return m_rpo; }
+
+    // Immediate dominator, or NONE for the entry block and unreachable blocks
+    size_t idom(size_t id) const noexcept { return m_idom[id]; }
+    bool is_reachable(size_t id) const noexcept { return m_rpo_index[id] != NONE; }
+    bool dominates(size_t a, size_t b) const noexcept;
+
+    // Number of leading straight-line statements of a block
+    size_t head_size(size_t id) const noexcept;
+
+  private:
+    void split(StmtBlock* block);
+    void collect(StmtBlock* block);
+    void link() noexcept;
+    void compute_dominators() noexcept;
+    void compute_frontiers() noexcept;
+
+  private:
+    ScopedAllocator& m_alloc;
+    uint32_t& m_next_id;
+
+    std::vector<StmtBlock*> m_blocks;
+    std::unordered_map<const StmtBlock*, size_t> m_index;
+    std::vector<std::vector<size_t>> m_preds, m_succs;
+    std::vector<std::vector<size_t>> m_frontier, m_children;
+    std::vector<size_t> m_idom, m_rpo, m_rpo_index;
+};
+
+// Returns one past the greatest block id used in `tree`, including function
+// bodies.
+uint32_t next_block_id(const IRTree& tree) noexcept;
+
+// Returns the regions of `tree`: its top level followed by the body of every
+// function declared in it, nested ones included.
+std::vector<IRTree> get_regions(const IRTree& tree) noexcept;
+
+} // namespace ir
+} // namespace via
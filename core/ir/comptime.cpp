@@ -0,0 +1,271 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "comptime.hpp"
+#include <format>
+#include <unordered_set>
+#include <variant>
+#include "ast/ast.hpp"
+#include "debug.hpp"
+#include "module/manager.hpp"
+#include "module/module.hpp"
+#include "rewrite.hpp"
+#include "support/math.hpp"
+#include "support/traits.hpp"
+#include "vm/executable.hpp"
+#include "vm/machine.hpp"
+#include "vm/value.hpp"
+
+namespace ir = via::ir;
+
+using SymbolSet = std::unordered_set<via::SymbolId>;
+using Reason = std::optional<std::string>;
+
+static Reason check_stmt(const ir::Stmt* stmt, SymbolSet& bound);
+
+// Only nodes with a known pure lowering may run inside the sandbox
+static Reason check_expr(const ir::Expr* expr, const SymbolSet& bound)
+{
+    if (expr == nullptr || TRY_IS(const ir::ExprConstant, expr))
+        return std::nullopt;
+
+    if TRY_COERCE (const ir::ExprSymbol, symbol, expr) {
+        if (bound.contains(symbol->symbol))
+            return std::nullopt;
+        return "expression references a runtime value";
+    }
+
+    if (!TRY_IS(const ir::ExprBinary, expr) && !TRY_IS(const ir::ExprCast, expr) &&
+        !TRY_IS(const ir::ExprCall, expr) && !TRY_IS(const ir::ExprInline, expr)) {
+        return std::format(
+            "'{}' cannot be evaluated at compile time",
+            VIA_TYPENAME(*expr)
+        );
+    }
+
+    if TRY_COERCE (const ir::ExprInline, inl, expr) {
+        SymbolSet callee_bound;
+        if (auto reason = check_stmt(inl->callee, callee_bound))
+            return reason;
+    }
+
+    Reason reason;
+    ir::for_each_operand(expr, [&](const ir::Expr* child) {
+        if (!reason.has_value())
+            reason = check_expr(child, bound);
+    });
+    return reason;
+}
+
+static Reason check_term(const ir::Term* term, const SymbolSet& bound)
+{
+    if (term == nullptr || TRY_IS(const ir::TrBranch, term))
+        return std::nullopt;
+    if TRY_COERCE (const ir::TrReturn, ret, term)
+        return check_expr(ret->val, bound);
+    if TRY_COERCE (const ir::TrCondBranch, cond_br, term)
+        return check_expr(cond_br->cnd, bound);
+
+    return std::format("'{}' cannot be evaluated at compile time", VIA_TYPENAME(*term));
+}
+
+static Reason check_stmt(const ir::Stmt* stmt, SymbolSet& bound)
+{
+    if (stmt == nullptr || TRY_IS(const ir::StmtInstruction, stmt))
+        return std::nullopt;
+
+    if TRY_COERCE (const ir::StmtVarDecl, var_decl, stmt) {
+        auto reason = check_expr(var_decl->expr, bound);
+        bound.insert(var_decl->symbol);
+        return reason;
+    }
+
+    if TRY_COERCE (const ir::StmtExpr, expr_stmt, stmt)
+        return check_expr(expr_stmt->expr, bound);
+
+    if TRY_COERCE (const ir::StmtBlock, block, stmt) {
+        for (const ir::Stmt* child: block->stmts) {
+            if (auto reason = check_stmt(child, bound))
+                return reason;
+        }
+        return check_term(block->term, bound);
+    }
+
+    if TRY_COERCE (const ir::StmtFuncDecl, func_decl, stmt) {
+        if (func_decl->kind != via::ImplKind::SOURCE)
+            return "native functions cannot be called at compile time";
+        if (func_decl->body == nullptr)
+            return "function body is not lowered yet";
+
+        bound.insert(func_decl->symbol);
+
+        SymbolSet body_bound = bound;
+        for (const auto& parm: func_decl->parms)
+            body_bound.insert(parm.symbol);
+        return check_stmt(func_decl->body, body_bound);
+    }
+
+    return std::format("'{}' cannot be evaluated at compile time", VIA_TYPENAME(*stmt));
+}
+
+// Bytecode-level backstop for the IR checks above
+static bool is_sandbox_safe(via::OpCode op) noexcept
+{
+    using enum via::OpCode;
+
+    switch (op) {
+    case EXTRAARG:
+    case NEWSTR:
+    case NEWARR:
+    case NEWDICT:
+    case NEWTUPLE:
+    case GETARGREF:
+    case SETARG:
+    case PCALL:
+    case GETIMPORT:
+        return false;
+    default:
+        return true;
+    }
+}
+
+static std::expected<via::ConstValue, std::string> to_const_value(const via::Value* val)
+{
+    switch (val->kind()) {
+    case via::ValueKind::NIL:
+        return via::ConstValue();
+    case via::ValueKind::INT:
+        return via::ConstValue(static_cast<int64_t>(val->int_value()));
+    case via::ValueKind::FLOAT:
+        return via::ConstValue(static_cast<double_t>(val->float_value()));
+    case via::ValueKind::BOOL:
+        return via::ConstValue(val->bool_value());
+    case via::ValueKind::STRING:
+        return via::ConstValue(std::string(val->string_value()));
+    default:
+        break;
+    }
+
+    return std::unexpected(
+        std::format(
+            "value of kind {} is not a compile-time constant",
+            to_string(val->kind())
+        )
+    );
+}
+
+bool via::ComptimeEngine::CacheKey::operator==(const CacheKey& other) const
+{
+    if (fn != other.fn || args.size() != other.args.size())
+        return false;
+
+    for (size_t i = 0; i < args.size(); i++) {
+        if (!args[i].compare(other.args[i]))
+            return false;
+    }
+    return true;
+}
+
+size_t via::ComptimeEngine::CacheKeyHash::operator()(const CacheKey& key) const noexcept
+{
+    return hash_range(key.args.begin(), key.args.end(), [](const ConstValue& cv) {
+        return std::hash<ConstValue::Union>{}(cv.data());
+    }) ^ hash_ptr(key.fn);
+}
+
+std::expected<via::ConstValue, std::string>
+via::ComptimeEngine::execute(IRTree&& program)
+{
+    auto* exe = Executable::build_from_ir(m_module, m_diags, program);
+
+    for (const Instruction& insn: exe->bytecode()) {
+        if (!is_sandbox_safe(insn.op)) {
+            return std::unexpected(
+                std::format(
+                    "instruction {} is not allowed at compile time",
+                    to_string(insn.op)
+                )
+            );
+        }
+    }
+
+    VirtualMachine vm(m_module, exe);
+    if (!vm.execute_bounded(config::COMPTIME_STEP_BUDGET)) {
+        return std::unexpected(
+            std::format(
+                "evaluation did not finish within {} instructions",
+                config::COMPTIME_STEP_BUDGET
+            )
+        );
+    }
+
+    auto& stack = vm.get_stack();
+    debug::require(!stack.empty(), "compile-time program produced no result");
+    return to_const_value(reinterpret_cast<const Value*>(stack.top()));
+}
+
+std::expected<via::ConstValue, std::string>
+via::ComptimeEngine::evaluate(const ir::Expr* expr)
+{
+    if (auto reason = check_expr(expr, {}))
+        return std::unexpected(*reason);
+
+    auto& alloc = m_module->allocator();
+    auto& symtab = m_module->manager().symbol_table();
+
+    // The result is left on top of the stack as the program's only local
+    auto* result = alloc.emplace<ir::StmtVarDecl>();
+    result->symbol = symtab.intern("<comptime>");
+    result->expr = expr;
+    result->type = expr->type;
+    result->loc = expr->loc;
+    return execute({result});
+}
+
+std::expected<via::ConstValue, std::string>
+via::ComptimeEngine::call(const ir::StmtFuncDecl* fn, const std::vector<ConstValue>& args)
+{
+    CacheKey key{fn, args};
+    if (auto it = m_cache.find(key); it != m_cache.end())
+        return it->second;
+
+    SymbolSet bound;
+    if (auto reason = check_stmt(fn, bound))
+        return std::unexpected(*reason);
+
+    auto& alloc = m_module->allocator();
+    auto& symtab = m_module->manager().symbol_table();
+
+    auto* callee = alloc.emplace<ir::ExprSymbol>();
+    callee->symbol = fn->symbol;
+    callee->loc = fn->loc;
+
+    auto* call_expr = alloc.emplace<ir::ExprCall>();
+    call_expr->callee = callee;
+    call_expr->type = fn->ret;
+    call_expr->loc = fn->loc;
+
+    for (const auto& arg: args) {
+        auto* arg_expr = alloc.emplace<ir::ExprConstant>();
+        arg_expr->value = arg;
+        arg_expr->loc = fn->loc;
+        call_expr->args.push_back(arg_expr);
+    }
+
+    auto* result = alloc.emplace<ir::StmtVarDecl>();
+    result->symbol = symtab.intern("<comptime>");
+    result->expr = call_expr;
+    result->type = fn->ret;
+    result->loc = fn->loc;
+
+    auto value = execute({fn, result});
+    if (value.has_value())
+        m_cache.emplace(std::move(key), *value);
+    return value;
+}
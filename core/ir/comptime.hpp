@@ -0,0 +1,71 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <cstddef>
+#include <expected>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <via/config.hpp>
+#include "diagnostics.hpp"
+#include "ir.hpp"
+#include "sema/const.hpp"
+
+namespace via {
+namespace config {
+
+// Maximum number of instructions a single compile-time evaluation may execute
+VIA_CONSTANT size_t COMPTIME_STEP_BUDGET = 1'000'000;
+
+} // namespace config
+
+class Module;
+class ComptimeEngine final
+{
+  public:
+    ComptimeEngine(Module* module, DiagContext& diags)
+        : m_module(module),
+          m_diags(diags)
+    {}
+
+  public:
+    // Evaluates a constant expression in a sandboxed virtual machine
+    std::expected<ConstValue, std::string> evaluate(const ir::Expr* expr);
+
+    // Evaluates a call to `fn` with constant arguments. Results are cached by
+    // (function, arguments) so repeated calls are only executed once.
+    std::expected<ConstValue, std::string>
+    call(const ir::StmtFuncDecl* fn, const std::vector<ConstValue>& args);
+
+  private:
+    struct CacheKey
+    {
+        const ir::StmtFuncDecl* fn;
+        std::vector<ConstValue> args;
+
+        bool operator==(const CacheKey& other) const;
+    };
+
+    struct CacheKeyHash
+    {
+        size_t operator()(const CacheKey& key) const noexcept;
+    };
+
+  private:
+    std::expected<ConstValue, std::string> execute(IRTree&& program);
+
+  private:
+    Module* m_module;
+    DiagContext& m_diags;
+    std::unordered_map<CacheKey, ConstValue, CacheKeyHash> m_cache;
+};
+
+} // namespace via
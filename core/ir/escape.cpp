@@ -0,0 +1,86 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "escape.hpp"
+#include "cfg.hpp"
+#include "rewrite.hpp"
+#include "sema/types.hpp"
+
+namespace ir = via::ir;
+
+// Scalars are copied by value wherever they are stored, so the Value holding
+// one never needs to outlive the instruction reading it
+static bool is_scalar(via::QualType type) noexcept
+{
+    if (!type || type.is_reference())
+        return false;
+
+    auto* builtin = dynamic_cast<const via::BuiltinType*>(type.unwrap());
+    return builtin != nullptr && builtin->is_one_of<
+                                     via::BuiltinKind::NIL,
+                                     via::BuiltinKind::BOOL,
+                                     via::BuiltinKind::INT,
+                                     via::BuiltinKind::FLOAT>();
+}
+
+size_t via::EscapeAnalysis::run(IRTree& ir_tree) noexcept
+{
+    for (const auto& region: ir::get_regions(ir_tree)) {
+        for (const ir::Stmt* stmt: region)
+            visit_stmt(stmt);
+    }
+
+    return m_marked;
+}
+
+void via::EscapeAnalysis::visit_stmt(const ir::Stmt* stmt) noexcept
+{
+    // Function bodies are regions of their own
+    if (TRY_IS(const ir::StmtFuncDecl, stmt))
+        return;
+
+    if TRY_COERCE (const ir::StmtBlock, block, stmt) {
+        for (const ir::Stmt* child: block->stmts)
+            visit_stmt(child);
+
+        if TRY_COERCE (const ir::TrCondBranch, branch, block->term) {
+            visit_expr(branch->cnd, true);
+            return;
+        }
+    }
+
+    ir::for_each_operand(stmt, [&](const ir::Expr*& expr) { visit_expr(expr, false); });
+}
+
+// `transient` is set when the consumer of `expr` only reads it, as opposed to
+// storing, pushing or returning it.
+void via::EscapeAnalysis::visit_expr(const ir::Expr* expr, bool transient) noexcept
+{
+    if (expr == nullptr)
+        return;
+
+    if (transient && is_scalar(expr->type)) {
+        ir::as_mutable(expr)->escapes = false;
+        m_marked++;
+    }
+
+    if TRY_COERCE (const ir::ExprBinary, binary, expr) {
+        visit_expr(binary->lhs, true);
+        visit_expr(binary->rhs, true);
+    } else if TRY_COERCE (const ir::ExprTernary, ternary, expr) {
+        // The taken arm becomes the result itself
+        visit_expr(ternary->cnd, true);
+        visit_expr(ternary->iftrue, false);
+        visit_expr(ternary->iffalse, false);
+    } else {
+        ir::for_each_operand(expr, [&](const ir::Expr*& child) {
+            visit_expr(child, false);
+        });
+    }
+}
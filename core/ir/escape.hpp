@@ -0,0 +1,35 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <cstddef>
+#include <via/config.hpp>
+#include "ir.hpp"
+
+namespace via {
+
+class EscapeAnalysis final
+{
+  public:
+    // Clears `Expr::escapes` on scalar operands that are only read by the
+    // instruction consuming them, so lowering can leave their storage in the
+    // register for the next value instead of releasing it. Returns the number
+    // of expressions marked.
+    size_t run(IRTree& ir_tree) noexcept;
+
+  private:
+    void visit_stmt(const ir::Stmt* stmt) noexcept;
+    void visit_expr(const ir::Expr* expr, bool transient) noexcept;
+
+  private:
+    size_t m_marked = 0;
+};
+
+} // namespace via
@@ -0,0 +1,280 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "gvn.hpp"
+#include <algorithm>
+#include <format>
+#include "debug.hpp"
+#include "module/manager.hpp"
+#include "module/module.hpp"
+#include "rewrite.hpp"
+#include "support/math.hpp"
+
+namespace ir = via::ir;
+
+enum KeyKind : uint32_t
+{
+    CONSTANT,
+    SYMBOL,
+    MODULE,
+    UNARY,
+    BINARY,
+};
+
+static bool is_instruction(const ir::Stmt* stmt, via::OpCode op) noexcept
+{
+    if TRY_COERCE (const ir::StmtInstruction, instr, stmt)
+        return instr->instr.op == op;
+    return false;
+}
+
+static bool is_commutative(via::BinaryOp op) noexcept
+{
+    using enum via::BinaryOp;
+    return op == ADD || op == MUL || op == BAND || op == BOR || op == BXOR;
+}
+
+// Integer division by zero raises, so such a division may only be reused,
+// never computed ahead of where it was written
+static bool may_trap(const ir::Expr* expr) noexcept
+{
+    auto* binary = dynamic_cast<const ir::ExprBinary*>(expr);
+    if (binary == nullptr ||
+        (binary->op != via::BinaryOp::DIV && binary->op != via::BinaryOp::MOD))
+        return false;
+
+    auto* divisor = dynamic_cast<const ir::ExprConstant*>(binary->rhs);
+    return divisor == nullptr || (divisor->value.kind() == via::ValueKind::INT &&
+                                  divisor->value.value<via::ValueKind::INT>() == 0);
+}
+
+size_t via::ValueNumbering::KeyHash::operator()(const Key& key) const noexcept
+{
+    return hash_all(
+        static_cast<size_t>(key.kind),
+        static_cast<size_t>(key.a),
+        static_cast<size_t>(key.b),
+        static_cast<size_t>(key.c)
+    );
+}
+
+size_t via::ValueNumbering::run(IRTree& ir_tree) noexcept
+{
+    m_next_id = ir::next_block_id(ir_tree);
+
+    for (const auto& region: ir::get_regions(ir_tree))
+        number_region(region);
+
+    return m_replaced;
+}
+
+void via::ValueNumbering::number_region(const IRTree& region) noexcept
+{
+    ir::ControlFlowGraph cfg(m_module->allocator(), m_next_id, region);
+    if (cfg.size() == 0)
+        return;
+
+    // Blocks are laid out in execution order, so scopes nest correctly
+    Scopes open;
+    m_block_scopes.assign(cfg.size(), {});
+
+    for (size_t id = 0; id < cfg.size(); id++) {
+        m_block_scopes[id] = open;
+        for (const ir::Stmt* stmt: cfg.block(id)->stmts) {
+            if (is_instruction(stmt, OpCode::SAVE)) {
+                open.push_back(stmt);
+            } else if (is_instruction(stmt, OpCode::RESTORE)) {
+                debug::require(!open.empty(), "unbalanced RESTORE instruction");
+                open.pop_back();
+            }
+        }
+    }
+
+    m_defs.clear();
+    m_available.clear();
+    m_undo.clear();
+
+    visit_block(cfg, 0);
+    materialize();
+}
+
+// Walks the dominator tree, so every def in `m_available` is computed on all
+// paths reaching the statement being visited.
+void via::ValueNumbering::visit_block(const ir::ControlFlowGraph& cfg, size_t id) noexcept
+{
+    size_t mark = m_undo.size();
+
+    m_block = cfg.block(id);
+    m_scopes = m_block_scopes[id];
+
+    for (const ir::Stmt* stmt: m_block->stmts) {
+        m_stmt = stmt;
+
+        if (is_instruction(stmt, OpCode::SAVE)) {
+            m_scopes.push_back(stmt);
+        } else if (is_instruction(stmt, OpCode::RESTORE)) {
+            m_scopes.pop_back();
+        } else if (!TRY_IS(const ir::StmtBlock, stmt)) {
+            ir::for_each_operand(stmt, [&](const ir::Expr*& expr) {
+                visit_expr(expr, false);
+            });
+        }
+    }
+
+    if (m_block->term != nullptr) {
+        m_stmt = nullptr;
+        ir::for_each_operand(m_block->term, [&](const ir::Expr*& expr) {
+            visit_expr(expr, false);
+        });
+    }
+
+    for (size_t child: cfg.children(id))
+        visit_block(cfg, child);
+
+    while (m_undo.size() > mark) {
+        auto [number, previous] = m_undo.back();
+        m_undo.pop_back();
+
+        if (previous.has_value())
+            m_available[number] = *previous;
+        else
+            m_available.erase(number);
+    }
+}
+
+// `conditional` is set for operands that do not always run, such as the right
+// side of `and`. They may reuse earlier values but cannot provide new ones.
+void via::ValueNumbering::visit_expr(const ir::Expr*& expr, bool conditional) noexcept
+{
+    if (expr == nullptr)
+        return;
+
+    // Leaves are as cheap to evaluate as the local that would replace them
+    bool compound = TRY_IS(const ir::ExprBinary, expr) ||
+                    TRY_IS(const ir::ExprUnary, expr) ||
+                    TRY_IS(const ir::ExprModuleAccess, expr);
+
+    auto number = compound ? value_number(expr) : std::nullopt;
+
+    std::optional<size_t> previous;
+    if (auto it = number ? m_available.find(*number) : m_available.end();
+        it != m_available.end()) {
+        previous = it->second;
+
+        // Locals declared in a scope that has since been left are gone
+        Def& def = m_defs[it->second];
+        if (def.scopes.size() <= m_scopes.size() &&
+            std::equal(def.scopes.begin(), def.scopes.end(), m_scopes.begin())) {
+            def.uses.push_back(&expr);
+            return;
+        }
+    }
+
+    auto* binary = dynamic_cast<const ir::ExprBinary*>(expr);
+    auto* ternary = dynamic_cast<const ir::ExprTernary*>(expr);
+
+    if (binary && (binary->op == BinaryOp::AND || binary->op == BinaryOp::OR)) {
+        visit_expr(ir::as_mutable(binary)->lhs, conditional);
+        visit_expr(ir::as_mutable(binary)->rhs, true);
+    } else if (ternary != nullptr) {
+        visit_expr(ir::as_mutable(ternary)->cnd, conditional);
+        visit_expr(ir::as_mutable(ternary)->iftrue, true);
+        visit_expr(ir::as_mutable(ternary)->iffalse, true);
+    } else {
+        ir::for_each_operand(expr, [&](const ir::Expr*& child) {
+            visit_expr(child, conditional);
+        });
+    }
+
+    if (!number.has_value() || conditional || may_trap(expr))
+        return;
+
+    m_undo.emplace_back(*number, previous);
+    m_available[*number] = m_defs.size();
+    m_defs.push_back({&expr, m_block, m_stmt, m_scopes, {}});
+}
+
+// Structural value number of `expr`, or nullopt if it is not pure. Locals are
+// never reassigned, so each SSA version of a symbol is a single value.
+std::optional<size_t> via::ValueNumbering::value_number(const ir::Expr* expr) noexcept
+{
+    std::optional<Key> key;
+
+    if TRY_COERCE (const ir::ExprConstant, constant, expr) {
+        const auto& value = constant->value;
+        auto text = std::format("{}:{}", (int) value.kind(), value.to_string());
+        auto [it, _] = m_constants.emplace(std::move(text), m_constants.size());
+        key = Key{CONSTANT, it->second, 0, 0};
+    } else if TRY_COERCE (const ir::ExprSymbol, symbol, expr) {
+        key = Key{SYMBOL, symbol->symbol, symbol->version, 0};
+    } else if TRY_COERCE (const ir::ExprModuleAccess, access, expr) {
+        key = Key{MODULE, access->mod_id, access->key_id, 0};
+    } else if TRY_COERCE (const ir::ExprUnary, unary, expr) {
+        if (auto operand = value_number(unary->expr))
+            key = Key{UNARY, static_cast<uint64_t>(unary->op), *operand, 0};
+    } else if TRY_COERCE (const ir::ExprBinary, binary, expr) {
+        auto lhs = value_number(binary->lhs);
+        auto rhs = value_number(binary->rhs);
+
+        if (lhs.has_value() && rhs.has_value()) {
+            if (is_commutative(binary->op) && *rhs < *lhs)
+                std::swap(lhs, rhs);
+            key = Key{BINARY, static_cast<uint64_t>(binary->op), *lhs, *rhs};
+        }
+    }
+
+    if (!key.has_value())
+        return std::nullopt;
+
+    auto [it, _] = m_numbers.emplace(*key, m_numbers.size());
+    return it->second;
+}
+
+// Every def that is reused is computed into a local just before the statement
+// it appears in, and all of its occurrences read that local instead.
+void via::ValueNumbering::materialize() noexcept
+{
+    auto& alloc = m_module->allocator();
+    auto& symtab = m_module->manager().symbol_table();
+
+    for (auto& def: m_defs) {
+        if (def.uses.empty())
+            continue;
+
+        const ir::Expr* value = *def.slot;
+
+        auto* decl = alloc.emplace<ir::StmtVarDecl>();
+        decl->loc = value->loc;
+        decl->symbol = symtab.intern(std::format("<cse.{}>", m_temps++));
+        decl->version = 1;
+        decl->expr = value;
+        decl->type = value->type;
+
+        auto& stmts = def.block->stmts;
+        auto pos = stmts.end();
+        if (def.stmt != nullptr)
+            pos = std::find(stmts.begin(), stmts.end(), def.stmt);
+        stmts.insert(pos, decl);
+
+        auto read = [&](const ir::Expr** slot) {
+            auto* symbol = alloc.emplace<ir::ExprSymbol>();
+            symbol->loc = (*slot)->loc;
+            symbol->symbol = decl->symbol;
+            symbol->version = decl->version;
+            symbol->type = decl->type;
+            *slot = symbol;
+        };
+
+        read(def.slot);
+        for (const ir::Expr** use: def.uses)
+            read(use);
+
+        m_replaced += def.uses.size();
+    }
+}
@@ -0,0 +1,94 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <via/config.hpp>
+#include "cfg.hpp"
+#include "ir.hpp"
+
+namespace via {
+
+class Module;
+class ValueNumbering final
+{
+  public:
+    ValueNumbering(Module* module)
+        : m_module(module)
+    {}
+
+  public:
+    // Replaces pure expressions computed earlier on every path with a local
+    // holding the earlier result. Expects the tree to be in SSA form. Returns
+    // the number of expressions replaced.
+    size_t run(IRTree& ir_tree) noexcept;
+
+  private:
+    struct Key
+    {
+        uint32_t kind;
+        uint64_t a, b, c;
+
+        bool operator==(const Key&) const noexcept = default;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const noexcept;
+    };
+
+    // First unconditional evaluation of a value, and the slots recomputing it
+    struct Def
+    {
+        const ir::Expr** slot;
+        ir::StmtBlock* block;
+        const ir::Stmt* stmt; // null if the value is computed by the terminator
+        std::vector<const ir::Stmt*> scopes;
+        std::vector<const ir::Expr**> uses;
+    };
+
+    using Scopes = std::vector<const ir::Stmt*>;
+
+  private:
+    void number_region(const IRTree& region) noexcept;
+    void visit_block(const ir::ControlFlowGraph& cfg, size_t id) noexcept;
+    void visit_expr(const ir::Expr*& expr, bool conditional) noexcept;
+    std::optional<size_t> value_number(const ir::Expr* expr) noexcept;
+    void materialize() noexcept;
+
+  private:
+    Module* m_module;
+    uint32_t m_next_id = 0;
+    size_t m_replaced = 0;
+    size_t m_temps = 0;
+
+    std::unordered_map<Key, size_t, KeyHash> m_numbers;
+    std::unordered_map<std::string, size_t> m_constants;
+    std::vector<Def> m_defs;
+
+    // Value number to the def currently providing it. Entries made in a block
+    // are undone once its dominator subtree has been visited.
+    std::unordered_map<size_t, size_t> m_available;
+    std::vector<std::pair<size_t, std::optional<size_t>>> m_undo;
+
+    // SAVE instructions open at the start of each block, and at the statement
+    // being visited
+    std::vector<Scopes> m_block_scopes;
+    Scopes m_scopes;
+    ir::StmtBlock* m_block = nullptr;
+    const ir::Stmt* m_stmt = nullptr;
+};
+
+} // namespace via
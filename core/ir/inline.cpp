@@ -0,0 +1,252 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "inline.hpp"
+#include <format>
+#include <unordered_set>
+#include "ast/ast.hpp"
+#include "debug.hpp"
+#include "module/manager.hpp"
+#include "module/module.hpp"
+#include "rewrite.hpp"
+#include "support/enum.hpp"
+
+// Extra cost charged for call expressions inside a candidate body, since
+// inlining does not remove them.
+static constexpr size_t CALL_COST = 4;
+
+static size_t expr_cost(const via::ir::Expr* expr) noexcept
+{
+    if (expr == nullptr)
+        return 0;
+
+    size_t cost = 1;
+    if TRY_IS (const via::ir::ExprCall, expr)
+        cost += CALL_COST;
+
+    via::ir::for_each_operand(expr, [&](const via::ir::Expr* child) {
+        cost += expr_cost(child);
+    });
+    return cost;
+}
+
+// Returns the first symbol referenced by `expr` that is not in `bound`, or the
+// module of the first member of another module it references.
+static std::optional<via::SymbolId> find_free_symbol(
+    const via::ir::Expr* expr,
+    const std::unordered_set<via::SymbolId>& bound
+)
+{
+    if (expr == nullptr)
+        return std::nullopt;
+
+    if TRY_COERCE (const via::ir::ExprSymbol, symbol, expr) {
+        if (!bound.contains(symbol->symbol))
+            return symbol->symbol;
+        return std::nullopt;
+    }
+
+    // Members of other modules are never bound by the function
+    if TRY_COERCE (const via::ir::ExprModuleAccess, access, expr)
+        return access->mod_id;
+
+    std::optional<via::SymbolId> free;
+    via::ir::for_each_operand(expr, [&](const via::ir::Expr* child) {
+        if (!free.has_value())
+            free = find_free_symbol(child, bound);
+    });
+    return free;
+}
+
+// `imported` is set for functions of other modules, which are looked up through
+// their module rather than by name and were profiled, if at all, on their own.
+std::optional<std::string>
+via::Inliner::check_inlinable(const ir::StmtFuncDecl* fn, bool imported) noexcept
+{
+    auto& symtab = m_module->manager().symbol_table();
+
+    if (fn->kind != ImplKind::SOURCE || fn->body == nullptr)
+        return "function has no source body";
+    if (!imported && m_decl_counts[fn->symbol] != 1)
+        return "function name is declared more than once in this module";
+    if (!TRY_IS(const ir::TrReturn, fn->body->term))
+        return "function body has more than one exit";
+    if (fn->attrs & FuncAttrs::MEMOIZE)
+        return "function is memoized";
+
+    std::unordered_set<SymbolId> bound;
+    for (const auto& parm: fn->parms)
+        bound.insert(parm.symbol);
+
+    size_t cost = fn->parms.size();
+
+    auto check_expr = [&](const ir::Expr* expr) -> std::optional<std::string> {
+        if (auto free = find_free_symbol(expr, bound)) {
+            return std::format(
+                "function body references non-local symbol '{}'",
+                symtab.lookup(*free).value_or("<symbol error>")
+            );
+        }
+
+        cost += expr_cost(expr);
+        return std::nullopt;
+    };
+
+    for (const ir::Stmt* stmt: fn->body->stmts) {
+        if TRY_COERCE (const ir::StmtVarDecl, var_decl, stmt) {
+            if (auto reason = check_expr(var_decl->expr))
+                return reason;
+            bound.insert(var_decl->symbol);
+        } else if TRY_COERCE (const ir::StmtExpr, expr_stmt, stmt) {
+            if (auto reason = check_expr(expr_stmt->expr))
+                return reason;
+        } else {
+            return "function body contains control flow or nested declarations";
+        }
+
+        cost++;
+    }
+
+    auto* ret = dynamic_cast<const ir::TrReturn*>(fn->body->term);
+    if (auto reason = check_expr(ret->val))
+        return reason;
+
+    size_t limit = (fn->attrs & FuncAttrs::INLINE) ? config::INLINE_HINT_COST_LIMIT
+                                                   : config::INLINE_COST_LIMIT;
+
+    // Hot functions earn the hint budget, functions that never ran are not
+    // worth the code growth
+    if (const Profile* profile = m_module->profile();
+        !imported && profile && profile->has_calls()) {
+        uint64_t calls = profile->calls(profile_site(fn->loc));
+        if (calls >= config::PROFILE_HOT_CALLS)
+            limit = config::INLINE_HINT_COST_LIMIT;
+        else if (calls == 0 && !(fn->attrs & FuncAttrs::INLINE))
+            return "function was never called while profiling";
+    }
+    if (cost > limit)
+        return std::format("function body cost {} exceeds limit {}", cost, limit);
+
+    return std::nullopt;
+}
+
+void via::Inliner::collect_declarations(const ir::Stmt* stmt) noexcept
+{
+    if TRY_COERCE (const ir::StmtVarDecl, var_decl, stmt) {
+        m_decl_counts[var_decl->symbol]++;
+    } else if TRY_COERCE (const ir::StmtFuncDecl, func_decl, stmt) {
+        m_decl_counts[func_decl->symbol]++;
+        m_candidates[func_decl->symbol] = func_decl;
+
+        for (const auto& parm: func_decl->parms)
+            m_decl_counts[parm.symbol]++;
+        if (func_decl->body != nullptr)
+            collect_declarations(func_decl->body);
+    } else if TRY_COERCE (const ir::StmtBlock, block, stmt) {
+        for (const ir::Stmt* child: block->stmts)
+            collect_declarations(child);
+    }
+}
+
+void via::Inliner::visit_expr(const ir::Expr*& expr) noexcept
+{
+    if (expr == nullptr)
+        return;
+
+    ir::for_each_operand(expr, [&](const ir::Expr*& child) { visit_expr(child); });
+
+    if TRY_COERCE (const ir::ExprCall, call, expr) {
+        const ir::StmtFuncDecl* fn = find_candidate(call->callee);
+        if (fn == nullptr || fn->parms.size() != call->args.size())
+            return;
+
+        auto* inl = m_module->allocator().emplace<ir::ExprInline>();
+        inl->loc = call->loc;
+        inl->type = call->type;
+        inl->callee = fn;
+        inl->args = call->args;
+
+        expr = inl;
+        m_inlined++;
+    }
+}
+
+// Inlinable bodies only reference their own parameters and locals, so the body
+// of an imported function can be expanded here as is
+const via::ir::StmtFuncDecl* via::Inliner::find_candidate(const ir::Expr* callee) noexcept
+{
+    if TRY_COERCE (const ir::ExprSymbol, symbol, callee) {
+        auto it = m_candidates.find(symbol->symbol);
+        return it != m_candidates.end() ? it->second : nullptr;
+    }
+
+    if TRY_COERCE (const ir::ExprModuleAccess, access, callee) {
+        auto* def = dynamic_cast<const FunctionDef*>(access->def);
+        if (def == nullptr || def->kind != ImplKind::SOURCE)
+            return nullptr;
+
+        const ir::StmtFuncDecl* fn = def->code.source;
+        auto [it, inserted] = m_imported.try_emplace(fn, false);
+        if (inserted)
+            it->second = !check_inlinable(fn, true).has_value();
+
+        return it->second ? fn : nullptr;
+    }
+
+    return nullptr;
+}
+
+void via::Inliner::visit_stmt(const ir::Stmt* stmt) noexcept
+{
+    if (stmt == nullptr)
+        return;
+
+    ir::for_each_operand(stmt, [&](const ir::Expr*& expr) { visit_expr(expr); });
+
+    if TRY_COERCE (const ir::StmtFuncDecl, func_decl, stmt) {
+        visit_stmt(func_decl->body);
+    } else if TRY_COERCE (const ir::StmtBlock, block, stmt) {
+        for (const ir::Stmt* child: block->stmts)
+            visit_stmt(child);
+    }
+}
+
+size_t via::Inliner::run(IRTree& ir_tree) noexcept
+{
+    for (const ir::Stmt* stmt: ir_tree)
+        collect_declarations(stmt);
+
+    auto& symtab = m_module->manager().symbol_table();
+
+    for (auto it = m_candidates.begin(); it != m_candidates.end();) {
+        const ir::StmtFuncDecl* fn = it->second;
+
+        if (auto reason = check_inlinable(fn)) {
+            if (fn->attrs & FuncAttrs::INLINE) {
+                m_diags.report<Level::WARNING>(
+                    fn->loc,
+                    std::format(
+                        "function '{}' marked '#inline' will not be inlined",
+                        symtab.lookup(fn->symbol).value_or("<symbol error>")
+                    ),
+                    Footnote(FootnoteKind::NOTE, *reason)
+                );
+            }
+
+            it = m_candidates.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (const ir::Stmt* stmt: ir_tree)
+        visit_stmt(stmt);
+
+    return m_inlined;
+}
@@ -0,0 +1,65 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <via/config.hpp>
+#include "diagnostics.hpp"
+#include "ir.hpp"
+
+namespace via {
+namespace config {
+
+// Maximum body cost for a function to be inlined without a hint
+VIA_CONSTANT size_t INLINE_COST_LIMIT = 16;
+
+// Maximum body cost for a function marked `#inline`
+VIA_CONSTANT size_t INLINE_HINT_COST_LIMIT = 128;
+
+} // namespace config
+
+class Module;
+class Inliner final
+{
+  public:
+    Inliner(Module* module, DiagContext& diags)
+        : m_module(module),
+          m_diags(diags)
+    {}
+
+  public:
+    // Replaces eligible call sites with `ir::ExprInline` nodes, including calls
+    // to functions of imported source modules. Returns the number of call sites
+    // that were inlined.
+    size_t run(IRTree& ir_tree) noexcept;
+
+  private:
+    std::optional<std::string>
+    check_inlinable(const ir::StmtFuncDecl* fn, bool imported = false) noexcept;
+    const ir::StmtFuncDecl* find_candidate(const ir::Expr* callee) noexcept;
+    void collect_declarations(const ir::Stmt* stmt) noexcept;
+    void visit_stmt(const ir::Stmt* stmt) noexcept;
+    void visit_expr(const ir::Expr*& expr) noexcept;
+
+  private:
+    Module* m_module;
+    DiagContext& m_diags;
+    size_t m_inlined = 0;
+    std::unordered_map<SymbolId, const ir::StmtFuncDecl*> m_candidates;
+
+    // Functions of imported modules, mapped to whether they can be inlined
+    std::unordered_map<const ir::StmtFuncDecl*, bool> m_imported;
+    std::unordered_map<SymbolId, size_t> m_decl_counts;
+};
+
+} // namespace via
@@ -11,6 +11,7 @@
 #include "lexer/token.hpp"
 #include "module/symbol.hpp"
 #include "support/ansi.hpp"
+#include "support/enum.hpp"
 
 #define SYMBOL_ERROR "<symbol error>"
 #define EXPR_ERROR "<expression error>"
@@ -24,6 +25,14 @@
 
 using enum via::TokenKind;
 
+static std::string
+versioned_symbol(const via::SymbolTable* sym_tab, via::SymbolId symbol, size_t version)
+{
+    if (version == 0)
+        return std::string(SYMBOL(symbol));
+    return std::format("{}.{}", SYMBOL(symbol), version);
+}
+
 via::UnaryOp via::to_unary_op(via::TokenKind kind) noexcept
 {
     switch (kind) {
@@ -111,6 +120,30 @@ via::ir::TrCondBranch::to_string(const SymbolTable* sym_tab, size_t depth) const
                            );
 }
 
+std::string via::ir::TrForPrep::to_string(const SymbolTable* sym_tab, size_t depth) const
+{
+    return INDENT(depth) + std::format(
+                               "FORPREP {} = {}, {}, {} ? #{} : #{}",
+                               versioned_symbol(sym_tab, var->symbol, var->version),
+                               TOSTRING(var->expr, 0, EXPR_ERROR),
+                               TOSTRING(limit, 0, EXPR_ERROR),
+                               step ? TOSTRING(step, 0, EXPR_ERROR) : "1",
+                               body->id,
+                               exit->id
+                           );
+}
+
+std::string via::ir::TrForLoop::to_string(const SymbolTable* sym_tab, size_t depth) const
+{
+    const auto* var = prep->var;
+    return INDENT(depth) + std::format(
+                               "FORLOOP {} ? #{} : #{}",
+                               versioned_symbol(sym_tab, var->symbol, var->version),
+                               prep->body->id,
+                               prep->exit->id
+                           );
+}
+
 std::string via::ir::Parameter::to_string(const SymbolTable* sym_tab, size_t depth) const
 {
     return INDENT(depth) + std::format("{}: {}", SYMBOL(symbol), type.to_string());
@@ -124,7 +157,7 @@ via::ir::ExprConstant::to_string(const SymbolTable* sym_tab, size_t depth) const
 
 std::string via::ir::ExprSymbol::to_string(const SymbolTable* sym_tab, size_t depth) const
 {
-    return INDENT(depth) + std::string(SYMBOL(symbol));
+    return INDENT(depth) + versioned_symbol(sym_tab, symbol, version);
 }
 
 std::string via::ir::ExprAccess::to_string(const SymbolTable* sym_tab, size_t depth) const
@@ -213,6 +246,22 @@ std::string via::ir::ExprTuple::to_string(const SymbolTable* sym_tab, size_t dep
     return INDENT(depth) + "<tuple>";
 }
 
+std::string
+via::ir::ExprInline::to_string(const SymbolTable* sym_tab, size_t depth) const
+{
+    return INDENT(depth) +
+           std::format(
+               "INLINE {}{}",
+               callee ? SYMBOL(callee->symbol) : SYMBOL_ERROR,
+               via::to_string(
+                   args,
+                   [&](const auto& expr) { return TOSTRING(expr, 0, EXPR_ERROR); },
+                   "(",
+                   ")"
+               )
+           );
+}
+
 std::string via::ir::ExprLambda::to_string(const SymbolTable* sym_tab, size_t depth) const
 {
     return INDENT(depth) + "<lambda>";
@@ -222,8 +271,9 @@ std::string
 via::ir::StmtVarDecl::to_string(const SymbolTable* sym_tab, size_t depth) const
 {
     return INDENT(depth) + std::format(
-                               "LOCAL {}: {} = {}",
-                               SYMBOL(symbol),
+                               "{}LOCAL {}: {} = {}",
+                               (attrs & VarAttrs::COMPTIME) ? "#comptime " : "",
+                               versioned_symbol(sym_tab, symbol, version),
                                type.to_string(),
                                TOSTRING(expr, 0, EXPR_ERROR)
                            );
@@ -235,7 +285,11 @@ via::ir::StmtFuncDecl::to_string(const SymbolTable* sym_tab, size_t depth) const
     std::ostringstream oss;
     oss << INDENT(depth)
         << std::format(
-               "FUNCTION {} {} -> {}:\n",
+               "FUNCTION {}{} {} -> {}:\n",
+               std::string((attrs & FuncAttrs::INLINE) ? "#inline " : "") +
+                   ((attrs & FuncAttrs::COMPTIME) ? "#comptime " : "") +
+                   ((attrs & FuncAttrs::MEMOIZE) ? "#memoize " : "") +
+                   ((attrs & FuncAttrs::PURE) ? "pure " : ""),
                SYMBOL(symbol),
                via::to_string(
                    parms,
@@ -246,6 +300,10 @@ via::ir::StmtFuncDecl::to_string(const SymbolTable* sym_tab, size_t depth) const
                ret.to_string()
            );
 
+    // Never referenced, the body of a lazily parsed function is not lowered
+    if (body == nullptr)
+        return oss.str() + INDENT(depth + 1) + "<deferred>";
+
     for (const Stmt* stmt: body->stmts)
         oss << TOSTRING(stmt, depth + 1, STMT_ERROR) << "\n";
 
@@ -276,6 +334,44 @@ std::string via::ir::StmtExpr::to_string(const SymbolTable* sym_tab, size_t dept
     return TOSTRING(expr, depth, EXPR_ERROR);
 }
 
+std::string via::ir::StmtPhi::to_string(const SymbolTable* sym_tab, size_t depth) const
+{
+    std::ostringstream oss;
+    oss << INDENT(depth) << "PHI " << versioned_symbol(sym_tab, symbol, version) << " = [";
+
+    for (size_t i = 0; const auto& operand: operands) {
+        if (i++ > 0)
+            oss << ", ";
+        oss << std::format(
+            "#{}: {}",
+            operand.pred->id,
+            operand.version ? versioned_symbol(sym_tab, symbol, operand.version)
+                            : "<undefined>"
+        );
+    }
+
+    oss << "]";
+    return oss.str();
+}
+
+std::string via::ir::StmtCopy::to_string(const SymbolTable* sym_tab, size_t depth) const
+{
+    std::ostringstream oss;
+    oss << INDENT(depth) << "COPY ";
+
+    for (size_t i = 0; const auto& move: moves) {
+        if (i++ > 0)
+            oss << ", ";
+        oss << std::format(
+            "{} <- {}",
+            versioned_symbol(sym_tab, move.dst->symbol, move.dst->version),
+            TOSTRING(move.src, 0, EXPR_ERROR)
+        );
+    }
+
+    return oss.str();
+}
+
 std::string via::to_string(const SymbolTable& sym_tab, const IRTree& ir_tree)
 {
     std::ostringstream oss;
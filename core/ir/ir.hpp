@@ -20,9 +20,11 @@
 
 namespace via {
 
+// BINARY functions come from compiled modules, only their signature is known
 #define FOR_EACH_IMPL_KIND(X)                                                            \
     X(SOURCE)                                                                            \
-    X(NATIVE)
+    X(NATIVE)                                                                            \
+    X(BINARY)
 
 enum class ImplKind
 {
@@ -31,6 +33,22 @@ enum class ImplKind
 
 DEFINE_TO_STRING(ImplKind, FOR_EACH_IMPL_KIND(DEFINE_CASE_TO_STRING));
 
+enum class FuncAttrs : uint8_t
+{
+    NONE = 0,
+    INLINE = 1 << 0,
+    COMPTIME = 1 << 1,
+    MEMOIZE = 1 << 2,
+    PURE = 1 << 3, // Set by PurityAnalysis
+};
+
+enum class VarAttrs : uint8_t
+{
+    NONE = 0,
+    COMPTIME = 1 << 0,
+    CONST = 1 << 1,
+};
+
 class Module;
 struct Def;
 
@@ -76,6 +94,7 @@ struct Expr
 {
     SourceLoc loc;
     QualType type;
+    bool escapes = true; // cleared by EscapeAnalysis
     virtual ~Expr() = default;
     virtual std::string to_string(const SymbolTable* sym_tab, size_t depth = 0) const = 0;
 };
@@ -131,6 +150,27 @@ struct TrCondBranch: public Term
     StmtBlock *iftrue, *iffalse;
 };
 
+struct StmtVarDecl;
+
+// Enters an integer range loop, skipping to `exit` if the range is empty. `var`
+// declares the loop variable and holds its initial value; it is not a
+// statement of any block.
+struct TrForPrep: public Term
+{
+    NODE_FIELDS(Term)
+    const StmtVarDecl* var;
+    const Expr *limit, *step; // step is null when defaulted to 1
+    StmtBlock *body, *exit;
+};
+
+// Steps the loop variable of `prep` and branches back to its body while it
+// remains in range.
+struct TrForLoop: public Term
+{
+    NODE_FIELDS(Term)
+    const TrForPrep* prep;
+};
+
 struct Parameter
 {
     SymbolId symbol;
@@ -148,6 +188,7 @@ struct ExprSymbol: public Expr
 {
     NODE_FIELDS(Expr)
     SymbolId symbol;
+    size_t version = 0; // SSA version, 0 if unversioned
 };
 
 struct ExprAccess: public Expr
@@ -224,6 +265,14 @@ struct ExprTuple: public Expr
     std::vector<const Expr*> init;
 };
 
+struct StmtFuncDecl;
+struct ExprInline: public Expr
+{
+    NODE_FIELDS(Expr)
+    const StmtFuncDecl* callee;
+    std::vector<const Expr*> args;
+};
+
 struct Function;
 struct ExprLambda: public Expr
 {
@@ -233,9 +282,13 @@ struct ExprLambda: public Expr
 struct StmtVarDecl: public Stmt
 {
     NODE_FIELDS()
+    VarAttrs attrs = VarAttrs::NONE;
     SymbolId symbol;
+    size_t version = 0; // SSA version, 0 if unversioned
     const Expr* expr;
     QualType type;
+
+    std::optional<SymbolId> get_symbol() const override { return symbol; }
 };
 
 struct StmtBlock;
@@ -244,6 +297,7 @@ struct StmtFuncDecl: public Stmt
     NODE_FIELDS()
 
     ImplKind kind;
+    FuncAttrs attrs = FuncAttrs::NONE;
     SymbolId symbol;
     QualType ret;
     std::vector<Parameter> parms;
@@ -264,6 +318,7 @@ struct StmtBlock: public Stmt
     uint32_t id;
     std::vector<const Stmt*> stmts;
     const Term* term;
+    bool loop_header = false; // Header of a natural loop, see LoopOptimizer
 };
 
 struct StmtExpr: public Stmt
@@ -272,6 +327,38 @@ struct StmtExpr: public Stmt
     const Expr* expr;
 };
 
+struct PhiOperand
+{
+    const StmtBlock* pred;
+    size_t version; // 0 if the symbol has no definition along this edge
+};
+
+// Merges the versions of `symbol` reaching a block join. Only present while
+// the IR is in SSA form.
+struct StmtPhi: public Stmt
+{
+    NODE_FIELDS()
+    SymbolId symbol;
+    size_t version;
+    QualType type;
+    std::vector<PhiOperand> operands;
+};
+
+// Stores made on a control flow edge when leaving SSA form, one per phi node of
+// the block the edge enters. Every source is read before any slot is written.
+struct StmtCopy: public Stmt
+{
+    NODE_FIELDS()
+
+    struct Move
+    {
+        const StmtVarDecl* dst;
+        const Expr* src;
+    };
+
+    std::vector<Move> moves;
+};
+
 } // namespace ir
 
 using IRTree = std::vector<const ir::Stmt*>;
@@ -0,0 +1,376 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "loop.hpp"
+#include <algorithm>
+#include <bit>
+#include <format>
+#include <functional>
+#include <map>
+#include <optional>
+#include "debug.hpp"
+#include "module/manager.hpp"
+#include "module/module.hpp"
+#include "rewrite.hpp"
+#include "support/math.hpp"
+
+namespace ir = via::ir;
+
+std::vector<ir::Loop> ir::find_loops(const ControlFlowGraph& cfg) noexcept
+{
+    // Keyed by header, ordered so the result does not depend on hashing
+    std::map<size_t, Loop> loops;
+
+    for (size_t id: cfg.reverse_postorder()) {
+        for (size_t succ: cfg.succs(id)) {
+            if (!cfg.dominates(succ, id))
+                continue;
+
+            auto& loop = loops[succ];
+            loop.header = succ;
+            loop.latches.push_back(id);
+        }
+    }
+
+    std::vector<Loop> result;
+    for (auto& [header, loop]: loops) {
+        loop.blocks.insert(header);
+
+        std::vector<size_t> worklist = loop.latches;
+        while (!worklist.empty()) {
+            size_t id = worklist.back();
+            worklist.pop_back();
+
+            if (!loop.blocks.insert(id).second)
+                continue;
+            for (size_t pred: cfg.preds(id)) {
+                if (cfg.is_reachable(pred))
+                    worklist.push_back(pred);
+            }
+        }
+
+        // The preheader is the only block entering the loop. It may also branch
+        // past the loop (FORPREP does), which is fine since only expressions
+        // that cannot trap are hoisted into it.
+        std::vector<size_t> entries;
+        for (size_t pred: cfg.preds(header)) {
+            if (!loop.blocks.contains(pred))
+                entries.push_back(pred);
+        }
+
+        if (entries.size() == 1)
+            loop.preheader = entries.front();
+
+        result.push_back(std::move(loop));
+    }
+
+    std::stable_sort(result.begin(), result.end(), [](const Loop& a, const Loop& b) {
+        return a.blocks.size() < b.blocks.size();
+    });
+    return result;
+}
+
+size_t via::LoopOptimizer::VersionHash::operator()(const Version& key) const noexcept
+{
+    return hash_all(static_cast<size_t>(key.first), key.second);
+}
+
+static std::vector<size_t> sorted_blocks(const ir::Loop& loop)
+{
+    std::vector<size_t> blocks(loop.blocks.begin(), loop.blocks.end());
+    std::sort(blocks.begin(), blocks.end());
+    return blocks;
+}
+
+static bool is_integral(const ir::Expr* expr) noexcept
+{
+    return expr != nullptr && expr->type.unwrap() != nullptr &&
+           expr->type.unwrap()->is_integral();
+}
+
+static std::optional<int64_t> int_constant(const ir::Expr* expr) noexcept
+{
+    if TRY_COERCE (const ir::ExprConstant, constant, expr) {
+        if (constant->value.kind() == via::ValueKind::INT)
+            return constant->value.value<via::ValueKind::INT>();
+    }
+    return std::nullopt;
+}
+
+// Returns k if `value` is 2^k for some k >= 1
+static std::optional<int64_t> log2_exact(std::optional<int64_t> value) noexcept
+{
+    if (!value.has_value() || *value < 2)
+        return std::nullopt;
+
+    auto bits = static_cast<uint64_t>(*value);
+    if (!std::has_single_bit(bits))
+        return std::nullopt;
+    return std::countr_zero(bits);
+}
+
+size_t via::LoopOptimizer::run(IRTree& ir_tree) noexcept
+{
+    m_next_id = ir::next_block_id(ir_tree);
+
+    for (const auto& region: ir::get_regions(ir_tree))
+        optimize_region(region);
+
+    return m_rewrites;
+}
+
+void via::LoopOptimizer::optimize_region(const IRTree& region) noexcept
+{
+    ir::ControlFlowGraph cfg(m_module->allocator(), m_next_id, region);
+
+    m_defs.clear();
+    for (size_t id = 0; id < cfg.size(); id++) {
+        for (const ir::Stmt* stmt: cfg.block(id)->stmts) {
+            if TRY_COERCE (const ir::StmtVarDecl, var_decl, stmt) {
+                if (var_decl->version != 0)
+                    m_defs[{var_decl->symbol, var_decl->version}] = var_decl->expr;
+            }
+        }
+    }
+
+    for (const auto& loop: ir::find_loops(cfg)) {
+        cfg.block(loop.header)->loop_header = true;
+
+        for (size_t id: sorted_blocks(loop)) {
+            ir::StmtBlock* block = cfg.block(id);
+            auto reduce = [&](const ir::Expr*& expr) { reduce_expr(expr); };
+
+            for (const ir::Stmt* stmt: block->stmts)
+                ir::for_each_operand(stmt, reduce);
+            if (block->term != nullptr)
+                ir::for_each_operand(block->term, reduce);
+        }
+
+        if (loop.preheader != ir::ControlFlowGraph::NONE)
+            hoist_invariants(cfg, loop);
+    }
+}
+
+// An expression is invariant if it is pure, cannot trap, and only refers to
+// versions defined outside of the loop.
+static bool is_invariant(
+    const ir::Expr* expr,
+    const std::function<bool(via::SymbolId, size_t)>& is_variant
+) noexcept
+{
+    if (expr == nullptr)
+        return false;
+    if TRY_IS (const ir::ExprConstant, expr)
+        return true;
+    if TRY_COERCE (const ir::ExprSymbol, symbol, expr)
+        return !is_variant(symbol->symbol, symbol->version);
+    if TRY_COERCE (const ir::ExprUnary, unary, expr)
+        return is_invariant(unary->expr, is_variant);
+
+    if TRY_COERCE (const ir::ExprBinary, binary, expr) {
+        if (binary->op == via::BinaryOp::DIV || binary->op == via::BinaryOp::MOD) {
+            // Integer division by zero traps, so it may not be speculated
+            auto divisor = int_constant(binary->rhs);
+            if (!TRY_IS(const ir::ExprConstant, binary->rhs) || divisor == 0)
+                return false;
+        }
+
+        return is_invariant(binary->lhs, is_variant) &&
+               is_invariant(binary->rhs, is_variant);
+    }
+
+    return false;
+}
+
+void via::LoopOptimizer::hoist_invariants(
+    const ir::ControlFlowGraph& cfg,
+    const ir::Loop& loop
+) noexcept
+{
+    VersionSet variant;
+    for (size_t id: loop.blocks) {
+        ir::StmtBlock* block = cfg.block(id);
+        for (const ir::Stmt* stmt: block->stmts) {
+            if TRY_COERCE (const ir::StmtVarDecl, var_decl, stmt)
+                variant.insert({var_decl->symbol, var_decl->version});
+            else if TRY_COERCE (const ir::StmtPhi, phi, stmt)
+                variant.insert({phi->symbol, phi->version});
+        }
+
+        // The loop variable is stepped by the latch
+        if TRY_COERCE (const ir::TrForLoop, for_loop, block->term)
+            variant.insert({for_loop->prep->var->symbol, for_loop->prep->var->version});
+    }
+
+    std::vector<const ir::Stmt*> hoisted;
+    auto hoist = [&](const ir::Expr*& expr) { hoist_expr(expr, variant, hoisted); };
+
+    for (size_t id: sorted_blocks(loop)) {
+        ir::StmtBlock* block = cfg.block(id);
+        for (const ir::Stmt* stmt: block->stmts)
+            ir::for_each_operand(stmt, hoist);
+        if (block->term != nullptr)
+            ir::for_each_operand(block->term, hoist);
+    }
+
+    if (hoisted.empty())
+        return;
+
+    ir::StmtBlock* preheader = cfg.block(loop.preheader);
+    auto pos = preheader->stmts.begin() + cfg.head_size(loop.preheader);
+    preheader->stmts.insert(pos, hoisted.begin(), hoisted.end());
+}
+
+void via::LoopOptimizer::hoist_expr(
+    const ir::Expr*& expr,
+    const VersionSet& variant,
+    std::vector<const ir::Stmt*>& hoisted
+) noexcept
+{
+    if (expr == nullptr)
+        return;
+
+    auto is_variant = [&](SymbolId symbol, size_t version) {
+        return variant.contains({symbol, version});
+    };
+
+    // Leaves are as cheap to evaluate as the local that would replace them
+    bool compound =
+        TRY_IS(const ir::ExprBinary, expr) || TRY_IS(const ir::ExprUnary, expr);
+
+    if (compound && is_invariant(expr, is_variant)) {
+        auto& symtab = m_module->manager().symbol_table();
+
+        auto* decl = m_module->allocator().emplace<ir::StmtVarDecl>();
+        decl->loc = expr->loc;
+        decl->symbol = symtab.intern(std::format("<licm.{}>", m_temps++));
+        decl->version = 1;
+        decl->expr = expr;
+        decl->type = expr->type;
+        hoisted.push_back(decl);
+
+        auto* symbol = m_module->allocator().emplace<ir::ExprSymbol>();
+        symbol->loc = expr->loc;
+        symbol->symbol = decl->symbol;
+        symbol->version = decl->version;
+        symbol->type = expr->type;
+
+        expr = symbol;
+        m_rewrites++;
+        return;
+    }
+
+    ir::for_each_operand(expr, [&](const ir::Expr*& child) {
+        hoist_expr(child, variant, hoisted);
+    });
+}
+
+// Replaces integer arithmetic with cheaper equivalents. Identities remove an
+// instruction outright, powers of two turn into shifts.
+void via::LoopOptimizer::reduce_expr(const ir::Expr*& expr) noexcept
+{
+    if (expr == nullptr)
+        return;
+
+    ir::for_each_operand(expr, [&](const ir::Expr*& child) { reduce_expr(child); });
+
+    auto* binary = dynamic_cast<const ir::ExprBinary*>(expr);
+    if (binary == nullptr || !is_integral(binary->lhs) || !is_integral(binary->rhs))
+        return;
+
+    auto lhs = int_constant(binary->lhs);
+    auto rhs = int_constant(binary->rhs);
+
+    auto replace = [&](const ir::Expr* with) {
+        expr = with;
+        m_rewrites++;
+    };
+
+    auto shift = [&](BinaryOp op, const ir::Expr* value, int64_t amount) {
+        auto* constant = m_module->allocator().emplace<ir::ExprConstant>();
+        constant->loc = binary->loc;
+        constant->value = ConstValue(amount);
+        constant->type = binary->rhs->type;
+
+        auto* shifted = m_module->allocator().emplace<ir::ExprBinary>();
+        shifted->loc = binary->loc;
+        shifted->type = binary->type;
+        shifted->op = op;
+        shifted->lhs = value;
+        shifted->rhs = constant;
+        replace(shifted);
+    };
+
+    switch (binary->op) {
+    case BinaryOp::ADD:
+        if (rhs == 0)
+            replace(binary->lhs);
+        else if (lhs == 0)
+            replace(binary->rhs);
+        break;
+    case BinaryOp::SUB:
+        if (rhs == 0)
+            replace(binary->lhs);
+        break;
+    case BinaryOp::MUL:
+        if (rhs == 1)
+            replace(binary->lhs);
+        else if (lhs == 1)
+            replace(binary->rhs);
+        else if (auto k = log2_exact(rhs))
+            shift(BinaryOp::BSHL, binary->lhs, *k);
+        else if (auto k = log2_exact(lhs))
+            shift(BinaryOp::BSHL, binary->rhs, *k);
+        break;
+    case BinaryOp::DIV:
+        // IDIV truncates towards zero while BSHR rounds down, so the two only
+        // agree on non-negative dividends.
+        if (rhs == 1)
+            replace(binary->lhs);
+        else if (auto k = log2_exact(rhs); k && is_non_negative(binary->lhs))
+            shift(BinaryOp::BSHR, binary->lhs, *k);
+        break;
+    default:
+        break;
+    }
+}
+
+bool via::LoopOptimizer::is_non_negative(const ir::Expr* expr, size_t depth)
+    const noexcept
+{
+    // Bounds the walk through chains of local definitions
+    if (expr == nullptr || depth > 8)
+        return false;
+
+    if (auto value = int_constant(expr))
+        return *value >= 0;
+
+    if TRY_COERCE (const ir::ExprSymbol, symbol, expr) {
+        auto it = m_defs.find({symbol->symbol, symbol->version});
+        return it != m_defs.end() && is_non_negative(it->second, depth + 1);
+    }
+
+    if TRY_COERCE (const ir::ExprBinary, binary, expr) {
+        switch (binary->op) {
+        case BinaryOp::BAND:
+            return is_non_negative(binary->lhs, depth + 1) ||
+                   is_non_negative(binary->rhs, depth + 1);
+        case BinaryOp::BSHR:
+            return is_non_negative(binary->lhs, depth + 1);
+        case BinaryOp::DIV:
+        case BinaryOp::MOD:
+            return is_non_negative(binary->lhs, depth + 1) &&
+                   is_non_negative(binary->rhs, depth + 1);
+        default:
+            break;
+        }
+    }
+
+    return false;
+}
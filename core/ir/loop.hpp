@@ -0,0 +1,81 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <via/config.hpp>
+#include "cfg.hpp"
+#include "ir.hpp"
+
+namespace via {
+namespace ir {
+
+struct Loop
+{
+    size_t header;
+    size_t preheader = ControlFlowGraph::NONE; // NONE if the loop has none
+    std::vector<size_t> latches;
+    std::unordered_set<size_t> blocks;
+};
+
+// Returns the natural loops of `cfg`, innermost first. Back edges to the same
+// header are merged into a single loop.
+std::vector<Loop> find_loops(const ControlFlowGraph& cfg) noexcept;
+
+} // namespace ir
+
+class Module;
+class LoopOptimizer final
+{
+  public:
+    LoopOptimizer(Module* module)
+        : m_module(module)
+    {}
+
+  public:
+    // Hoists loop invariant expressions into loop preheaders and strength
+    // reduces arithmetic inside loops. Expects the tree to be in SSA form.
+    // Returns the number of rewrites performed.
+    size_t run(IRTree& ir_tree) noexcept;
+
+  private:
+    struct VersionHash
+    {
+        size_t operator()(const std::pair<SymbolId, size_t>& key) const noexcept;
+    };
+
+    using Version = std::pair<SymbolId, size_t>;
+    using VersionSet = std::unordered_set<Version, VersionHash>;
+    using DefMap = std::unordered_map<Version, const ir::Expr*, VersionHash>;
+
+  private:
+    void optimize_region(const IRTree& region) noexcept;
+    void hoist_invariants(const ir::ControlFlowGraph& cfg, const ir::Loop& loop) noexcept;
+    void hoist_expr(
+        const ir::Expr*& expr,
+        const VersionSet& variant,
+        std::vector<const ir::Stmt*>& hoisted
+    ) noexcept;
+    void reduce_expr(const ir::Expr*& expr) noexcept;
+    bool is_non_negative(const ir::Expr* expr, size_t depth = 0) const noexcept;
+
+  private:
+    Module* m_module;
+    uint32_t m_next_id = 0;
+    size_t m_rewrites = 0;
+    size_t m_temps = 0;
+    DefMap m_defs;
+};
+
+} // namespace via
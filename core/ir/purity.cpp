@@ -0,0 +1,261 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "purity.hpp"
+#include <format>
+#include "debug.hpp"
+#include "module/defs.hpp"
+#include "module/manager.hpp"
+#include "module/module.hpp"
+#include "rewrite.hpp"
+#include "support/enum.hpp"
+#include "vm/memo.hpp"
+
+// Memo keys and results are stored by value, so only scalars qualify
+static bool is_scalar(via::QualType type) noexcept
+{
+    if (!type || type.is_reference())
+        return false;
+
+    auto* builtin = dynamic_cast<const via::BuiltinType*>(type.unwrap());
+    return builtin != nullptr && builtin->is_one_of<
+                                     via::BuiltinKind::NIL,
+                                     via::BuiltinKind::BOOL,
+                                     via::BuiltinKind::INT,
+                                     via::BuiltinKind::FLOAT>();
+}
+
+static bool contains_call(const via::ir::Expr* expr) noexcept
+{
+    if (expr == nullptr)
+        return false;
+    if (TRY_IS(const via::ir::ExprCall, expr) || TRY_IS(const via::ir::ExprInline, expr))
+        return true;
+
+    bool found = false;
+    via::ir::for_each_operand(expr, [&](const via::ir::Expr* child) {
+        found = found || contains_call(child);
+    });
+    return found;
+}
+
+// Straight line bodies without calls cost less to evaluate than a memo lookup
+static bool is_trivial(const via::ir::StmtFuncDecl* fn) noexcept
+{
+    if (!TRY_IS(const via::ir::TrReturn, fn->body->term))
+        return false;
+
+    bool trivial = true;
+    for (const via::ir::Stmt* stmt: fn->body->stmts) {
+        if (TRY_IS(const via::ir::StmtBlock, stmt))
+            return false;
+
+        via::ir::for_each_operand(stmt, [&](const via::ir::Expr* expr) {
+            trivial = trivial && !contains_call(expr);
+        });
+    }
+
+    via::ir::for_each_operand(fn->body->term, [&](const via::ir::Expr* expr) {
+        trivial = trivial && !contains_call(expr);
+    });
+    return trivial;
+}
+
+void via::PurityAnalysis::collect_declarations(const ir::Stmt* stmt) noexcept
+{
+    if TRY_COERCE (const ir::StmtFuncDecl, func_decl, stmt) {
+        m_decl_counts[func_decl->symbol]++;
+        m_functions[func_decl->symbol] = func_decl;
+        m_decls.push_back(func_decl);
+
+        if (func_decl->body != nullptr)
+            collect_declarations(func_decl->body);
+    } else if TRY_COERCE (const ir::StmtBlock, block, stmt) {
+        for (const ir::Stmt* child: block->stmts)
+            collect_declarations(child);
+    }
+}
+
+bool via::PurityAnalysis::is_pure(const ir::StmtFuncDecl* fn) noexcept
+{
+    if (auto it = m_pure.find(fn); it != m_pure.end())
+        return it->second;
+
+    m_pure[fn] = false;
+    bool pure = !check_pure(fn).has_value();
+    m_pure[fn] = pure;
+    return pure;
+}
+
+std::optional<std::string>
+via::PurityAnalysis::check_pure(const ir::StmtFuncDecl* fn) noexcept
+{
+    if (fn->kind != ImplKind::SOURCE || fn->body == nullptr)
+        return "function has no source body";
+
+    m_checking.push_back(fn);
+    auto reason = check_block(fn->body);
+    m_checking.pop_back();
+    return reason;
+}
+
+std::optional<std::string>
+via::PurityAnalysis::check_block(const ir::StmtBlock* block) noexcept
+{
+    std::optional<std::string> reason;
+    auto visit = [&](const ir::Expr* expr) {
+        if (!reason.has_value())
+            reason = check_expr(expr);
+    };
+
+    for (const ir::Stmt* stmt: block->stmts) {
+        if TRY_COERCE (const ir::StmtBlock, child, stmt) {
+            reason = check_block(child);
+        } else if (!TRY_IS(const ir::StmtFuncDecl, stmt)) {
+            // Declaring a closure has no effect until it is called
+            ir::for_each_operand(stmt, visit);
+        }
+
+        if (reason.has_value())
+            return reason;
+    }
+
+    if (block->term != nullptr)
+        ir::for_each_operand(block->term, visit);
+    return reason;
+}
+
+// Functions only see their own locals, so the only way a body can affect or
+// observe anything else is through the functions it calls
+std::optional<std::string> via::PurityAnalysis::check_expr(const ir::Expr* expr) noexcept
+{
+    if (expr == nullptr)
+        return std::nullopt;
+
+    auto& symtab = m_module->manager().symbol_table();
+    auto name_of = [&](SymbolId symbol) {
+        return symtab.lookup(symbol).value_or("<symbol error>");
+    };
+
+    if TRY_COERCE (const ir::ExprCall, call, expr) {
+        if TRY_COERCE (const ir::ExprSymbol, symbol, call->callee) {
+            auto it = m_functions.find(symbol->symbol);
+            if (it == m_functions.end() || m_decl_counts[symbol->symbol] != 1)
+                return std::format(
+                    "calls '{}', which is not a known function",
+                    name_of(symbol->symbol)
+                );
+            bool recursive = !m_checking.empty() && m_checking.back() == it->second;
+            if (!recursive && !is_pure(it->second))
+                return std::format(
+                    "calls impure function '{}'",
+                    name_of(symbol->symbol)
+                );
+        } else if TRY_COERCE (const ir::ExprModuleAccess, access, call->callee) {
+            auto* def = dynamic_cast<const FunctionDef*>(access->def);
+            if (def == nullptr || def->kind != ImplKind::SOURCE ||
+                !is_pure(def->code.source))
+                return std::format(
+                    "calls '{}::{}', which may have side effects",
+                    name_of(access->mod_id),
+                    name_of(access->key_id)
+                );
+        } else {
+            return "calls a function value that may have side effects";
+        }
+    } else if TRY_COERCE (const ir::ExprInline, inl, expr) {
+        if (!is_pure(inl->callee))
+            return std::format(
+                "calls impure function '{}'",
+                name_of(inl->callee->symbol)
+            );
+    }
+
+    std::optional<std::string> reason;
+    ir::for_each_operand(expr, [&](const ir::Expr* child) {
+        if (!reason.has_value())
+            reason = check_expr(child);
+    });
+    return reason;
+}
+
+std::optional<std::string>
+via::PurityAnalysis::check_memoizable(const ir::StmtFuncDecl* fn) noexcept
+{
+    auto& symtab = m_module->manager().symbol_table();
+
+    if (!is_pure(fn))
+        return check_pure(fn).value_or("function is not pure");
+    if (fn->parms.size() > config::MEMO_MAX_ARGS)
+        return std::format(
+            "function has more than {} parameters",
+            config::MEMO_MAX_ARGS
+        );
+
+    for (const auto& parm: fn->parms) {
+        if (!is_scalar(parm.type))
+            return std::format(
+                "parameter '{}' of type '{}' cannot be part of a memo key",
+                symtab.lookup(parm.symbol).value_or("<symbol error>"),
+                parm.type ? parm.type.to_string() : "<type error>"
+            );
+    }
+
+    if (!is_scalar(fn->ret))
+        return std::format(
+            "return type '{}' cannot be memoized",
+            fn->ret ? fn->ret.to_string() : "<type error>"
+        );
+    return std::nullopt;
+}
+
+size_t via::PurityAnalysis::run(IRTree& ir_tree) noexcept
+{
+    for (const ir::Stmt* stmt: ir_tree)
+        collect_declarations(stmt);
+
+    auto& symtab = m_module->manager().symbol_table();
+    const Profile* profile = m_module->profile();
+
+    for (const ir::StmtFuncDecl* fn: m_decls) {
+        auto* mut_fn = ir::as_mutable(fn);
+        if (is_pure(fn))
+            mut_fn->attrs |= FuncAttrs::PURE;
+
+        // Memoizing is inferred for pure functions that are called often and do
+        // enough work per call to be worth a lookup
+        bool hinted = fn->attrs & FuncAttrs::MEMOIZE;
+        bool hot = profile && profile->calls(profile_site(fn->loc)) >=
+                                  config::PROFILE_HOT_CALLS;
+
+        if (!hinted && !(hot && is_pure(fn) && !is_trivial(fn)))
+            continue;
+
+        if (auto reason = check_memoizable(fn)) {
+            if (hinted) {
+                m_diags.report<Level::WARNING>(
+                    fn->loc,
+                    std::format(
+                        "function '{}' marked '#memoize' will not be memoized",
+                        symtab.lookup(fn->symbol).value_or("<symbol error>")
+                    ),
+                    Footnote(FootnoteKind::NOTE, *reason)
+                );
+            }
+
+            mut_fn->attrs &= ~FuncAttrs::MEMOIZE;
+            continue;
+        }
+
+        mut_fn->attrs |= FuncAttrs::MEMOIZE;
+        m_memoized++;
+    }
+
+    return m_memoized;
+}
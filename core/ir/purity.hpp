@@ -0,0 +1,64 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <via/config.hpp>
+#include "diagnostics.hpp"
+#include "ir.hpp"
+
+namespace via {
+
+class Module;
+class PurityAnalysis final
+{
+  public:
+    PurityAnalysis(Module* module, DiagContext& diags)
+        : m_module(module),
+          m_diags(diags)
+    {}
+
+  public:
+    // Marks functions whose result only depends on their arguments as
+    // `FuncAttrs::PURE`, and decides which of them have their results
+    // memoized: those marked `#memoize`, and pure functions the profile shows
+    // are hot. Returns the number of memoized functions.
+    size_t run(IRTree& ir_tree) noexcept;
+
+  private:
+    std::optional<std::string> check_pure(const ir::StmtFuncDecl* fn) noexcept;
+    std::optional<std::string> check_expr(const ir::Expr* expr) noexcept;
+    std::optional<std::string> check_block(const ir::StmtBlock* block) noexcept;
+    std::optional<std::string> check_memoizable(const ir::StmtFuncDecl* fn) noexcept;
+    bool is_pure(const ir::StmtFuncDecl* fn) noexcept;
+    void collect_declarations(const ir::Stmt* stmt) noexcept;
+
+  private:
+    Module* m_module;
+    DiagContext& m_diags;
+    size_t m_memoized = 0;
+    std::vector<const ir::StmtFuncDecl*> m_decls;
+    std::unordered_map<SymbolId, const ir::StmtFuncDecl*> m_functions;
+    std::unordered_map<SymbolId, size_t> m_decl_counts;
+
+    // Functions checked so far, including those of imported modules. Entries
+    // are made before a body is checked, so cycles resolve to impure.
+    std::unordered_map<const ir::StmtFuncDecl*, bool> m_pure;
+
+    // Bodies being checked, innermost last. A call to the function whose body
+    // it is in has no effects the rest of that body does not have.
+    std::vector<const ir::StmtFuncDecl*> m_checking;
+};
+
+} // namespace via
@@ -0,0 +1,100 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <via/config.hpp>
+#include "ast/ast.hpp"
+#include "ir.hpp"
+
+namespace via {
+namespace ir {
+
+// IR nodes are allocated mutably by the builder and only handed out as const.
+// Optimization passes that rewrite the tree in place go through this.
+template <typename T>
+T* as_mutable(const T* node) noexcept
+{
+    return const_cast<T*>(node);
+}
+
+// Invokes `fn` on every operand slot of `expr`. Slots are passed by reference
+// so the callback may replace the operand.
+template <typename Fn>
+void for_each_operand(const Expr* expr, Fn&& fn)
+{
+    if TRY_COERCE (const ExprAccess, access, expr) {
+        fn(as_mutable(access)->root);
+    } else if TRY_COERCE (const ExprUnary, unary, expr) {
+        fn(as_mutable(unary)->expr);
+    } else if TRY_COERCE (const ExprBinary, binary, expr) {
+        fn(as_mutable(binary)->lhs);
+        fn(as_mutable(binary)->rhs);
+    } else if TRY_COERCE (const ExprCall, call, expr) {
+        fn(as_mutable(call)->callee);
+        for (auto& arg: as_mutable(call)->args)
+            fn(arg);
+    } else if TRY_COERCE (const ExprInline, inl, expr) {
+        for (auto& arg: as_mutable(inl)->args)
+            fn(arg);
+    } else if TRY_COERCE (const ExprSubscript, subscript, expr) {
+        fn(as_mutable(subscript)->expr);
+        fn(as_mutable(subscript)->idx);
+    } else if TRY_COERCE (const ExprCast, cast, expr) {
+        fn(as_mutable(cast)->expr);
+    } else if TRY_COERCE (const ExprTernary, ternary, expr) {
+        fn(as_mutable(ternary)->cnd);
+        fn(as_mutable(ternary)->iftrue);
+        fn(as_mutable(ternary)->iffalse);
+    } else if TRY_COERCE (const ExprArray, array, expr) {
+        for (auto& elem: as_mutable(array)->exprs)
+            fn(elem);
+    } else if TRY_COERCE (const ExprTuple, tuple, expr) {
+        for (auto& elem: as_mutable(tuple)->init)
+            fn(elem);
+    }
+}
+
+// Invokes `fn` on every expression slot owned directly by `term`.
+template <typename Fn>
+void for_each_operand(const Term* term, Fn&& fn)
+{
+    if TRY_COERCE (const TrReturn, ret, term) {
+        if (ret->val != nullptr)
+            fn(as_mutable(ret)->val);
+    } else if TRY_COERCE (const TrCondBranch, cond_br, term) {
+        fn(as_mutable(cond_br)->cnd);
+    } else if TRY_COERCE (const TrForPrep, prep, term) {
+        fn(as_mutable(prep->var)->expr);
+        fn(as_mutable(prep)->limit);
+        if (prep->step != nullptr)
+            fn(as_mutable(prep)->step);
+    }
+}
+
+// Invokes `fn` on every expression slot owned directly by `stmt`. Nested
+// statements (block contents, function bodies) are not visited.
+template <typename Fn>
+void for_each_operand(const Stmt* stmt, Fn&& fn)
+{
+    if TRY_COERCE (const StmtVarDecl, var_decl, stmt) {
+        fn(as_mutable(var_decl)->expr);
+    } else if TRY_COERCE (const StmtExpr, expr_stmt, stmt) {
+        fn(as_mutable(expr_stmt)->expr);
+    } else if TRY_COERCE (const StmtCopy, copy, stmt) {
+        for (auto& move: as_mutable(copy)->moves)
+            fn(move.src);
+    } else if TRY_COERCE (const StmtBlock, block, stmt) {
+        if (block->term != nullptr)
+            for_each_operand(block->term, fn);
+    }
+}
+
+} // namespace ir
+} // namespace via
@@ -0,0 +1,475 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "ssa.hpp"
+#include <algorithm>
+#include <map>
+#include "debug.hpp"
+#include "module/module.hpp"
+#include "rewrite.hpp"
+
+namespace ir = via::ir;
+
+static bool is_instruction(const ir::Stmt* stmt, via::OpCode op) noexcept
+{
+    if TRY_COERCE (const ir::StmtInstruction, instr, stmt)
+        return instr->instr.op == op;
+    return false;
+}
+
+static size_t top_version(
+    const std::unordered_map<via::SymbolId, std::vector<size_t>>& stacks,
+    via::SymbolId symbol
+) noexcept
+{
+    auto it = stacks.find(symbol);
+    return (it == stacks.end() || it->second.empty()) ? 0 : it->second.back();
+}
+
+void via::SSABuilder::construct(IRTree& ir_tree) noexcept
+{
+    m_next_id = ir::next_block_id(ir_tree);
+
+    for (const auto& region: ir::get_regions(ir_tree))
+        build_region(region);
+}
+
+void via::SSABuilder::destruct(IRTree& ir_tree) noexcept
+{
+    m_next_id = ir::next_block_id(ir_tree);
+
+    for (const auto& region: ir::get_regions(ir_tree))
+        destruct_region(region);
+}
+
+void via::SSABuilder::build_region(const IRTree& tree) noexcept
+{
+    Region region(ir::ControlFlowGraph(m_module->allocator(), m_next_id, tree));
+    if (region.cfg.size() == 0)
+        return;
+
+    collect(region);
+    place_phis(region);
+    rename(region, 0);
+    remove_trivial_phis(region);
+}
+
+// Gathers the variables of the region and pairs SAVE/RESTORE instructions.
+// Blocks are visited in layout order, which is the order they execute in
+// when there is no branching, so scopes nest correctly.
+void via::SSABuilder::collect(Region& region) noexcept
+{
+    std::vector<Scope> open;
+
+    for (size_t id = 0; id < region.cfg.size(); id++) {
+        ir::StmtBlock* block = region.cfg.block(id);
+
+        // A range loop variable is declared by the SAVE opening its body
+        if TRY_COERCE (const ir::TrForPrep, prep, block->term) {
+            auto& body = prep->body->stmts;
+            debug::require(
+                !body.empty() && is_instruction(body.front(), OpCode::SAVE),
+                "range loop body does not open a scope"
+            );
+
+            region.vars.emplace(prep->var->symbol, prep->var->type);
+            region.loop_vars[body.front()] = prep->var;
+        }
+
+        for (const ir::Stmt* stmt: block->stmts) {
+            if TRY_COERCE (const ir::StmtVarDecl, var_decl, stmt) {
+                region.vars.emplace(var_decl->symbol, var_decl->type);
+                for (auto& scope: open)
+                    scope.symbols.insert(var_decl->symbol);
+            } else if (is_instruction(stmt, OpCode::SAVE)) {
+                open.push_back({stmt, {}});
+                if (auto it = region.loop_vars.find(stmt); it != region.loop_vars.end()) {
+                    for (auto& scope: open)
+                        scope.symbols.insert(it->second->symbol);
+                }
+            } else if (is_instruction(stmt, OpCode::RESTORE)) {
+                debug::require(!open.empty(), "unbalanced RESTORE instruction");
+                region.scopes[stmt] = std::move(open.back());
+                open.pop_back();
+            }
+        }
+    }
+}
+
+// Cytron et al., phi nodes are placed on the iterated dominance frontier of
+// every block that defines a variable. A RESTORE counts as a definition of the
+// symbols declared in its scope, since it brings back their outer versions.
+void via::SSABuilder::place_phis(Region& region) noexcept
+{
+    auto& cfg = region.cfg;
+    auto& alloc = m_module->allocator();
+
+    std::unordered_map<SymbolId, std::vector<size_t>> def_blocks;
+    for (size_t id = 0; id < cfg.size(); id++) {
+        for (const ir::Stmt* stmt: cfg.block(id)->stmts) {
+            if TRY_COERCE (const ir::StmtVarDecl, var_decl, stmt) {
+                def_blocks[var_decl->symbol].push_back(id);
+            } else if (auto it = region.loop_vars.find(stmt);
+                       it != region.loop_vars.end()) {
+                def_blocks[it->second->symbol].push_back(id);
+            } else if (auto it = region.scopes.find(stmt); it != region.scopes.end()) {
+                for (SymbolId symbol: it->second.symbols)
+                    def_blocks[symbol].push_back(id);
+            }
+        }
+    }
+
+    region.phis.assign(cfg.size(), {});
+
+    for (auto& [symbol, blocks]: def_blocks) {
+        std::vector<bool> has_phi(cfg.size(), false);
+        std::vector<bool> queued(cfg.size(), false);
+        std::vector<size_t> worklist = blocks;
+
+        for (size_t id: blocks)
+            queued[id] = true;
+
+        while (!worklist.empty()) {
+            size_t id = worklist.back();
+            worklist.pop_back();
+
+            for (size_t join: cfg.frontier(id)) {
+                if (has_phi[join])
+                    continue;
+
+                ir::StmtBlock* block = cfg.block(join);
+                auto* phi = alloc.emplace<ir::StmtPhi>();
+                phi->loc = block->loc;
+                phi->symbol = symbol;
+                phi->type = region.vars.at(symbol);
+
+                for (size_t pred: cfg.preds(join))
+                    phi->operands.push_back({cfg.block(pred), 0});
+
+                block->stmts.insert(block->stmts.begin(), phi);
+                region.phis[join].push_back(phi);
+                has_phi[join] = true;
+
+                if (!queued[join]) {
+                    queued[join] = true;
+                    worklist.push_back(join);
+                }
+            }
+        }
+    }
+}
+
+void via::SSABuilder::rename_expr(Region& region, const ir::Expr* expr) noexcept
+{
+    if (expr == nullptr)
+        return;
+
+    if TRY_COERCE (const ir::ExprSymbol, symbol, expr) {
+        if (region.vars.contains(symbol->symbol))
+            ir::as_mutable(symbol)->version = top_version(region.stacks, symbol->symbol);
+        return;
+    }
+
+    ir::for_each_operand(expr, [&](const ir::Expr* child) {
+        rename_expr(region, child);
+    });
+}
+
+// Walks the dominator tree, so the top of each version stack is the definition
+// that reaches the statement being visited.
+void via::SSABuilder::rename(Region& region, size_t id) noexcept
+{
+    auto& cfg = region.cfg;
+    ir::StmtBlock* block = cfg.block(id);
+    std::vector<SymbolId> pushed;
+
+    auto define = [&](SymbolId symbol, size_t version) {
+        region.stacks[symbol].push_back(version);
+        pushed.push_back(symbol);
+    };
+
+    for (ir::StmtPhi* phi: region.phis[id]) {
+        phi->version = ++region.counters[phi->symbol];
+        define(phi->symbol, phi->version);
+    }
+
+    for (const ir::Stmt* stmt: block->stmts) {
+        if TRY_COERCE (const ir::StmtVarDecl, var_decl, stmt) {
+            rename_expr(region, var_decl->expr);
+
+            auto* decl = ir::as_mutable(var_decl);
+            decl->version = ++region.counters[decl->symbol];
+            define(decl->symbol, decl->version);
+        } else if TRY_COERCE (const ir::StmtExpr, expr_stmt, stmt) {
+            rename_expr(region, expr_stmt->expr);
+        } else if (is_instruction(stmt, OpCode::SAVE)) {
+            auto& snapshot = region.snapshots[stmt];
+            for (auto& [restore, scope]: region.scopes) {
+                if (scope.save != stmt)
+                    continue;
+                for (SymbolId symbol: scope.symbols)
+                    snapshot[symbol] = top_version(region.stacks, symbol);
+            }
+
+            if (auto it = region.loop_vars.find(stmt); it != region.loop_vars.end()) {
+                auto* decl = ir::as_mutable(it->second);
+                decl->version = ++region.counters[decl->symbol];
+                define(decl->symbol, decl->version);
+            }
+        } else if (auto it = region.scopes.find(stmt); it != region.scopes.end()) {
+            auto& snapshot = region.snapshots[it->second.save];
+            for (SymbolId symbol: it->second.symbols)
+                define(symbol, snapshot[symbol]);
+        }
+    }
+
+    if (block->term != nullptr) {
+        ir::for_each_operand(block->term, [&](const ir::Expr* expr) {
+            rename_expr(region, expr);
+        });
+    }
+
+    for (size_t succ: cfg.succs(id)) {
+        for (ir::StmtPhi* phi: region.phis[succ]) {
+            for (auto& operand: phi->operands) {
+                if (operand.pred == block)
+                    operand.version = top_version(region.stacks, phi->symbol);
+            }
+        }
+    }
+
+    for (size_t child: cfg.children(id))
+        rename(region, child);
+
+    for (SymbolId symbol: pushed)
+        region.stacks[symbol].pop_back();
+}
+
+// A phi whose operands are all the same version (ignoring itself and undefined
+// edges) is replaced by that version. Most joins are trivial since scoped
+// declarations are restored before the scope is left.
+void via::SSABuilder::remove_trivial_phis(Region& region) noexcept
+{
+    auto resolve = [&](SymbolId symbol, size_t version) {
+        auto& renames = region.renames[symbol];
+        for (auto it = renames.find(version); it != renames.end();
+             it = renames.find(version)) {
+            version = it->second;
+        }
+        return version;
+    };
+
+    for (bool changed = true; changed;) {
+        changed = false;
+
+        for (size_t id = 0; id < region.phis.size(); id++) {
+            for (ir::StmtPhi*& phi: region.phis[id]) {
+                if (phi == nullptr)
+                    continue;
+
+                size_t unique = 0;
+                bool trivial = true;
+
+                for (const auto& operand: phi->operands) {
+                    size_t version = resolve(phi->symbol, operand.version);
+                    if (version == 0 || version == phi->version || version == unique)
+                        continue;
+                    if (unique != 0) {
+                        trivial = false;
+                        break;
+                    }
+                    unique = version;
+                }
+
+                if (!trivial)
+                    continue;
+
+                region.renames[phi->symbol][phi->version] = unique;
+
+                auto& stmts = region.cfg.block(id)->stmts;
+                stmts.erase(std::find(stmts.begin(), stmts.end(), phi));
+                phi = nullptr;
+                changed = true;
+            }
+        }
+    }
+
+    for (auto& phis: region.phis) {
+        for (ir::StmtPhi* phi: phis) {
+            if (phi == nullptr)
+                continue;
+            for (auto& operand: phi->operands)
+                operand.version = resolve(phi->symbol, operand.version);
+        }
+    }
+
+    for (size_t id = 0; id < region.cfg.size(); id++) {
+        ir::StmtBlock* block = region.cfg.block(id);
+        for (const ir::Stmt* stmt: block->stmts) {
+            ir::for_each_operand(stmt, [&](const ir::Expr* expr) {
+                apply_renames(region, expr);
+            });
+        }
+
+        if (block->term != nullptr) {
+            ir::for_each_operand(block->term, [&](const ir::Expr* expr) {
+                apply_renames(region, expr);
+            });
+        }
+    }
+}
+
+void via::SSABuilder::apply_renames(Region& region, const ir::Expr* expr) noexcept
+{
+    if (expr == nullptr)
+        return;
+
+    if TRY_COERCE (const ir::ExprSymbol, symbol, expr) {
+        auto it = region.renames.find(symbol->symbol);
+        if (it == region.renames.end())
+            return;
+
+        size_t version = symbol->version;
+        for (auto rename = it->second.find(version); rename != it->second.end();
+             rename = it->second.find(version)) {
+            version = rename->second;
+        }
+
+        ir::as_mutable(symbol)->version = version;
+        return;
+    }
+
+    ir::for_each_operand(expr, [&](const ir::Expr* child) {
+        apply_renames(region, child);
+    });
+}
+
+// Out-of-SSA translation. A phi that merges distinct versions gets a slot of its
+// own, declared in the immediate dominator of its block, and every edge into the
+// block stores the operand flowing along it into that slot. Only uses of the phi
+// read the slot, so the stores may be made before a branch that can also go
+// elsewhere, unless that other successor is dominated by the block (a loop exit
+// leaving from the latch, say). Such an edge gets a block of its own instead.
+void via::SSABuilder::destruct_region(const IRTree& tree) noexcept
+{
+    auto& alloc = m_module->allocator();
+    ir::ControlFlowGraph cfg(alloc, m_next_id, tree);
+
+    // Stores to make at the end of each block, and on each edge that needs a block
+    std::map<size_t, std::vector<ir::StmtCopy::Move>> tails;
+    std::map<std::pair<size_t, size_t>, std::vector<ir::StmtCopy::Move>> edges;
+
+    for (size_t id = 0; id < cfg.size(); id++) {
+        auto& stmts = cfg.block(id)->stmts;
+        std::vector<const ir::StmtPhi*> phis;
+        std::erase_if(stmts, [&](const ir::Stmt* stmt) {
+            if TRY_COERCE (const ir::StmtPhi, phi, stmt) {
+                phis.push_back(phi);
+                return true;
+            }
+            return false;
+        });
+
+        for (const ir::StmtPhi* phi: phis) {
+            // Later passes may have made the phi trivial by rewriting its operands
+            size_t unique = 0;
+            bool trivial = true;
+            for (const auto& operand: phi->operands) {
+                if (operand.version == 0 || operand.version == phi->version ||
+                    operand.version == unique)
+                    continue;
+                trivial = trivial && unique == 0;
+                unique = operand.version;
+            }
+
+            if (trivial)
+                continue;
+
+            size_t dom = cfg.idom(id);
+            debug::require(dom != ir::ControlFlowGraph::NONE, "phi node at region entry");
+
+            auto* nil = alloc.emplace<ir::ExprConstant>();
+            nil->loc = phi->loc;
+            nil->type = phi->type;
+
+            auto* slot = alloc.emplace<ir::StmtVarDecl>();
+            slot->loc = phi->loc;
+            slot->symbol = phi->symbol;
+            slot->version = phi->version;
+            slot->expr = nil;
+            slot->type = phi->type;
+
+            auto& dom_stmts = cfg.block(dom)->stmts;
+            dom_stmts.insert(dom_stmts.begin() + cfg.head_size(dom), slot);
+
+            for (const auto& operand: phi->operands) {
+                if (operand.version == 0 || operand.version == phi->version)
+                    continue;
+
+                auto* src = alloc.emplace<ir::ExprSymbol>();
+                src->loc = phi->loc;
+                src->symbol = phi->symbol;
+                src->version = operand.version;
+                src->type = phi->type;
+
+                size_t pred = cfg.index_of(operand.pred);
+                bool split = std::ranges::any_of(cfg.succs(pred), [&](size_t succ) {
+                    return succ != id && cfg.dominates(id, succ);
+                });
+
+                if (split)
+                    edges[{pred, id}].push_back({slot, src});
+                else
+                    tails[pred].push_back({slot, src});
+            }
+        }
+    }
+
+    for (auto& [pred, moves]: tails) {
+        auto* copy = alloc.emplace<ir::StmtCopy>();
+        copy->loc = cfg.block(pred)->loc;
+        copy->moves = std::move(moves);
+
+        auto& stmts = cfg.block(pred)->stmts;
+        stmts.insert(stmts.begin() + cfg.head_size(pred), copy);
+    }
+
+    for (auto& [edge, moves]: edges) {
+        auto [pred, join] = edge;
+        ir::StmtBlock* from = cfg.block(pred);
+        ir::StmtBlock* to = cfg.block(join);
+
+        // Only conditional branches have two successors that can be told apart
+        auto* branch = dynamic_cast<const ir::TrCondBranch*>(from->term);
+        debug::require(branch != nullptr, "cannot split the edge of a range loop");
+
+        auto* copy = alloc.emplace<ir::StmtCopy>();
+        copy->loc = from->loc;
+        copy->moves = std::move(moves);
+
+        auto* jump = alloc.emplace<ir::TrBranch>();
+        jump->loc = from->loc;
+        jump->target = to;
+
+        auto* block = alloc.emplace<ir::StmtBlock>();
+        block->loc = from->loc;
+        block->id = m_next_id++;
+        block->stmts.push_back(copy);
+        block->term = jump;
+
+        auto* cond_br = ir::as_mutable(branch);
+        if (cond_br->iftrue == to)
+            cond_br->iftrue = block;
+        if (cond_br->iffalse == to)
+            cond_br->iffalse = block;
+
+        // Never falls through, see `Executable::is_out_of_line`
+        from->stmts.push_back(block);
+    }
+}
@@ -0,0 +1,87 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <via/config.hpp>
+#include "cfg.hpp"
+#include "ir.hpp"
+
+namespace via {
+
+class Module;
+class SSABuilder final
+{
+  public:
+    SSABuilder(Module* module)
+        : m_module(module)
+    {}
+
+  public:
+    // Converts the module and every function body in it into SSA form: each
+    // local declaration defines a new version of its symbol, uses are annotated
+    // with the version reaching them and `ir::StmtPhi` nodes are placed at the
+    // joins where more than one version meets.
+    void construct(IRTree& ir_tree) noexcept;
+
+    // Replaces phi nodes with copies on the edges entering their block so the
+    // tree can be lowered. Must run before `Executable::build_from_ir`.
+    void destruct(IRTree& ir_tree) noexcept;
+
+  private:
+    // A SAVE/RESTORE pair and the symbols declared between them
+    struct Scope
+    {
+        const ir::Stmt* save;
+        std::unordered_set<SymbolId> symbols;
+    };
+
+    using Versions = std::unordered_map<SymbolId, std::vector<size_t>>;
+    using Renames = std::unordered_map<SymbolId, std::unordered_map<size_t, size_t>>;
+
+    struct Region
+    {
+        Region(ir::ControlFlowGraph cfg)
+            : cfg(std::move(cfg))
+        {}
+
+        ir::ControlFlowGraph cfg;
+        std::unordered_map<SymbolId, QualType> vars;
+        std::unordered_map<const ir::Stmt*, Scope> scopes; // keyed by RESTORE
+        std::unordered_map<const ir::Stmt*, std::unordered_map<SymbolId, size_t>>
+            snapshots; // keyed by SAVE
+        std::unordered_map<const ir::Stmt*, const ir::StmtVarDecl*>
+            loop_vars; // keyed by the SAVE opening the loop body
+        std::vector<std::vector<ir::StmtPhi*>> phis;
+        std::unordered_map<SymbolId, size_t> counters;
+        Versions stacks;
+        Renames renames;
+    };
+
+  private:
+    void build_region(const IRTree& region) noexcept;
+    void collect(Region& region) noexcept;
+    void place_phis(Region& region) noexcept;
+    void rename(Region& region, size_t id) noexcept;
+    void rename_expr(Region& region, const ir::Expr* expr) noexcept;
+    void remove_trivial_phis(Region& region) noexcept;
+    void apply_renames(Region& region, const ir::Expr* expr) noexcept;
+    void destruct_region(const IRTree& region) noexcept;
+
+  private:
+    Module* m_module;
+    uint32_t m_next_id = 0;
+};
+
+} // namespace via
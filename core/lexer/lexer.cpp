@@ -40,6 +40,7 @@ static constexpr TokenReprPair OPERATORS[] = {
     {"::", COLON_COLON},
     {"->", ARROW},
     {"?", QUESTION},
+    {"#", HASH},
     {"+", OP_PLUS},
     {"-", OP_MINUS},
     {"*", OP_STAR},
@@ -61,6 +61,7 @@ namespace via {
     X(COLON_COLON)                                                                       \
     X(ARROW)                                                                             \
     X(QUESTION)                                                                          \
+    X(HASH)                                                                              \
     X(PAREN_OPEN)                                                                        \
     X(PAREN_CLOSE)                                                                       \
     X(BRACKET_OPEN)                                                                      \
@@ -0,0 +1,329 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "binary.hpp"
+#include <cstring>
+#include <format>
+#include "debug.hpp"
+#include "manager.hpp"
+#include "vm/executable.hpp"
+#include "vm/instruction.hpp"
+
+enum TypeTag : uint8_t
+{
+    NONE,
+    BUILTIN,
+    OPTIONAL,
+    ARRAY,
+    MAP,
+    FUNCTION,
+};
+
+#define OPCODE_NAME(OP) #OP,
+
+static constexpr const char* OPCODE_NAMES[] = {FOR_EACH_OPCODE(OPCODE_NAME)};
+
+#undef OPCODE_NAME
+
+uint64_t via::opcode_set_hash() noexcept
+{
+    // FNV-1a, names are separated so that moving a letter between two
+    // neighbouring opcodes changes the hash
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (const char* name: OPCODE_NAMES) {
+        for (const char* chr = name; *chr != '\0'; chr++) {
+            hash ^= static_cast<uint8_t>(*chr);
+            hash *= 0x100000001B3ULL;
+        }
+        hash ^= static_cast<uint8_t>(' ');
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+void via::BinaryWriter::write_bytes(const void* data, size_t size) noexcept
+{
+    m_body.append(static_cast<const char*>(data), size);
+}
+
+void via::BinaryWriter::write_string(std::string_view str) noexcept
+{
+    write<uint32_t>(str.size());
+    write_bytes(str.data(), str.size());
+}
+
+uint32_t via::BinaryWriter::symbol_index(SymbolId symbol) noexcept
+{
+    auto [it, inserted] = m_symbol_ids.emplace(symbol, m_symbols.size());
+    if (inserted)
+        m_symbols.push_back(symbol);
+    return it->second;
+}
+
+void via::BinaryWriter::write_symbol(SymbolId symbol) noexcept
+{
+    write<uint32_t>(symbol_index(symbol));
+}
+
+void via::BinaryWriter::write_type(QualType type) noexcept
+{
+    const Type* unwrapped = type.unwrap();
+
+    if (unwrapped == nullptr) {
+        write<uint8_t>(TypeTag::NONE);
+    } else if TRY_COERCE (const BuiltinType, builtin, unwrapped) {
+        write<uint8_t>(TypeTag::BUILTIN);
+        write<uint8_t>(static_cast<uint8_t>(builtin->kind()));
+    } else if TRY_COERCE (const OptionalType, optional, unwrapped) {
+        write<uint8_t>(TypeTag::OPTIONAL);
+        write_type(optional->unwrap());
+    } else if TRY_COERCE (const ArrayType, array, unwrapped) {
+        write<uint8_t>(TypeTag::ARRAY);
+        write_type(array->unwrap());
+    } else if TRY_COERCE (const MapType, map, unwrapped) {
+        write<uint8_t>(TypeTag::MAP);
+        write_type(map->key());
+        write_type(map->value());
+    } else if TRY_COERCE (const FunctionType, function, unwrapped) {
+        write<uint8_t>(TypeTag::FUNCTION);
+        write_type(function->returns());
+        write<uint32_t>(function->parameters().size());
+        for (const auto& parm: function->parameters())
+            write_type(parm);
+    } else {
+        debug::unimplemented(std::format("write_type({})", VIA_TYPENAME(*unwrapped)));
+    }
+}
+
+void via::BinaryWriter::write_constant(const ConstValue& cv) noexcept
+{
+    write<uint8_t>(static_cast<uint8_t>(cv.kind()));
+
+    switch (cv.kind()) {
+    case ValueKind::NIL:
+        break;
+    case ValueKind::INT:
+        write(cv.value<ValueKind::INT>());
+        break;
+    case ValueKind::FLOAT:
+        write(cv.value<ValueKind::FLOAT>());
+        break;
+    case ValueKind::BOOL:
+        write<uint8_t>(cv.value<ValueKind::BOOL>());
+        break;
+    case ValueKind::STRING:
+        write_string(cv.value<ValueKind::STRING>());
+        break;
+    default:
+        debug::unimplemented(std::format("write_constant({})", to_string(cv.kind())));
+    }
+}
+
+void via::BinaryWriter::align(size_t alignment) noexcept
+{
+    m_body.resize((m_body.size() + alignment - 1) / alignment * alignment, '\0');
+}
+
+bool via::BinaryWriter::save(std::ostream& os, uint64_t source_hash) const noexcept
+{
+    BinaryHeader header{
+        .magic = config::MAGIC,
+        .version = config::BINARY_VERSION,
+        .reserved = 0,
+        .opcodes = opcode_set_hash(),
+        .source_hash = source_hash,
+    };
+
+    std::string table;
+    auto append = [&table](const void* data, size_t size) {
+        table.append(static_cast<const char*>(data), size);
+    };
+
+    uint32_t count = m_symbols.size();
+    append(&count, sizeof(count));
+
+    for (SymbolId symbol: m_symbols) {
+        auto name = m_symtab.lookup(symbol);
+        if (!name.has_value())
+            return false;
+
+        uint32_t size = name->size();
+        append(&size, sizeof(size));
+        append(name->data(), name->size());
+    }
+
+    // The body starts aligned, so alignment within it holds in the file too
+    table.resize((sizeof(header) + table.size() + 7) / 8 * 8 - sizeof(header), '\0');
+
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    os.write(table.data(), table.size());
+    os.write(m_body.data(), m_body.size());
+    return os.good();
+}
+
+bool via::BinaryReader::read_bytes(void* data, size_t size) noexcept
+{
+    if (size > remaining())
+        return false;
+
+    std::memcpy(data, m_data.data() + m_offset, size);
+    m_offset += size;
+    return true;
+}
+
+std::optional<via::BinaryHeader> via::BinaryReader::read_header() noexcept
+{
+    BinaryHeader header;
+    if (!read(header) || header.magic != config::MAGIC ||
+        header.version != config::BINARY_VERSION || header.opcodes != opcode_set_hash())
+        return std::nullopt;
+
+    uint32_t count;
+    if (!read(count) || count > remaining() / sizeof(uint32_t))
+        return std::nullopt;
+
+    auto& symtab = m_manager.symbol_table();
+    m_symbols.reserve(count);
+
+    for (uint32_t i = 0; i < count; i++) {
+        auto name = read_string();
+        if (!name.has_value())
+            return std::nullopt;
+        m_symbols.push_back(symtab.intern(*name));
+    }
+
+    if (!align(8))
+        return std::nullopt;
+    return header;
+}
+
+std::optional<std::string> via::BinaryReader::read_string() noexcept
+{
+    uint32_t size;
+    if (!read(size) || size > remaining())
+        return std::nullopt;
+
+    std::string str(size, '\0');
+    if (!read_bytes(str.data(), size))
+        return std::nullopt;
+    return str;
+}
+
+std::optional<via::SymbolId> via::BinaryReader::symbol_at(uint32_t index) const noexcept
+{
+    if (index >= m_symbols.size())
+        return std::nullopt;
+    return m_symbols[index];
+}
+
+std::optional<via::SymbolId> via::BinaryReader::read_symbol() noexcept
+{
+    uint32_t index;
+    if (!read(index))
+        return std::nullopt;
+    return symbol_at(index);
+}
+
+std::optional<via::QualType> via::BinaryReader::read_type() noexcept
+{
+    auto& ctx = m_manager.type_context();
+
+    uint8_t tag;
+    if (!read(tag))
+        return std::nullopt;
+
+    switch (tag) {
+    case TypeTag::NONE:
+        return QualType();
+    case TypeTag::BUILTIN: {
+        uint8_t kind;
+        if (!read(kind) || kind > static_cast<uint8_t>(BuiltinKind::STRING))
+            return std::nullopt;
+        return BuiltinType::instance(ctx, static_cast<BuiltinKind>(kind));
+    }
+    case TypeTag::OPTIONAL:
+        if (auto type = read_type())
+            return OptionalType::instance(ctx, *type);
+        return std::nullopt;
+    case TypeTag::ARRAY:
+        if (auto type = read_type())
+            return ArrayType::instance(ctx, *type);
+        return std::nullopt;
+    case TypeTag::MAP: {
+        auto key = read_type();
+        auto value = read_type();
+        if (!key.has_value() || !value.has_value())
+            return std::nullopt;
+        return MapType::instance(ctx, *key, *value);
+    }
+    case TypeTag::FUNCTION: {
+        auto ret = read_type();
+        uint32_t count;
+        if (!ret.has_value() || !read(count) || count > remaining())
+            return std::nullopt;
+
+        std::vector<QualType> parms;
+        for (uint32_t i = 0; i < count; i++) {
+            auto parm = read_type();
+            if (!parm.has_value())
+                return std::nullopt;
+            parms.push_back(*parm);
+        }
+        return FunctionType::instance(ctx, *ret, std::move(parms));
+    }
+    default:
+        return std::nullopt;
+    }
+}
+
+std::optional<via::ConstValue> via::BinaryReader::read_constant() noexcept
+{
+    uint8_t kind;
+    if (!read(kind))
+        return std::nullopt;
+
+    switch (static_cast<ValueKind>(kind)) {
+    case ValueKind::NIL:
+        return ConstValue();
+    case ValueKind::INT: {
+        int64_t integer;
+        if (!read(integer))
+            return std::nullopt;
+        return ConstValue(integer);
+    }
+    case ValueKind::FLOAT: {
+        double_t float_;
+        if (!read(float_))
+            return std::nullopt;
+        return ConstValue(float_);
+    }
+    case ValueKind::BOOL: {
+        uint8_t boolean;
+        if (!read(boolean) || boolean > 1)
+            return std::nullopt;
+        return ConstValue(boolean != 0);
+    }
+    case ValueKind::STRING:
+        if (auto str = read_string())
+            return ConstValue(std::move(*str));
+        return std::nullopt;
+    default:
+        return std::nullopt;
+    }
+}
+
+bool via::BinaryReader::align(size_t alignment) noexcept
+{
+    size_t padding = (alignment - m_offset % alignment) % alignment;
+    if (padding > remaining())
+        return false;
+
+    m_offset += padding;
+    return true;
+}
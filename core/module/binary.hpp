@@ -0,0 +1,147 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <via/config.hpp>
+#include "sema/const.hpp"
+#include "sema/types.hpp"
+#include "symbol.hpp"
+
+namespace via {
+namespace config {
+
+VIA_CONSTANT const char SOURCE_EXTENSION[] = ".via";
+VIA_CONSTANT const char BINARY_EXTENSION[] = ".viac";
+
+// Bumped whenever the layout of compiled module files changes
+VIA_CONSTANT uint16_t BINARY_VERSION = 2;
+
+} // namespace config
+
+// Compiled modules start with this header, followed by the string table of
+// every symbol the module refers to and then the module body. Values are
+// stored in host byte order, a mismatching magic also rejects files written on
+// a host of the other order.
+struct BinaryHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint64_t opcodes; // Hash of the opcode set the bytecode was lowered to
+    uint64_t source_hash;
+};
+
+// Hash of the opcode names in declaration order, any change to the opcode set
+// invalidates compiled modules
+uint64_t opcode_set_hash() noexcept;
+
+class ModuleManager;
+class BinaryWriter final
+{
+  public:
+    BinaryWriter(const SymbolTable& symtab)
+        : m_symtab(symtab)
+    {}
+
+  public:
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    void write(const T& value) noexcept
+    {
+        write_bytes(&value, sizeof(T));
+    }
+
+    void write_bytes(const void* data, size_t size) noexcept;
+    void write_string(std::string_view str) noexcept;
+    void write_type(QualType type) noexcept;
+    void write_constant(const ConstValue& cv) noexcept;
+
+    // Symbol ids are only meaningful within one process, symbols are written
+    // as indices into the string table of the file instead
+    void write_symbol(SymbolId symbol) noexcept;
+    uint32_t symbol_index(SymbolId symbol) noexcept;
+
+    // Pads the body so the next write starts at a multiple of `alignment`
+    void align(size_t alignment) noexcept;
+
+    bool save(std::ostream& os, uint64_t source_hash) const noexcept;
+
+  private:
+    const SymbolTable& m_symtab;
+    std::string m_body;
+    std::vector<SymbolId> m_symbols;
+    std::unordered_map<SymbolId, uint32_t> m_symbol_ids;
+};
+
+// Reads are checked against the size of the input, so a truncated or
+// malformed file fails to load instead of reading past its end. The input is
+// usually a mapped file, which `view` hands out parts of without copying.
+class BinaryReader final
+{
+  public:
+    BinaryReader(std::span<const std::byte> data, ModuleManager& manager)
+        : m_data(data),
+          m_manager(manager)
+    {}
+
+  public:
+    // Reads the header and the string table, interning every symbol
+    std::optional<BinaryHeader> read_header() noexcept;
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    bool read(T& value) noexcept
+    {
+        return read_bytes(&value, sizeof(T));
+    }
+
+    // `count` values of type T in place, or nullptr if they run past the end
+    // of the input or are misaligned for T
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    const T* view(size_t count) noexcept
+    {
+        const std::byte* data = m_data.data() + m_offset;
+        if (count > remaining() / sizeof(T) ||
+            reinterpret_cast<uintptr_t>(data) % alignof(T) != 0)
+            return nullptr;
+
+        m_offset += count * sizeof(T);
+        return reinterpret_cast<const T*>(data);
+    }
+
+    bool read_bytes(void* data, size_t size) noexcept;
+    std::optional<std::string> read_string() noexcept;
+    std::optional<QualType> read_type() noexcept;
+    std::optional<ConstValue> read_constant() noexcept;
+    std::optional<SymbolId> read_symbol() noexcept;
+    std::optional<SymbolId> symbol_at(uint32_t index) const noexcept;
+
+    bool align(size_t alignment) noexcept;
+    size_t remaining() const noexcept { return m_data.size() - m_offset; }
+
+  private:
+    std::span<const std::byte> m_data;
+    ModuleManager& m_manager;
+    size_t m_offset = 0;
+    std::vector<SymbolId> m_symbols;
+};
+
+} // namespace via
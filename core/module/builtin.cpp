@@ -0,0 +1,62 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "builtin.hpp"
+#include "module.hpp"
+
+// The build generates `builtin_modules.inc` when VIA_BUILTIN_STD is enabled,
+// with a `VIA_BUILTIN_MODULE(NAMESPACE, ID)` line for every module it links in
+#ifdef VIA_HAS_BUILTIN_MODULES
+    #define VIA_BUILTIN_MODULE(NS, ID)                                                   \
+        extern "C" const via::NativeModuleInfo* EXPAND_AND_PASTE(                        \
+            VIA_MODULE_ENTRY_PREFIX,                                                     \
+            ID                                                                           \
+        )(via::ModuleManager*);
+    #include "builtin_modules.inc"
+    #undef VIA_BUILTIN_MODULE
+#endif
+
+static constexpr via::BuiltinModule BUILTIN_MODULES[] = {
+#ifdef VIA_HAS_BUILTIN_MODULES
+    #define VIA_BUILTIN_MODULE(NS, ID)                                                   \
+        {#NS "::" #ID, &EXPAND_AND_PASTE(VIA_MODULE_ENTRY_PREFIX, ID)},
+    #include "builtin_modules.inc"
+    #undef VIA_BUILTIN_MODULE
+#endif
+    {}, // Sentinel
+};
+
+const via::BuiltinModule* via::find_builtin_module(std::string_view name) noexcept
+{
+    for (const BuiltinModule* module = BUILTIN_MODULES; module->init; module++) {
+        if (module->name == name)
+            return module;
+    }
+    return nullptr;
+}
+
+uint64_t via::builtin_table_hash() noexcept
+{
+    // FNV-1a, names are separated the same way as in opcode_set_hash
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    auto mix = [&hash](uint8_t byte) {
+        hash ^= byte;
+        hash *= 0x100000001B3ULL;
+    };
+
+    for (size_t i = 0; i < sizeof(config::BUILTIN_VERSION); i++)
+        mix(static_cast<uint8_t>(config::BUILTIN_VERSION >> (i * 8)));
+
+    for (const BuiltinModule* module = BUILTIN_MODULES; module->init; module++) {
+        for (char chr: module->name)
+            mix(static_cast<uint8_t>(chr));
+        mix(' ');
+    }
+    return hash;
+}
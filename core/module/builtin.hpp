@@ -0,0 +1,45 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <via/config.hpp>
+
+namespace via {
+namespace config {
+
+// Bumped whenever a built-in module changes the definitions it exports, which
+// invalidates every cached module compiled against them
+VIA_CONSTANT uint32_t BUILTIN_VERSION = 1;
+
+} // namespace config
+
+class ModuleManager;
+struct NativeModuleInfo;
+
+using BuiltinModuleInit = const NativeModuleInfo* (*) (ModuleManager*);
+
+// Native module linked into the library rather than loaded from a shared object
+struct BuiltinModule
+{
+    std::string_view name; // Import path, e.g. "std::io"
+    BuiltinModuleInit init;
+};
+
+// Returns the built-in module imported as `name`, if there is one. Built-in
+// modules are resolved before any import path is searched.
+const BuiltinModule* find_builtin_module(std::string_view name) noexcept;
+
+// Hash of the built-in module table and its version. Built-in modules have no
+// file a compiled module could record, cached modules are keyed by this instead.
+uint64_t builtin_table_hash() noexcept;
+
+} // namespace via
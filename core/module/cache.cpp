@@ -0,0 +1,253 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "cache.hpp"
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <unordered_set>
+#include "binary.hpp"
+#include "builtin.hpp"
+#include "module.hpp"
+#include "resolve.hpp"
+
+namespace config = via::config;
+
+static constexpr uint64_t FNV_OFFSET = 0xCBF29CE484222325ULL;
+static constexpr uint64_t FNV_PRIME = 0x100000001B3ULL;
+
+// Longest path read from an entry, so a corrupt size does not allocate
+static constexpr uint32_t MAX_PATH_SIZE = 1 << 16;
+
+static void hash_bytes(uint64_t& hash, const void* data, size_t size) noexcept
+{
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<const uint8_t*>(data)[i];
+        hash *= FNV_PRIME;
+    }
+}
+
+template <typename T>
+static void hash_value(uint64_t& hash, const T& value) noexcept
+{
+    hash_bytes(hash, &value, sizeof(T));
+}
+
+static std::optional<uint64_t> hash_file(const std::filesystem::path& path)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open())
+        return std::nullopt;
+
+    uint64_t hash = FNV_OFFSET;
+    char buffer[4096];
+
+    while (ifs.read(buffer, sizeof(buffer)) || ifs.gcount() > 0)
+        hash_bytes(hash, buffer, ifs.gcount());
+
+    if (ifs.bad())
+        return std::nullopt;
+    return hash;
+}
+
+// Every module `module` imports, directly or through other imports, that is
+// backed by a file. Built-in modules are covered by the key instead.
+static void collect_imports(
+    const via::Module& module,
+    std::unordered_set<const via::Module*>& visited,
+    std::vector<const via::Module*>& imports
+)
+{
+    for (const via::Module* import: module.imports()) {
+        if (visited.insert(import).second) {
+            if (import->builtin() == nullptr)
+                imports.push_back(import);
+            collect_imports(*import, visited, imports);
+        }
+    }
+}
+
+// Output flags have no effect on the code produced
+static constexpr uint32_t OUTPUT_FLAGS =
+    via::ModuleFlags::DUMP_EXE | via::ModuleFlags::DUMP_DEFTABLE |
+    via::ModuleFlags::NO_EXECUTION | via::ModuleFlags::LAUNCH_DEBUGGER |
+    via::ModuleFlags::EMIT_BINARY;
+
+uint64_t via::CompileCache::key_of(
+    uint64_t source_hash,
+    ModulePerms perms,
+    ModuleFlags flags,
+    const std::vector<std::filesystem::path>& import_paths
+) const noexcept
+{
+    uint64_t hash = FNV_OFFSET;
+    hash_value(hash, source_hash);
+    hash_value(hash, config::CACHE_VERSION);
+    hash_value(hash, config::BINARY_VERSION);
+    hash_value(hash, opcode_set_hash());
+    hash_value(hash, builtin_table_hash());
+    hash_value(hash, static_cast<uint32_t>(perms));
+    hash_value(hash, static_cast<uint32_t>(flags & ~OUTPUT_FLAGS));
+
+    // Import directories decide which file an import resolves to
+    for (const auto& path: import_paths) {
+        auto str = path.string();
+        hash_bytes(hash, str.data(), str.size() + 1);
+    }
+    return hash;
+}
+
+std::filesystem::path via::CompileCache::path_for(uint64_t key) const
+{
+    return m_directory / std::format("{:016x}{}", key, config::BINARY_EXTENSION);
+}
+
+// Entries are laid out as:
+//
+//   u64 key
+//   u32 count: (u32 size, char[size] path, u64 hash)[count]   imported files
+//   u32 count: (u32 size, char[size] path)[count]             shadowing files
+//   padding to a multiple of 8
+//   compiled module, see Module::load_binary_file
+//
+// Shadowing files are candidates imports were resolved past because they did
+// not exist. One that exists now would be imported instead of the file that
+// was compiled against.
+std::optional<via::CacheEntry> via::CompileCache::open(uint64_t key) const
+{
+    auto file = os::MappedFile::open(path_for(key));
+    if (!file.has_value())
+        return std::nullopt;
+
+    auto bytes = file->bytes();
+    size_t offset = 0;
+
+    auto read = [&](auto& value) {
+        if (sizeof(value) > bytes.size() - offset)
+            return false;
+
+        std::memcpy(&value, bytes.data() + offset, sizeof(value));
+        offset += sizeof(value);
+        return true;
+    };
+
+    auto read_path = [&](std::string& path) {
+        uint32_t size;
+        if (!read(size) || size > MAX_PATH_SIZE || size > bytes.size() - offset)
+            return false;
+
+        path.assign(reinterpret_cast<const char*>(bytes.data() + offset), size);
+        offset += size;
+        return true;
+    };
+
+    uint64_t stored;
+    uint32_t count;
+    if (!read(stored) || stored != key || !read(count))
+        return std::nullopt;
+
+    for (uint32_t i = 0; i < count; i++) {
+        std::string path;
+        uint64_t hash;
+        if (!read_path(path) || !read(hash) || hash_file(path) != hash)
+            return std::nullopt;
+    }
+
+    if (!read(count))
+        return std::nullopt;
+
+    for (uint32_t i = 0; i < count; i++) {
+        std::string path;
+        if (!read_path(path) || m_index.is_file(path))
+            return std::nullopt;
+    }
+
+    offset = (offset + 7) / 8 * 8;
+    if (offset > bytes.size())
+        return std::nullopt;
+    return CacheEntry{std::move(*file), offset};
+}
+
+bool via::CompileCache::store(uint64_t key, const Module& module)
+{
+    std::ostringstream oss(std::ios::out | std::ios::binary);
+    auto write = [&oss](const auto& value) {
+        oss.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    std::unordered_set<const Module*> visited{&module};
+    std::vector<const Module*> imports;
+    collect_imports(module, visited, imports);
+
+    write(key);
+    write(static_cast<uint32_t>(imports.size()));
+
+    for (const Module* import: imports) {
+        auto path = import->path().string();
+        auto hash = hash_file(path);
+        if (!hash.has_value()) {
+            m_stats.failed_writes++;
+            return false;
+        }
+
+        write(static_cast<uint32_t>(path.size()));
+        oss.write(path.data(), path.size());
+        write(*hash);
+    }
+
+    // Visited holds the module itself along with its imports
+    std::unordered_set<std::string> shadowed;
+    for (const Module* visited_module: visited) {
+        for (const auto& path: visited_module->shadowed_imports())
+            shadowed.insert(path.string());
+    }
+
+    write(static_cast<uint32_t>(shadowed.size()));
+    for (const std::string& path: shadowed) {
+        write(static_cast<uint32_t>(path.size()));
+        oss.write(path.data(), path.size());
+    }
+
+    // The compiled module is used in place, it must start aligned
+    size_t size = static_cast<size_t>(oss.tellp());
+    oss << std::string((8 - size % 8) % 8, '\0');
+
+    std::error_code ec;
+    std::filesystem::create_directories(m_directory, ec);
+
+    if (ec || !module.write_binary(oss)) {
+        m_stats.failed_writes++;
+        return false;
+    }
+
+    // Entries are written under a name of their own and renamed into place,
+    // so other processes never open a partial entry. Processes storing the
+    // same key at once each rename a complete one.
+    auto path = path_for(key);
+    auto temp = path;
+    temp += std::format(".{:08x}.tmp", std::random_device{}());
+
+    std::ofstream ofs(temp, std::ios::binary | std::ios::trunc);
+    ofs << oss.str();
+    ofs.close();
+
+    if (ofs.good())
+        std::filesystem::rename(temp, path, ec);
+
+    if (!ofs.good() || ec) {
+        std::filesystem::remove(temp, ec);
+        m_stats.failed_writes++;
+        return false;
+    }
+
+    m_stats.writes++;
+    return true;
+}
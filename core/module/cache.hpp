@@ -0,0 +1,94 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+#include <via/config.hpp>
+#include "support/os/mmap.hpp"
+
+namespace via {
+namespace config {
+
+// Bumped whenever the compiler produces different code for the same source or
+// the layout of entries changes, which invalidates every cached module
+VIA_CONSTANT uint32_t CACHE_VERSION = 2;
+
+} // namespace config
+
+enum class ModuleFlags : uint32_t;
+enum class ModulePerms : uint32_t;
+
+// Counted from every thread compiling modules
+struct CacheStats
+{
+    std::atomic<size_t> hits = 0;
+    std::atomic<size_t> misses = 0;
+    std::atomic<size_t> writes = 0;
+    std::atomic<size_t> failed_writes = 0;
+};
+
+// Mapped entry, the compiled module starts `offset` bytes into it
+struct CacheEntry
+{
+    os::MappedFile file;
+    size_t offset;
+};
+
+class Module;
+class ResolveIndex;
+class CompileCache final
+{
+  public:
+    // Files imports must not resolve to for an entry to be used are looked up
+    // in `index`
+    explicit CompileCache(std::filesystem::path directory, ResolveIndex& index)
+        : m_directory(std::move(directory)),
+          m_index(index)
+    {}
+
+  public:
+    auto& directory() const { return m_directory; }
+    auto& stats() { return m_stats; }
+    auto& stats() const { return m_stats; }
+
+    // Key of the entry compiled from a source with the given hash. Imported
+    // files cannot be known before compiling, entries record the hash of each
+    // and are only opened if all are unchanged. Built-in modules have no file,
+    // the key covers the table they are linked from.
+    uint64_t key_of(
+        uint64_t source_hash,
+        ModulePerms perms,
+        ModuleFlags flags,
+        const std::vector<std::filesystem::path>& import_paths
+    ) const noexcept;
+
+    // Maps the entry for `key` if every file it was compiled against is
+    // unchanged, and every import still resolves to the same file
+    std::optional<CacheEntry> open(uint64_t key) const;
+
+    // Writes `module` as the entry for `key` along with the files it imports,
+    // directly or not
+    bool store(uint64_t key, const Module& module);
+
+  private:
+    std::filesystem::path path_for(uint64_t key) const;
+
+  private:
+    std::filesystem::path m_directory;
+    ResolveIndex& m_index;
+    CacheStats m_stats;
+};
+
+} // namespace via
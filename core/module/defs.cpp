@@ -24,10 +24,10 @@ std::string via::DefParameter::to_string(const SymbolTable& table) const
     );
 }
 
-VIA_NOINLINE via::Def* via::Def::from(ModuleManager& manager, const ir::Stmt* node)
+VIA_NOINLINE via::Def* via::Def::from(ScopedAllocator& alloc, const ir::Stmt* node)
 {
     if TRY_COERCE (const ir::StmtFuncDecl, decl, node) {
-        auto* function = manager.allocator().emplace<FunctionDef>();
+        auto* function = alloc.emplace<FunctionDef>();
         function->kind = ImplKind::SOURCE;
         function->code.source = decl;
         function->ret = decl->ret;
@@ -41,6 +41,18 @@ VIA_NOINLINE via::Def* via::Def::from(ModuleManager& manager, const ir::Stmt* no
         }
         return function;
     }
+
+    if TRY_COERCE (const ir::StmtVarDecl, decl, node) {
+        auto* constant = dynamic_cast<const ir::ExprConstant*>(decl->expr);
+        if (!(decl->attrs & VarAttrs::CONST) || constant == nullptr)
+            return nullptr;
+
+        auto* def = alloc.emplace<ConstantDef>();
+        def->symbol = decl->symbol;
+        def->type = decl->type;
+        def->value = constant->value;
+        return def;
+    }
     return nullptr;
 }
 
@@ -76,6 +88,16 @@ std::string via::FunctionDef::signature(const SymbolTable& table) const
     );
 }
 
+std::string via::ConstantDef::signature(const SymbolTable& table) const
+{
+    return std::format(
+        "const {}: {} = {}",
+        table.lookup(symbol).value_or("<symbol error>"),
+        type.to_string(),
+        value.to_string()
+    );
+}
+
 std::string via::to_string(
     const SymbolTable& table,
     const std::unordered_map<SymbolId, const Def*>& map
@@ -108,6 +130,9 @@ std::string via::to_string(
         if TRY_COERCE (const FunctionDef, function_def, it.second) {
             oss << "function  ";
             oss << "  " << function_def->signature(table) << "\n";
+        } else if TRY_COERCE (const ConstantDef, constant_def, it.second) {
+            oss << "constant  ";
+            oss << "  " << constant_def->signature(table) << "\n";
         } else {
             oss << "unknown   ";
             oss << "address: " << (void*) it.second << "\n";
@@ -51,7 +51,7 @@ struct Def
     virtual std::optional<SymbolId> identity() const = 0;
     virtual std::string signature(const SymbolTable&) const { return "<no identity>"; }
 
-    VIA_NOINLINE static Def* from(ModuleManager& manager, const ir::Stmt* node);
+    VIA_NOINLINE static Def* from(ScopedAllocator& alloc, const ir::Stmt* node);
     VIA_NOINLINE static Def* function(
         ModuleManager& manager,
         std::string name,
@@ -73,6 +73,17 @@ struct FunctionDef: public Def
     std::string signature(const SymbolTable& table) const override;
 };
 
+// Top level `const` declaration initialized with a constant
+struct ConstantDef: public Def
+{
+    SymbolId symbol;
+    QualType type;
+    ConstValue value;
+
+    std::optional<SymbolId> identity() const override { return symbol; }
+    std::string signature(const SymbolTable& table) const override;
+};
+
 std::string to_string(
     const SymbolTable& table,
     const std::unordered_map<SymbolId, const Def*>& map
@@ -0,0 +1,272 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "graph.hpp"
+#include <deque>
+#include "manager.hpp"
+
+std::expected<via::Module*, std::string>
+via::ModuleGraph::load(const char* name, const std::filesystem::path& path)
+{
+    auto root = add(nullptr, nullptr, name, path);
+    if (!root.has_value())
+        return std::unexpected(root.error());
+    if (*root == nullptr)
+        return m_manager.get_module(path);
+
+    // Modules loaded while the graph is discovered or compiled are run with it
+    m_manager.m_deferred = &m_inits;
+    m_paths[path] = *root;
+
+    visit(**root);
+    compile();
+    m_manager.m_deferred = nullptr;
+
+    for (auto& init: m_inits)
+        init();
+
+    if ((*root)->unit.failed)
+        return nullptr;
+    return (*root)->unit.module;
+}
+
+// Creates the node of the module at `path` and parses it in the background.
+// Returns nullptr if the module is loaded already and did not change since.
+std::expected<via::ModuleGraph::Node*, std::string> via::ModuleGraph::add(
+    Module* importee,
+    const ast::StmtImport* decl,
+    const char* name,
+    const std::filesystem::path& path
+)
+{
+    auto file = Module::read_file(path);
+    if (!file.has_value())
+        return std::unexpected(file.error());
+
+    SourceBuffer source(std::move(*file));
+
+    if (Module* loaded = m_manager.get_module(path)) {
+        if (loaded->m_source.hash() == source.hash())
+            return nullptr;
+
+        m_manager.invalidate(loaded);
+    }
+
+    auto* module = Module::create_source(
+        m_manager,
+        importee,
+        name,
+        path,
+        decl,
+        m_perms,
+        m_flags,
+        std::move(source)
+    );
+
+    auto& node = *m_nodes.emplace_back(std::make_unique<Node>(module));
+    module->prepare(node.unit);
+
+    m_manager.thread_pool().submit([this, &node] {
+        node.unit.module->parse(node.unit);
+
+        std::lock_guard lock(m_mutex);
+        node.parsed = true;
+        m_cond.notify_all();
+    });
+
+    return &node;
+}
+
+// Registers the module of `node` and loads its imports depth first, in the
+// order they are written. Imports are visited before the module that imports
+// them, which leaves `m_order` and `m_inits` in the order of a serial load.
+void via::ModuleGraph::visit(Node& node)
+{
+    Module* module = node.unit.module;
+    node.state = State::VISITING;
+
+    {
+        std::unique_lock lock(m_mutex);
+        m_cond.wait(lock, [&node] { return node.parsed; });
+    }
+
+    // Loading a compiled module imported it on its own meanwhile
+    if (m_manager.has_module(module->m_path)) {
+        node.state = State::DONE;
+        return;
+    }
+
+    m_manager.push_module(module);
+
+    std::vector<std::pair<const ast::StmtImport*, ModuleInfo>> imports;
+    if (!node.unit.failed && (module->m_perms & ModulePerms::IMPORT) != 0u) {
+        for (const ast::Stmt* stmt: node.unit.ast) {
+            auto* decl = dynamic_cast<const ast::StmtImport*>(stmt);
+            if (decl == nullptr)
+                continue;
+
+            QualName qual_name;
+            for (const Token* token: decl->path)
+                qual_name.push_back(token->to_string());
+
+            // Unresolved imports are reported when the module is compiled
+            if (auto info = module->resolve_import(qual_name))
+                imports.emplace_back(decl, std::move(*info));
+        }
+    }
+
+    // Start parsing every import before waiting on the first one
+    for (const auto& [decl, info]: imports) {
+        if (info.kind == ModuleKind::SOURCE && !m_paths.contains(info.path)) {
+            auto name = decl->path.back()->to_string();
+            // Unreadable imports are reported when the module is compiled
+            auto import = add(module, decl, name.c_str(), info.path);
+            m_paths[info.path] = import.value_or(nullptr);
+        }
+    }
+
+    for (const auto& [decl, info]: imports) {
+        auto name = decl->path.back()->to_string();
+
+        if (info.kind == ModuleKind::SOURCE) {
+            Node* import = m_paths[info.path];
+            if (import == nullptr)
+                continue;
+
+            // Recursive imports and modules imported again through a diamond
+            // are reported when the module is compiled
+            if (import->state == State::NEW)
+                visit(*import);
+            if (import->state != State::DONE ||
+                m_manager.get_module(info.path) != import->unit.module)
+                continue;
+
+            node.imports.push_back(import);
+            import->dependents.push_back(&node);
+            node.pending++;
+            continue;
+        }
+
+        // Compiled and native modules are loaded here, their allocations are
+        // bound to this thread
+        std::expected<Module*, std::string> result;
+        if (info.kind == ModuleKind::BINARY) {
+            result = Module::load_binary_file(
+                m_manager,
+                module,
+                name.c_str(),
+                info.path,
+                decl,
+                m_perms,
+                m_flags
+            );
+        } else {
+            result = Module::load_native_object(
+                m_manager,
+                module,
+                name.c_str(),
+                info.path,
+                decl,
+                m_perms,
+                m_flags,
+                info.builtin
+            );
+        }
+
+        if (!result.has_value()) {
+            node.unit.diags.report<Level::ERROR>(decl->loc, result.error());
+            node.unit.failed = true;
+        }
+    }
+
+    node.state = State::DONE;
+    m_order.push_back(&node);
+    m_inits.push_back([this, &node] { run(node); });
+}
+
+// Restores or compiles every module of the graph, each once its imports are
+void via::ModuleGraph::compile()
+{
+    // Modules compiled from source inline from the IR of their imports, so a
+    // module is only restored if every module importing it is. Importers come
+    // after their imports in `m_order`.
+    for (auto it = m_order.rbegin(); it != m_order.rend(); ++it) {
+        Node& node = **it;
+        node.restorable = node.unit.cache_key.has_value();
+
+        for (Node* dependent: node.dependents)
+            node.restorable = node.restorable && dependent->restorable;
+        if (node.restorable)
+            node.unit.entry = m_manager.cache()->open(*node.unit.cache_key);
+        node.restorable = node.unit.entry.has_value();
+    }
+
+    std::deque<Node*> done; // Guarded by `m_mutex`
+    auto finished = [this, &done](Node& node) {
+        std::lock_guard lock(m_mutex);
+        done.push_back(&node);
+        m_cond.notify_all();
+    };
+
+    auto start = [&](Node& node) {
+        Module* module = node.unit.module;
+        if (node.unit.failed) {
+            finished(node);
+            return;
+        }
+
+        // A module that failed to restore allocated on this thread already
+        bool probed = node.unit.entry.has_value();
+        if (module->restore(node.unit)) {
+            node.restored = true;
+            finished(node);
+        } else if (probed) {
+            module->compile(node.unit);
+            finished(node);
+        } else {
+            m_manager.thread_pool().submit([module, &node, &finished] {
+                module->compile(node.unit);
+                finished(node);
+            });
+        }
+    };
+
+    for (Node* node: m_order) {
+        if (node->pending == 0)
+            start(*node);
+    }
+
+    for (size_t remaining = m_order.size(); remaining > 0; remaining--) {
+        Node* node;
+        {
+            std::unique_lock lock(m_mutex);
+            m_cond.wait(lock, [&done] { return !done.empty(); });
+            node = done.front();
+            done.pop_front();
+        }
+
+        for (Node* dependent: node->dependents) {
+            if (--dependent->pending == 0)
+                start(*dependent);
+        }
+    }
+}
+
+void via::ModuleGraph::run(Node& node)
+{
+    Module* module = node.unit.module;
+    if (node.restored) {
+        module->run_restored();
+        return;
+    }
+
+    if (!node.unit.failed)
+        module->initialize();
+    module->finish(node.unit);
+}
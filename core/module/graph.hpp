@@ -0,0 +1,125 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <via/config.hpp>
+#include "cache.hpp"
+#include "diagnostics.hpp"
+#include "lexer/lexer.hpp"
+#include "module.hpp"
+#include "parser/parser.hpp"
+
+namespace via {
+
+class ModuleManager;
+
+// What loading a source module produces on the way to running it. The lexer
+// and parser own the tokens and nodes, they live as long as the unit.
+struct SourceUnit
+{
+    explicit SourceUnit(Module* module)
+        : module(module),
+          diags(module->path().string(), module->name(), module->source())
+    {}
+
+    NO_COPY(SourceUnit);
+    NO_MOVE(SourceUnit);
+
+    Module* module;
+    DiagContext diags;
+    std::optional<Lexer> lexer;
+    std::optional<Parser> parser;
+    TokenTree ttree;
+    SyntaxTree ast;
+    std::optional<uint64_t> cache_key;
+    std::optional<CacheEntry> entry; // Compiled module to restore, if any
+    bool failed = false;
+};
+
+// Loads a source module along with every source module it imports, directly or
+// not. Imports are parsed and compiled on the manager's thread pool, each once
+// all of its own imports are compiled. Modules are run on the calling thread
+// afterwards, in the order loading them one after another would have.
+class ModuleGraph final
+{
+  public:
+    ModuleGraph(ModuleManager& manager, ModulePerms perms, ModuleFlags flags)
+        : m_manager(manager),
+          m_perms(perms),
+          m_flags(flags)
+    {}
+
+    NO_COPY(ModuleGraph);
+    NO_MOVE(ModuleGraph);
+
+  public:
+    std::expected<Module*, std::string>
+    load(const char* name, const std::filesystem::path& path);
+
+  private:
+    enum class State : uint8_t
+    {
+        NEW,
+        VISITING,
+        DONE,
+    };
+
+    struct Node
+    {
+        explicit Node(Module* module)
+            : unit(module)
+        {}
+
+        SourceUnit unit;
+        State state = State::NEW;
+        bool parsed = false;     // Guarded by `m_mutex`
+        bool restorable = false; // Restored along with every module importing it
+        bool restored = false;
+        size_t pending = 0; // Imports not compiled yet
+        std::vector<Node*> imports;
+        std::vector<Node*> dependents;
+    };
+
+    std::expected<Node*, std::string> add(
+        Module* importee,
+        const ast::StmtImport* decl,
+        const char* name,
+        const std::filesystem::path& path
+    );
+
+    void visit(Node& node);
+    void compile();
+    void run(Node& node);
+
+  private:
+    ModuleManager& m_manager;
+    ModulePerms m_perms;
+    ModuleFlags m_flags;
+    std::vector<std::unique_ptr<Node>> m_nodes;
+    std::unordered_map<std::filesystem::path, Node*> m_paths;
+    std::vector<Node*> m_order; // Post-order, imports before their importers
+    std::vector<std::function<void()>> m_inits;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+};
+
+} // namespace via
@@ -9,9 +9,17 @@
 
 #pragma once
 
+#include <algorithm>
 #include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <via/config.hpp>
+#include "cache.hpp"
 #include "module.hpp"
+#include "resolve.hpp"
+#include "support/thread_pool.hpp"
 #include "symbol.hpp"
 
 namespace via {
@@ -20,6 +28,7 @@ class ModuleManager
 {
   public:
     friend class Module;
+    friend class ModuleGraph;
 
   public:
     auto& allocator() { return m_alloc; }
@@ -27,21 +36,111 @@ class ModuleManager
     auto& symbol_table() { return m_symbol_table; }
     auto get_import_paths() const { return m_import_paths; }
 
-    void push_module(Module* module) { m_modules[module->m_path] = module; }
-    auto* get_module(std::filesystem::path name) { return m_modules[name]; }
-    bool has_module(std::filesystem::path name)
+    // Compiled modules are looked up in and written to the cache, if one is set.
+    // The listings of import directories are kept along with it.
+    CompileCache* cache() { return m_cache ? &*m_cache : nullptr; }
+    void set_cache(std::filesystem::path directory)
     {
+        m_index.load(directory / config::RESOLVE_INDEX_NAME);
+        m_cache.emplace(std::move(directory), m_index);
+    }
+
+    ResolveIndex& resolve_index() { return m_index; }
+
+    // Runtime profiles are recorded to and read from this directory
+    auto& profile_dir() const { return m_profile_dir; }
+    void set_profile_dir(std::filesystem::path directory)
+    {
+        m_profile_dir = std::move(directory);
+    }
+
+    // Threads compiling source modules, one compiles them as they are imported
+    size_t jobs() const { return m_jobs; }
+    void set_jobs(size_t jobs) { m_jobs = std::max<size_t>(jobs, 1); }
+
+    ThreadPool& thread_pool()
+    {
+        if (!m_pool.has_value())
+            m_pool.emplace(m_jobs);
+        return *m_pool;
+    }
+
+    void push_module(Module* module)
+    {
+        std::unique_lock lock(m_mutex);
+        if (module->m_builtin != nullptr)
+            m_builtins[module->m_builtin] = module;
+        else
+            m_modules[module->m_path] = module;
+    }
+
+    Module* get_module(const std::filesystem::path& name)
+    {
+        std::shared_lock lock(m_mutex);
+        auto it = m_modules.find(name);
+        return it != m_modules.end() ? it->second : nullptr;
+    }
+
+    // Built-in modules have no path, they are registered by table entry
+    Module* get_builtin(const BuiltinModule* builtin)
+    {
+        std::shared_lock lock(m_mutex);
+        auto it = m_builtins.find(builtin);
+        return it != m_builtins.end() ? it->second : nullptr;
+    }
+
+    bool has_module(const std::filesystem::path& name)
+    {
+        std::shared_lock lock(m_mutex);
         return m_modules.find(name) != m_modules.end();
     }
 
-    void push_import_path(std::filesystem::path path) { m_import_paths.push_back(path); }
+    void push_import_path(std::filesystem::path path)
+    {
+        m_import_paths.push_back(path);
+
+        // Imports resolved before may resolve to the new path now
+        std::lock_guard lock(m_resolved_mutex);
+        m_resolved.clear();
+    }
+
+    // Imports resolve the same from every module, each is resolved once
+    std::optional<ModuleInfo> get_resolved(const std::string& name)
+    {
+        std::lock_guard lock(m_resolved_mutex);
+        auto it = m_resolved.find(name);
+        if (it == m_resolved.end())
+            return std::nullopt;
+        return it->second;
+    }
+
+    void push_resolved(const std::string& name, const ModuleInfo& info)
+    {
+        std::lock_guard lock(m_resolved_mutex);
+        m_resolved.emplace(name, info);
+    }
+
+    // Unregisters `module` and every module that depends on it, so that each is
+    // compiled again when next imported
+    void invalidate(Module* module)
+    {
+        std::unique_lock lock(m_mutex);
+        invalidate_locked(module);
+    }
+
     Module* get_module_by_name(std::string name)
     {
+        std::shared_lock lock(m_mutex);
         for (const auto& [_, module]: m_modules) {
             if (module->m_name == name) {
                 return module;
             }
         }
+        for (const auto& [_, module]: m_builtins) {
+            if (module->m_name == name) {
+                return module;
+            }
+        }
         return nullptr;
     }
 
@@ -57,26 +156,102 @@ class ModuleManager
     }
 
   protected:
-    bool is_current_import(const std::string& name) const
+    // Whether a module named `name` is being loaded by `importee` or by one of
+    // the modules that, directly or not, imported it
+    static bool is_current_import(const Module* importee, const std::string& name)
     {
-        return std::find(m_imports.begin(), m_imports.end(), name) != m_imports.end();
+        for (const Module* module = importee; module; module = module->m_importee) {
+            if (module->m_name == name)
+                return true;
+        }
+        return false;
     }
 
-    void push_import(const std::string& name) { m_imports.push_back(name); }
-    void pop_import()
+    // Records that `dependent` imports `module`
+    void add_dependent(Module* module, Module* dependent)
     {
-        if (!m_imports.empty()) {
-            m_imports.pop_back();
-        }
+        std::unique_lock lock(m_mutex);
+        module->m_dependents.push_back(dependent);
+    }
+
+    // Leaves running `init` to the module graph being loaded, if any. Modules
+    // of a graph are run once all of it is compiled, in the order a serial load
+    // would have run them.
+    bool defer(std::function<void()> init)
+    {
+        if (m_deferred == nullptr)
+            return false;
+
+        m_deferred->push_back(std::move(init));
+        return true;
+    }
+
+    // Machine module initializers run on, shared by every module. Modules run
+    // one after another once their imports are loaded, never from inside
+    // another one, so it is never re-entered.
+    VirtualMachine& acquire_runtime(Module* module, const Executable* exe)
+    {
+        debug::require(!m_runtime_busy, "runtime re-entered");
+
+        if (m_runtime.has_value())
+            m_runtime->load(module, exe);
+        else
+            m_runtime.emplace(module, exe);
+
+        m_runtime_busy = true;
+        return *m_runtime;
+    }
+
+    // Nothing reads the locals of a module once its initializer returned, they
+    // are popped so the stack does not grow with every module run
+    void release_runtime()
+    {
+        m_runtime->unload();
+        m_runtime_busy = false;
+    }
+
+  private:
+    void invalidate_locked(Module* module)
+    {
+        size_t erased = module->m_builtin != nullptr
+                            ? m_builtins.erase(module->m_builtin)
+                            : m_modules.erase(module->m_path);
+        if (erased == 0)
+            return;
+
+        // A module compiled again is a new one, which registers as a dependent
+        // of its imports anew
+        for (Module* import: module->m_imports)
+            std::erase(import->m_dependents, module);
+
+        // Dependents unlink themselves from this list as they are invalidated
+        auto dependents = std::move(module->m_dependents);
+        module->m_dependents.clear();
+        for (Module* dependent: dependents)
+            invalidate_locked(dependent);
     }
 
   private:
     ScopedAllocator m_alloc;
     SymbolTable m_symbol_table;
     TypeContext m_type_ctx;
-    std::vector<std::string> m_imports;
     std::vector<std::filesystem::path> m_import_paths;
+    std::shared_mutex m_mutex; // Guards the module maps and dependency edges
     std::unordered_map<std::filesystem::path, Module*> m_modules;
+    std::unordered_map<const BuiltinModule*, Module*> m_builtins;
+    std::optional<CompileCache> m_cache;
+    ResolveIndex m_index;
+    std::filesystem::path m_profile_dir;
+    std::mutex m_resolved_mutex; // Guards `m_resolved`
+    std::unordered_map<std::string, ModuleInfo> m_resolved;
+    std::vector<std::function<void()>>* m_deferred = nullptr;
+    size_t m_jobs = 1;
+    std::optional<VirtualMachine> m_runtime; // Only used on the main thread
+    bool m_runtime_busy = false;
+
+    // Destroyed first, modules compiled by its workers are allocated from heaps
+    // those workers own
+    std::optional<ThreadPool> m_pool;
 };
 
 } // namespace via
@@ -12,8 +12,19 @@
 #include <format>
 #include <fstream>
 #include <iostream>
+#include <random>
+#include "binary.hpp"
+#include "builtin.hpp"
+#include "cache.hpp"
 #include "debug.hpp"
+#include "graph.hpp"
 #include "ir/builder.hpp"
+#include "ir/escape.hpp"
+#include "ir/gvn.hpp"
+#include "ir/inline.hpp"
+#include "ir/loop.hpp"
+#include "ir/purity.hpp"
+#include "ir/ssa.hpp"
 #include "manager.hpp"
 #include "source.hpp"
 #include "support/memory.hpp"
@@ -24,8 +35,8 @@
 
 // Read a file into a string
 // clang-format off
-static std::expected<std::string, std::string>
-read_file(const std::filesystem::path& path)
+std::expected<std::string, std::string>
+via::Module::read_file(const std::filesystem::path& path)
 {
     std::ifstream ifs(path);
     if (!ifs.is_open()) {
@@ -53,31 +64,33 @@ std::expected<via::Module*, std::string> via::Module::load_native_object(
     const std::filesystem::path& path,
     const ast::StmtImport* ast_decl,
     const ModulePerms perms,
-    const ModuleFlags flags
+    const ModuleFlags flags,
+    const BuiltinModule* builtin
 )
 {
     // Check if the module is being recursively imported
-    if (manager.is_current_import(name)) {
+    if (manager.is_current_import(importee, name)) {
         return std::unexpected("Recursive import detected");
     }
 
-    // Push the module as an import
-    manager.push_import(name);
-
     // Check if the module is already loaded
-    if (manager.has_module(name)) {
-        // Check if the cached module is the same as the one being imported
-        if (Module* module = manager.get_module(name); module->m_path == path) {
-            manager.pop_import(); // Pop the import stack
-            return module;        // Return the cached module
+    Module* loaded = builtin ? manager.get_builtin(builtin) : manager.get_module(path);
+    if (loaded != nullptr) {
+        return loaded;
+    }
+
+    // Built-in modules are linked in already, there is no library to load
+    os::DynamicLibrary dll;
+
+    if (builtin == nullptr) {
+        auto result = os::DynamicLibrary::load_library(path);
+        if (!result.has_value()) {
+            return std::unexpected(result.error());
         }
+        dll = std::move(*result);
     }
 
     auto& alloc = manager.allocator();
-    auto dll = os::DynamicLibrary::load_library(path);
-    if (!dll.has_value()) {
-        return std::unexpected(dll.error());
-    }
 
     // Instantiate the module
     auto* module = alloc.emplace<Module>(manager, SourceBuffer{});
@@ -87,24 +100,29 @@ std::expected<via::Module*, std::string> via::Module::load_native_object(
     module->m_flags = flags;
     module->m_name = name;
     module->m_path = path;
+    module->m_builtin = builtin;
     module->m_ast_decl = ast_decl;
 
     // Register the module with the manager
     manager.push_module(module);
 
-    // Find the module's entry point
-    auto symbol = std::format("{}{}", config::MODULE_ENTRY_PREFIX, name);
-    auto callback = dll->load_symbol<NativeModuleInitCallback>(symbol.c_str());
-    if (!callback.has_value()) {
-        return std::unexpected(
-            std::format("Failed to load native module: {}", callback.error())
-        );
-    }
-
-    module->m_dl = std::move(*dll);
-
     // Retrieve module information
-    auto* module_info = (*callback)(&manager);
+    const NativeModuleInfo* module_info;
+    if (builtin != nullptr) {
+        module_info = builtin->init(&manager);
+    } else {
+        // Find the module's entry point
+        auto symbol = std::format("{}{}", config::MODULE_ENTRY_PREFIX, name);
+        auto callback = dll.load_symbol<NativeModuleInitCallback>(symbol.c_str());
+        if (!callback.has_value()) {
+            return std::unexpected(
+                std::format("Failed to load native module: {}", callback.error())
+            );
+        }
+
+        module->m_dl = std::move(dll);
+        module_info = (*callback)(&manager);
+    }
 
     // Validate module information
     debug::require(module_info->span.size() != 0);
@@ -120,13 +138,171 @@ std::expected<via::Module*, std::string> via::Module::load_native_object(
         std::cout << std::format("({}) ", module->m_name)
                   << to_string(module->m_manager.symbol_table(), module->m_defs);
 
-    // Pop import stack
-    manager.pop_import();
     return module;
 }
 
-// Load source file as a module
-std::expected<via::Module*, std::string> via::Module::load_source_file(
+enum class DefTag : uint8_t
+{
+    FUNCTION,
+    CONSTANT,
+};
+
+static void write_def(via::BinaryWriter& writer, const via::Def* def)
+{
+    if TRY_COERCE (const via::FunctionDef, function, def) {
+        writer.write(DefTag::FUNCTION);
+        writer.write_symbol(function->symbol);
+        writer.write_type(function->ret);
+        writer.write<uint32_t>(function->parms.size());
+
+        for (const auto& parm: function->parms) {
+            writer.write_symbol(parm.symbol);
+            writer.write_type(parm.type);
+            writer.write_constant(parm.value);
+        }
+    } else if TRY_COERCE (const via::ConstantDef, constant, def) {
+        writer.write(DefTag::CONSTANT);
+        writer.write_symbol(constant->symbol);
+        writer.write_type(constant->type);
+        writer.write_constant(constant->value);
+    } else {
+        via::debug::unimplemented("write_def");
+    }
+}
+
+// Functions of compiled modules keep their signature, their code is only
+// reachable through the executable
+static const via::Def* read_def(via::ModuleManager& manager, via::BinaryReader& reader)
+{
+    DefTag tag;
+    if (!reader.read(tag))
+        return nullptr;
+
+    if (tag == DefTag::FUNCTION) {
+        auto symbol = reader.read_symbol();
+        auto ret = reader.read_type();
+        uint32_t count;
+        if (!symbol.has_value() || !ret.has_value() || !reader.read(count))
+            return nullptr;
+
+        auto* function = manager.allocator().emplace<via::FunctionDef>();
+        function->kind = via::ImplKind::BINARY;
+        function->code.source = nullptr;
+        function->symbol = *symbol;
+        function->ret = *ret;
+
+        for (uint32_t i = 0; i < count; i++) {
+            auto parm = reader.read_symbol();
+            auto type = reader.read_type();
+            auto value = reader.read_constant();
+            if (!parm.has_value() || !type.has_value() || !value.has_value())
+                return nullptr;
+
+            function->parms.push_back({
+                .symbol = *parm,
+                .type = *type,
+                .value = std::move(*value),
+            });
+        }
+        return function;
+    }
+
+    if (tag == DefTag::CONSTANT) {
+        auto symbol = reader.read_symbol();
+        auto type = reader.read_type();
+        auto value = reader.read_constant();
+        if (!symbol.has_value() || !type.has_value() || !value.has_value())
+            return nullptr;
+
+        auto* constant = manager.allocator().emplace<via::ConstantDef>();
+        constant->symbol = *symbol;
+        constant->type = *type;
+        constant->value = std::move(*value);
+        return constant;
+    }
+    return nullptr;
+}
+
+// Restores the imports, defs and executable of a compiled module. Everything
+// is read before any import is loaded, so a malformed file runs no code.
+//
+// Layout, after the header and string table (see binary.hpp):
+//
+//   u32 count: (u32 parts, string[parts])[count]   import paths
+//   u32 count: def[count]
+//   executable, see Executable::write_binary
+std::optional<std::string> via::Module::read_binary(BinaryReader& reader)
+{
+    if (!reader.read_header())
+        return "file is corrupt or was compiled by an incompatible version";
+
+    uint32_t count;
+    if (!reader.read(count))
+        return "file is truncated";
+
+    std::vector<QualName> import_names;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t parts;
+        if (!reader.read(parts) || parts == 0)
+            return "malformed import table";
+
+        QualName import_path;
+        for (uint32_t j = 0; j < parts; j++) {
+            auto part = reader.read_string();
+            if (!part.has_value())
+                return "malformed import table";
+            import_path.push_back(std::move(*part));
+        }
+        import_names.push_back(std::move(import_path));
+    }
+
+    if (!reader.read(count))
+        return "file is truncated";
+
+    std::unordered_map<SymbolId, const Def*> defs;
+    for (uint32_t i = 0; i < count; i++) {
+        const Def* def = read_def(m_manager, reader);
+        if (def == nullptr)
+            return "malformed def table";
+        if (auto identity = def->identity())
+            defs[*identity] = def;
+    }
+
+    DiagContext diags(m_path.string(), m_name, m_source);
+    Executable* exe = Executable::build_from_binary(this, diags, reader);
+    if (exe == nullptr)
+        return "malformed bytecode";
+
+    // Imported modules are loaded again, GETIMPORT looks them up by name
+    for (const QualName& import_path: import_names) {
+        auto result = import(import_path, nullptr);
+        if (!result.has_value())
+            return result.error();
+        if (*result == nullptr)
+            return std::format("could not import '{}'", to_string(import_path));
+    }
+
+    m_defs = std::move(defs);
+    m_exe = exe;
+    return std::nullopt;
+}
+
+// Runs a module that was not compiled in this process and prints the dumps
+// that do not need its source
+void via::Module::run_restored()
+{
+    initialize();
+
+    if (m_flags & ModuleFlags::DUMP_EXE)
+        std::cout << std::format("({}) ", m_name) << m_exe->to_string() << "\n";
+    if (m_flags & ModuleFlags::DUMP_DEFTABLE)
+        std::cout << std::format("({}) ", m_name)
+                  << to_string(m_manager.symbol_table(), m_defs);
+}
+
+// Load a compiled module. Everything up to and including lowering was done
+// when it was written, loading skips straight to execution.
+std::expected<via::Module*, std::string> via::Module::load_binary_file(
     ModuleManager& manager,
     Module* importee,
     const char* name,
@@ -137,162 +313,450 @@ std::expected<via::Module*, std::string> via::Module::load_source_file(
 )
 {
     // Check if the module is being recursively imported
-    if (manager.is_current_import(name)) {
+    if (manager.is_current_import(importee, name)) {
         return std::unexpected("Recursive import detected");
     }
 
-    // Push import stack
-    manager.push_import(name);
-
     // Check if the module is already loaded
-    if (manager.has_module(name)) {
-        // Check if the loaded module is the same as the one being imported
-        if (Module* module = manager.get_module(name); module->m_path == path) {
-            manager.pop_import(); // Pop the import stack
-            return module;        // Return the cached module
-        }
+    if (Module* loaded = manager.get_module(path)) {
+        return loaded;
     }
 
-    // Read the source file
-    auto file = read_file(path);
-    if (!file.has_value()) {
-        manager.pop_import();
-        return std::unexpected(file.error());
+    auto mapping = os::MappedFile::open(path);
+    if (!mapping.has_value()) {
+        return std::unexpected(mapping.error());
     }
 
     // Instantiate the module
-    auto* module = manager.allocator().emplace<Module>(manager, std::move(*file));
-    module->m_kind = ModuleKind::SOURCE;
+    auto* module = manager.allocator().emplace<Module>(manager, SourceBuffer{});
+    module->m_kind = ModuleKind::BINARY;
     module->m_importee = importee;
     module->m_perms = perms;
     module->m_flags = flags;
     module->m_name = name;
     module->m_path = path;
     module->m_ast_decl = ast_decl;
+    module->m_exe = nullptr;
 
     // Register the module with the manager
     manager.push_module(module);
 
-    // Instantiate diagnostics context
-    DiagContext diags(path.string(), name, module->m_source);
+    // The executable runs from the mapping, which lives as long as the module
+    module->m_mapping = std::move(*mapping);
+
+    BinaryReader reader(module->m_mapping.bytes(), manager);
+    if (auto error = module->read_binary(reader)) {
+        manager.invalidate(module);
+        return std::unexpected(
+            std::format("Failed to load compiled module '{}': {}", path.string(), *error)
+        );
+    }
+
+    if (!manager.defer([module] { module->run_restored(); }))
+        module->run_restored();
+    return module;
+}
+
+bool via::Module::write_binary(std::ostream& os) const
+{
+    if (m_exe == nullptr)
+        return false;
+
+    BinaryWriter writer(m_manager.symbol_table());
+    writer.write<uint32_t>(m_import_names.size());
+
+    for (const QualName& name: m_import_names) {
+        writer.write<uint32_t>(name.size());
+        for (const auto& part: name)
+            writer.write_string(part);
+    }
+
+    writer.write<uint32_t>(m_defs.size());
+    for (const auto& [_, def]: m_defs)
+        write_def(writer, def);
+
+    m_exe->write_binary(writer);
+    return writer.save(os, m_source.hash());
+}
+
+bool via::Module::save_binary(const std::filesystem::path& path) const
+{
+    // Processes running the previous file have it mapped, truncating it would
+    // pull the code from under them. The new file replaces it instead, written
+    // under a name of its own so processes emitting it at once never share one.
+    auto temp = path;
+    temp += std::format(".{:08x}.tmp", std::random_device{}());
+
+    std::ofstream ofs(temp, std::ios::binary | std::ios::trunc);
+    bool written = ofs.is_open() && write_binary(ofs);
+    ofs.close();
+
+    std::error_code ec;
+    if (written && ofs.good())
+        std::filesystem::rename(temp, path, ec);
+
+    if (!written || !ofs.good() || ec) {
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
+
+// Flags needing what is only produced by compiling from source
+static constexpr uint32_t UNCACHED_FLAGS =
+    via::ModuleFlags::DUMP_TTREE | via::ModuleFlags::DUMP_AST |
+    via::ModuleFlags::DUMP_IR | via::ModuleFlags::RECORD_PROFILE |
+    via::ModuleFlags::USE_PROFILE;
+
+via::Module* via::Module::create_source(
+    ModuleManager& manager,
+    Module* importee,
+    const char* name,
+    const std::filesystem::path& path,
+    const ast::StmtImport* ast_decl,
+    const ModulePerms perms,
+    const ModuleFlags flags,
+    SourceBuffer&& source
+)
+{
+    auto* module = manager.allocator().emplace<Module>(manager, std::move(source));
+    module->m_kind = ModuleKind::SOURCE;
+    module->m_importee = importee;
+    module->m_perms = perms;
+    module->m_flags = flags;
+    module->m_name = name;
+    module->m_path = path;
+    module->m_ast_decl = ast_decl;
+    return module;
+}
+
+// Loads the profile the module is optimized with and computes the key of its
+// cache entry
+void via::Module::prepare(SourceUnit& unit)
+{
+    // Profiles recorded against an older revision of the source are ignored
+    auto source_hash = m_source.hash();
+    if (m_flags & ModuleFlags::USE_PROFILE) {
+        auto profile_path = Profile::path_for(m_manager.profile_dir(), m_path);
+        m_profile = Profile::load(profile_path, m_path.string(), source_hash);
+    }
+
+    CompileCache* cache = m_manager.cache();
+    if (cache != nullptr && (m_flags & UNCACHED_FLAGS) == 0) {
+        unit.cache_key =
+            cache->key_of(source_hash, m_perms, m_flags, m_manager.get_import_paths());
+    }
+}
+
+// Restores the module from the cache entry opened for it, if there is one
+bool via::Module::restore(SourceUnit& unit)
+{
+    CompileCache* cache = m_manager.cache();
+
+    if (unit.entry.has_value()) {
+        m_mapping = std::move(unit.entry->file);
+        m_cached = true;
+
+        auto bytes = m_mapping.bytes().subspan(unit.entry->offset);
+        unit.entry.reset();
+
+        BinaryReader reader(bytes, m_manager);
+        if (!read_binary(reader).has_value()) {
+            cache->stats().hits++;
+            return true;
+        }
+
+        m_cached = false;
+        m_mapping = {};
+        m_imports.clear();
+        m_import_names.clear();
+        m_shadowed.clear();
+    }
 
+    if (unit.cache_key.has_value())
+        cache->stats().misses++;
+    return false;
+}
+
+void via::Module::parse(SourceUnit& unit)
+{
     // Instantiate lexer
-    Lexer lexer(module->m_source);
-    auto ttree = lexer.tokenize();
+    unit.lexer.emplace(m_source);
+    unit.ttree = unit.lexer->tokenize();
 
     // Instantiate parser
-    Parser parser(module->m_source, ttree, diags);
-    auto ast = parser.parse();
+    bool lazy = (m_flags & ModuleFlags::LAZY_FUNCTIONS) != 0u;
+    unit.parser.emplace(m_source, unit.ttree, unit.diags, lazy);
+    unit.ast = unit.parser->parse();
 
     // Check for fatal compilation errors
-    bool failed = diags.has_errors();
-    if (failed)
-        goto error;
-
-    {
-        // Instantiate IR builder
-        IRBuilder ir_builder(module, ast, diags);
-        module->m_ir = ir_builder.build();
-
-        // Check for errors during IR building
-        failed = diags.has_errors();
-        if (failed)
-            goto error;
-
-        // Map intermediate representation nodes to definitions
-        for (const auto& node: module->m_ir) {
+    unit.failed = unit.diags.has_errors();
+}
+
+void via::Module::compile(SourceUnit& unit)
+{
+    auto& diags = unit.diags;
+
+    // Instantiate IR builder
+    IRBuilder ir_builder(this, unit.ast, diags);
+    m_ir = ir_builder.build();
+
+    // Check for errors during IR building
+    unit.failed = diags.has_errors();
+    if (unit.failed)
+        return;
+
+    // Substitute small function bodies at their call sites
+    Inliner inliner(this, diags);
+    inliner.run(m_ir);
+
+    // Decide which functions have their results remembered by the VM
+    PurityAnalysis purity(this, diags);
+    purity.run(m_ir);
+
+    // Optimization passes operate on the SSA form of the tree
+    SSABuilder ssa(this);
+    ssa.construct(m_ir);
+
+    LoopOptimizer loop_opt(this);
+    loop_opt.run(m_ir);
+
+    ValueNumbering gvn(this);
+    gvn.run(m_ir);
+
+    ssa.destruct(m_ir);
+
+    // Let scalar temporaries reuse their register storage
+    EscapeAnalysis escape;
+    escape.run(m_ir);
+
+    // Map top level declarations to definitions. The tree is made of blocks,
+    // declarations nested any deeper are not visible to importers.
+    for (const auto& node: m_ir) {
+        auto* block = dynamic_cast<const ir::StmtBlock*>(node);
+        if (block == nullptr)
+            continue;
+
+        for (const ir::Stmt* stmt: block->stmts) {
             // Check if the node has an identity
-            if (auto symbol = node->get_symbol()) {
-                module->m_defs[*symbol] = Def::from(manager, node);
+            if (auto symbol = stmt->get_symbol()) {
+                if (const Def* def = Def::from(m_alloc, stmt))
+                    m_defs[*symbol] = def;
             }
         }
+    }
 
-        // Build executable
-        Executable* exe = Executable::build_from_ir(module, diags, module->m_ir);
-        module->m_exe = exe;
-
-        // Check for the abscence of the no execution flag
-        if ((flags & ModuleFlags::NO_EXECUTION) == 0) {
-            // Initialize the virtual machine
-            VirtualMachine vm(module, exe);
-
-            // Check for debug flag
-            if (flags & ModuleFlags::LAUNCH_DEBUGGER) {
-                Debugger dbg(vm);
-                dbg.register_default_commands();
-                dbg.start();
-            } else {
-                // Run VM in contiguous execution mode
-                vm.execute();
-            }
-        }
+    // Build executable
+    m_exe = Executable::build_from_ir(this, diags, m_ir);
+
+    if (unit.cache_key.has_value() && !diags.has_errors())
+        m_manager.cache()->store(*unit.cache_key, *this);
+
+    // Written before running, so a module that fails at runtime is saved too
+    if ((m_flags & ModuleFlags::EMIT_BINARY) && !diags.has_errors()) {
+        auto binary_path = m_path;
+        binary_path.replace_extension(config::BINARY_EXTENSION);
+        if (!save_binary(binary_path))
+            m_logger.warn("could not write compiled module '{}'", binary_path.string());
     }
+}
 
-error:
-    // Handle diagnostics
-    diags.emit();
-    diags.clear();
+// Runs the module, unless execution is disabled
+void via::Module::initialize()
+{
+    if (m_flags & ModuleFlags::NO_EXECUTION)
+        return;
+
+    auto& vm = m_manager.acquire_runtime(this, m_exe);
+
+    // Check for debug flag
+    if (m_flags & ModuleFlags::LAUNCH_DEBUGGER) {
+        Debugger dbg(vm);
+        dbg.register_default_commands();
+        dbg.start();
+    } else if (m_flags & ModuleFlags::RECORD_PROFILE) {
+        // Counts accumulate over every run against the same source
+        auto profile_path = Profile::path_for(m_manager.profile_dir(), m_path);
+        Profile recorded(m_path.string(), m_source.hash());
+        vm.set_profile(&recorded);
+        vm.execute();
+        vm.set_profile(nullptr);
+
+        if (auto profile = Profile::load(profile_path, m_path.string(), m_source.hash()))
+            recorded.merge(*profile);
+        if (!recorded.save(profile_path))
+            m_logger.warn("could not write profile '{}'", profile_path.string());
+    } else {
+        // Run VM in contiguous execution mode
+        vm.execute();
+    }
 
-    if (flags & ModuleFlags::DUMP_TTREE)
-        std::cout << std::format("({}) ", module->m_name) << to_string(ttree) << "\n";
-    if (flags & ModuleFlags::DUMP_AST)
-        std::cout << std::format("({}) ", module->m_name) << to_string(ast) << "\n";
-    if (flags & ModuleFlags::DUMP_IR)
-        std::cout << std::format("({}) ", module->m_name)
-                  << to_string(manager.symbol_table(), module->m_ir) << "\n";
-    if (flags & ModuleFlags::DUMP_EXE)
-        std::cout << std::format("({}) ", module->m_name)
-                  << (module->m_exe ? module->m_exe->to_string() : "<executable error>")
-                  << "\n";
-    if (flags & ModuleFlags::DUMP_DEFTABLE)
-        std::cout << std::format("({}) ", module->m_name)
-                  << to_string(module->m_manager.symbol_table(), module->m_defs);
+    m_manager.release_runtime();
+}
+
+// Reports diagnostics and prints the dumps asked for
+void via::Module::finish(SourceUnit& unit)
+{
+    unit.diags.emit();
+    unit.diags.clear();
+
+    if (m_flags & ModuleFlags::DUMP_TTREE)
+        std::cout << std::format("({}) ", m_name) << to_string(unit.ttree) << "\n";
+    if (m_flags & ModuleFlags::DUMP_AST)
+        std::cout << std::format("({}) ", m_name) << to_string(unit.ast) << "\n";
+    if (m_flags & ModuleFlags::DUMP_IR)
+        std::cout << std::format("({}) ", m_name)
+                  << to_string(m_manager.symbol_table(), m_ir) << "\n";
+    if (m_flags & ModuleFlags::DUMP_EXE)
+        std::cout << std::format("({}) ", m_name)
+                  << (m_exe ? m_exe->to_string() : "<executable error>") << "\n";
+    if (m_flags & ModuleFlags::DUMP_DEFTABLE)
+        std::cout << std::format("({}) ", m_name)
+                  << to_string(m_manager.symbol_table(), m_defs);
 
     // Handle failed compilation
-    if (failed) {
-        for (Module* module = importee; module != nullptr; module = module->m_importee)
-            module->m_logger.info("Imported by module '{}'", module->m_name);
-        if ((flags & (ModuleFlags::DUMP_TTREE | ModuleFlags::DUMP_AST |
-                      ModuleFlags::DUMP_IR | ModuleFlags::DUMP_EXE)) != 0u)
-            module->m_logger.info("Dump may be invalid due to compilation failure");
-    } else {
-        manager.pop_import();
-        return module;
+    if (unit.failed) {
+        for (Module* module = m_importee; module != nullptr; module = module->m_importee)
+            m_logger.info("Imported by module '{}'", module->m_name);
+        if ((m_flags & (ModuleFlags::DUMP_TTREE | ModuleFlags::DUMP_AST |
+                        ModuleFlags::DUMP_IR | ModuleFlags::DUMP_EXE)) != 0u)
+            m_logger.info("Dump may be invalid due to compilation failure");
     }
-    manager.pop_import();
-    return nullptr;
 }
 
-struct ModuleInfo
+// Load source file as a module
+std::expected<via::Module*, std::string> via::Module::load_source_file(
+    ModuleManager& manager,
+    Module* importee,
+    const char* name,
+    const std::filesystem::path& path,
+    const ast::StmtImport* ast_decl,
+    const ModulePerms perms,
+    const ModuleFlags flags
+)
 {
-    enum class Kind
-    {
-        SOURCE,
-        BINARY,
-        NATIVE,
-    } kind;
-
-    std::filesystem::path path;
-};
+    // The imports of the first module loaded are compiled on worker threads
+    if (importee == nullptr && manager.jobs() > 1) {
+        ModuleGraph graph(manager, perms, flags);
+        return graph.load(name, path);
+    }
+
+    // Check if the module is being recursively imported
+    if (manager.is_current_import(importee, name)) {
+        return std::unexpected("Recursive import detected");
+    }
+
+    // Read the source file
+    auto file = read_file(path);
+    if (!file.has_value()) {
+        return std::unexpected(file.error());
+    }
+
+    SourceBuffer source(std::move(*file));
+
+    // Reuse the loaded module unless its source changed since. Modules that
+    // depend on a changed module may have inlined its code, so they are
+    // compiled again as well.
+    if (Module* loaded = manager.get_module(path)) {
+        if (loaded->m_source.hash() == source.hash()) {
+            return loaded; // Return the cached module
+        }
+
+        manager.invalidate(loaded);
+    }
+
+    // Instantiate the module
+    auto* module = create_source(
+        manager,
+        importee,
+        name,
+        path,
+        ast_decl,
+        perms,
+        flags,
+        std::move(source)
+    );
+
+    // Register the module with the manager
+    manager.push_module(module);
+
+    SourceUnit unit(module);
+    module->prepare(unit);
+
+    // Reuse the module compiled by an earlier run if nothing it was compiled
+    // against changed since. Modules compiled from source inline from the IR
+    // of their imports, so their imports are compiled as well.
+    if (unit.cache_key.has_value() &&
+        (importee == nullptr || importee->m_kind != ModuleKind::SOURCE ||
+         importee->m_cached))
+        unit.entry = manager.cache()->open(*unit.cache_key);
+
+    if (module->restore(unit)) {
+        if (!manager.defer([module] { module->run_restored(); }))
+            module->run_restored();
+        return module;
+    }
+
+    module->parse(unit);
+    if (!unit.failed)
+        module->compile(unit);
+
+    if (!unit.failed && !manager.defer([module] { module->initialize(); }))
+        module->initialize();
+
+    module->finish(unit);
+    if (unit.failed)
+        return nullptr;
+    return module;
+}
 
 struct ModuleCandidate
 {
-    ModuleInfo::Kind kind;
+    via::ModuleKind kind;
     std::string name;
 };
 
-static std::optional<ModuleInfo> resolve_import_path(
-    const std::filesystem::path& root,
-    const via::QualName& path,
-    const via::ModuleManager& manager
-)
+// Whether the compiled module at `path` was built from the source next to it,
+// if there is one. Files of another format or opcode set are never current.
+bool via::Module::is_binary_current(const std::filesystem::path& path)
 {
-    via::debug::require(!path.empty(), "bad import path");
+    std::ifstream ifs(path, std::ios::binary);
+    BinaryHeader header;
+    if (!ifs.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != config::MAGIC ||
+        header.version != config::BINARY_VERSION ||
+        header.opcodes != opcode_set_hash())
+        return false;
+
+    auto source_path = path;
+    source_path.replace_extension(config::SOURCE_EXTENSION);
+
+    auto file = read_file(source_path);
+    if (!file.has_value())
+        return true;
+    return SourceBuffer(std::move(*file)).hash() == header.source_hash;
+}
+
+// Compiled modules are preferred over their source, unless it changed since
+std::optional<via::ModuleInfo> via::Module::resolve_import(const QualName& path) const
+{
+    debug::require(!path.empty(), "bad import path");
+
+    // Built-in modules are looked up by name, without touching the filesystem
+    auto qual_name = to_string(path);
+    if (const BuiltinModule* builtin = find_builtin_module(qual_name))
+        return ModuleInfo{.kind = ModuleKind::NATIVE, .builtin = builtin};
+
+    if (auto resolved = m_manager.get_resolved(qual_name))
+        return resolved;
 
     auto path_slice = path;
     auto& module_name = path_slice.back();
     path_slice.pop_back();
 
+    // Candidates tried so far, a file created at one would shadow the result
+    std::vector<std::filesystem::path> missing;
+
     // Lambda to try candidates in a given base path
     auto try_dir_candidates =
         [&](const std::filesystem::path& dir) -> std::optional<ModuleInfo> {
@@ -302,22 +766,25 @@ static std::optional<ModuleInfo> resolve_import_path(
         }
 
         ModuleCandidate candidates[] = {
-            {ModuleInfo::Kind::SOURCE, module_name + ".via"},
-            {ModuleInfo::Kind::BINARY, module_name + ".viac"},
+            {ModuleKind::BINARY, module_name + ".viac"},
+            {ModuleKind::SOURCE, module_name + ".via"},
 #ifdef VIA_PLATFORM_LINUX
-            {ModuleInfo::Kind::NATIVE, module_name + ".so"},
+            {ModuleKind::NATIVE, module_name + ".so"},
 #elifdef VIA_PLATFORM_WINDOWS
-            {ModuleInfo::Kind::NATIVE, module_name + ".dll"},
+            {ModuleKind::NATIVE, module_name + ".dll"},
 #endif
         };
 
         auto try_path = [&](const std::filesystem::path& candidate,
-                            ModuleInfo::Kind kind) -> std::optional<ModuleInfo> {
-            if (std::filesystem::exists(candidate) &&
-                std::filesystem::is_regular_file(candidate))
-                return ModuleInfo{.kind = kind, .path = candidate};
-            else
-                return std::nullopt;
+                            ModuleKind kind) -> std::optional<ModuleInfo> {
+            if (m_manager.resolve_index().is_file(candidate)) {
+                if (kind == ModuleKind::BINARY && !is_binary_current(candidate))
+                    return std::nullopt;
+                return ModuleInfo{.kind = kind, .path = candidate, .shadowed = missing};
+            }
+
+            missing.push_back(candidate);
+            return std::nullopt;
         };
 
         for (const auto& c: candidates) {
@@ -326,17 +793,23 @@ static std::optional<ModuleInfo> resolve_import_path(
             }
         }
 
-        // Fallback: module in a subfolder "module.via"
-        auto module_path = path / module_name / "module.via";
-        if (auto result = try_path(module_path, ModuleInfo::Kind::SOURCE)) {
+        // Fallback: module in a subfolder "module.viac" or "module.via"
+        auto module_path = path / module_name / "module.viac";
+        if (auto result = try_path(module_path, ModuleKind::BINARY)) {
+            return result;
+        }
+
+        module_path.replace_extension(config::SOURCE_EXTENSION);
+        if (auto result = try_path(module_path, ModuleKind::SOURCE)) {
             return result;
         }
 
         return std::nullopt;
     };
 
-    for (const auto& import_path: manager.get_import_paths()) {
+    for (const auto& import_path: m_manager.get_import_paths()) {
         if (auto result = try_dir_candidates(import_path)) {
+            m_manager.push_resolved(qual_name, *result);
             return result;
         }
     }
@@ -355,7 +828,7 @@ std::optional<const via::Def*> via::Module::lookup(via::SymbolId symbol)
 std::expected<via::Module*, std::string>
 via::Module::import(const QualName& path, const ast::StmtImport* ast_decl)
 {
-    auto module = resolve_import_path(m_path, path, m_manager);
+    auto module = resolve_import(path);
     if (!module.has_value()) {
         return std::unexpected(std::format("Module '{}' not found", to_string(path)));
     }
@@ -364,9 +837,11 @@ via::Module::import(const QualName& path, const ast::StmtImport* ast_decl)
         return std::unexpected("Current module lacks import capabilties");
     }
 
+    std::expected<Module*, std::string> result;
+
     switch (module->kind) {
-    case ModuleInfo::Kind::SOURCE:
-        return Module::load_source_file(
+    case ModuleKind::SOURCE:
+        result = Module::load_source_file(
             m_manager,
             this,
             path.back().c_str(),
@@ -375,8 +850,9 @@ via::Module::import(const QualName& path, const ast::StmtImport* ast_decl)
             m_perms,
             m_flags
         );
-    case ModuleInfo::Kind::NATIVE:
-        return Module::load_native_object(
+        break;
+    case ModuleKind::BINARY:
+        result = Module::load_binary_file(
             m_manager,
             this,
             path.back().c_str(),
@@ -385,7 +861,35 @@ via::Module::import(const QualName& path, const ast::StmtImport* ast_decl)
             m_perms,
             m_flags
         );
+        break;
+    case ModuleKind::NATIVE:
+        result = Module::load_native_object(
+            m_manager,
+            this,
+            path.back().c_str(),
+            module->path,
+            ast_decl,
+            m_perms,
+            m_flags,
+            module->builtin
+        );
+        break;
     default:
         debug::todo("module types");
     }
+
+    // Record the dependency edge, this module may inline definitions of the
+    // imported one
+    if (result.has_value() && *result != nullptr) {
+        m_imports.push_back(*result);
+        m_import_names.push_back(path);
+        m_shadowed.insert(
+            m_shadowed.end(),
+            module->shadowed.begin(),
+            module->shadowed.end()
+        );
+        m_manager.add_dependent(*result, this);
+    }
+
+    return result;
 }
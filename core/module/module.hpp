@@ -20,8 +20,10 @@
 #include "source.hpp"
 #include "support/memory.hpp"
 #include "support/os/dl.hpp"
+#include "support/os/mmap.hpp"
 #include "vm/executable.hpp"
 #include "vm/machine.hpp"
+#include "vm/profile.hpp"
 
 #define VIA_MODULE_ENTRY_PREFIX viainit_
 
@@ -56,13 +58,16 @@ struct NativeModuleInfo
     }
 };
 
+class BinaryReader;
 class ModuleManager;
+struct SourceUnit;
 
 using NativeModuleInitCallback = NativeModuleInfo* (*) (ModuleManager*);
 
 enum class ModuleKind : uint8_t
 {
     SOURCE,
+    BINARY,
     NATIVE,
 };
 
@@ -87,13 +92,35 @@ enum class ModuleFlags : uint32_t
     DUMP_DEFTABLE = 1 << 4,
     NO_EXECUTION = 1 << 5,
     LAUNCH_DEBUGGER = 1 << 6,
+    RECORD_PROFILE = 1 << 7,
+    USE_PROFILE = 1 << 8,
+    EMIT_BINARY = 1 << 9,
+    // Top level function bodies are only parsed and compiled once referenced.
+    // Errors in the bodies of functions nothing references are not reported.
+    LAZY_FUNCTIONS = 1 << 10,
     ALL = 0xFFFFFFFF,
 };
 
+struct BuiltinModule;
+
+// File an import path resolves to. Built-in modules are linked into the
+// library and have no file, `path` is left empty for them.
+struct ModuleInfo
+{
+    ModuleKind kind;
+    std::filesystem::path path;
+    const BuiltinModule* builtin = nullptr;
+
+    // Candidates tried before `path`, in resolution order, that did not exist.
+    // A file created at any of them would be resolved instead.
+    std::vector<std::filesystem::path> shadowed;
+};
+
 class Module final
 {
   public:
     friend class ModuleManager;
+    friend class ModuleGraph;
 
   public:
     explicit Module(ModuleManager& manager, SourceBuffer&& source)
@@ -111,7 +138,7 @@ class Module final
         const ModuleFlags flags = ModuleFlags::NONE
     );
 
-    static std::expected<Module*, std::string> load_native_object(
+    static std::expected<Module*, std::string> load_binary_file(
         ModuleManager& manager,
         Module* importee,
         const char* name,
@@ -121,18 +148,70 @@ class Module final
         const ModuleFlags flags = ModuleFlags::NONE
     );
 
+    // Loads the shared object at `path`, or calls the entry point of `builtin`
+    // if the module is linked in
+    static std::expected<Module*, std::string> load_native_object(
+        ModuleManager& manager,
+        Module* importee,
+        const char* name,
+        const std::filesystem::path& path,
+        const ast::StmtImport* decl,
+        const ModulePerms perms = ModulePerms::NONE,
+        const ModuleFlags flags = ModuleFlags::NONE,
+        const BuiltinModule* builtin = nullptr
+    );
+
   public:
     auto name() const { return m_name; }
     auto kind() const { return m_kind; }
+    auto& path() const { return m_path; }
+    auto builtin() const { return m_builtin; }
+    auto& imports() const { return m_imports; }
+    auto& shadowed_imports() const { return m_shadowed; }
     auto& source() const { return m_source; }
     auto& allocator() { return m_alloc; }
     auto& manager() const { return m_manager; }
     auto ast_decl() const { return m_ast_decl; }
+    const Profile* profile() const { return m_profile ? &*m_profile : nullptr; }
 
     std::optional<const Def*> lookup(SymbolId symbol);
     std::expected<Module*, std::string>
     import(const QualName& path, const ast::StmtImport* ast_decl);
 
+    // Writes the compiled module to `path`, see `load_binary_file`
+    bool save_binary(const std::filesystem::path& path) const;
+    bool write_binary(std::ostream& os) const;
+
+  protected:
+    static std::expected<std::string, std::string>
+    read_file(const std::filesystem::path& path);
+    static bool is_binary_current(const std::filesystem::path& path);
+
+    // Instantiates a source module, registering it is left to the caller
+    static Module* create_source(
+        ModuleManager& manager,
+        Module* importee,
+        const char* name,
+        const std::filesystem::path& path,
+        const ast::StmtImport* decl,
+        const ModulePerms perms,
+        const ModuleFlags flags,
+        SourceBuffer&& source
+    );
+
+    std::optional<ModuleInfo> resolve_import(const QualName& path) const;
+    std::optional<std::string> read_binary(BinaryReader& reader);
+    void run_restored();
+
+    // Steps of loading a source module, see `load_source_file`. Only `parse` and
+    // `compile` may run off the main thread.
+    void prepare(SourceUnit& unit);
+    bool restore(SourceUnit& unit);
+    void parse(SourceUnit& unit);
+    void compile(SourceUnit& unit);
+    void initialize();
+    void finish(SourceUnit& unit);
+
   protected:
     ScopedAllocator m_alloc;
     Logger& m_logger = Logger::stdout_logger(); // TODO: Modularize
@@ -142,14 +221,21 @@ class Module final
     std::string m_name;
     SourceBuffer m_source;
     std::filesystem::path m_path;
+    const BuiltinModule* m_builtin = nullptr; // Linked in, `m_path` is empty
     IRTree m_ir;
     Executable* m_exe;
     std::vector<Module*> m_imports;
+    std::vector<QualName> m_import_names; // Paths `m_imports` were imported by
+    std::vector<std::filesystem::path> m_shadowed; // See `ModuleInfo::shadowed`
+    std::vector<Module*> m_dependents;
     std::unordered_map<SymbolId, const Def*> m_defs;
     Module* m_importee = nullptr;
     ModuleManager& m_manager;
     os::DynamicLibrary m_dl;
+    os::MappedFile m_mapping; // Compiled module the executable runs in place
     const ast::StmtImport* m_ast_decl = nullptr;
+    std::optional<Profile> m_profile; // Drives optimization if USE_PROFILE is set
+    bool m_cached = false;            // Restored from the compile cache
 };
 
 } // namespace via
@@ -0,0 +1,224 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "resolve.hpp"
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include "support/os/mmap.hpp"
+
+// Bumped whenever the layout of the index file changes
+static constexpr uint32_t INDEX_VERSION = 2;
+
+// Coarsest timestamp resolution of the filesystems directories may be on. A
+// file created in the same tick as a listing was taken leaves the modification
+// time of its directory unchanged, listings that recent are not trusted.
+static constexpr auto MTIME_GRANULARITY =
+    std::chrono::duration_cast<std::filesystem::file_time_type::duration>(
+        std::chrono::seconds(2)
+    );
+
+// Longest name read from the index, so a corrupt size does not allocate
+static constexpr uint32_t MAX_NAME_SIZE = 1 << 16;
+
+static std::optional<int64_t> mtime_of(const std::string& path)
+{
+    std::error_code ec;
+    auto time = std::filesystem::last_write_time(path, ec);
+    if (ec)
+        return std::nullopt;
+    return static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+static int64_t now()
+{
+    auto time = std::filesystem::file_time_type::clock::now();
+    return static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+bool via::ResolveIndex::Directory::is_settled() const noexcept
+{
+    return !mtime.has_value() || listed - *mtime > MTIME_GRANULARITY.count();
+}
+
+via::ResolveIndex::~ResolveIndex()
+{
+    if (m_dirty && m_file.has_value())
+        save();
+}
+
+bool via::ResolveIndex::is_file(const std::filesystem::path& path)
+{
+    auto dir = path.parent_path().string();
+    auto name = path.filename().string();
+
+    std::lock_guard lock(m_mutex);
+    const Directory& listing = directory(dir);
+    if (listing.files.contains(name))
+        return true;
+
+    // The file may have been created after the listing, within the same tick
+    if (listing.is_settled())
+        return false;
+
+    std::error_code ec;
+    return std::filesystem::is_regular_file(path, ec);
+}
+
+// Lists `path` unless it was listed already and did not change since. Entries
+// are only added or removed by changing the directory, which updates its
+// modification time. Listings taken within a tick of that time are listed
+// again, a change in the same tick would not have moved it.
+const via::ResolveIndex::Directory& via::ResolveIndex::directory(const std::string& path)
+{
+    auto [it, inserted] = m_dirs.try_emplace(path);
+    Directory& dir = it->second;
+    if (dir.checked)
+        return dir;
+
+    dir.checked = true;
+    auto mtime = mtime_of(path);
+    if (!inserted && mtime == dir.mtime && dir.is_settled())
+        return dir;
+
+    dir.mtime = mtime;
+    dir.listed = now();
+    dir.files.clear();
+    m_dirty = true;
+
+    std::error_code ec;
+    for (const auto& entry: std::filesystem::directory_iterator(path, ec)) {
+        std::error_code file_ec;
+        if (entry.is_regular_file(file_ec))
+            dir.files.insert(entry.path().filename().string());
+    }
+    return dir;
+}
+
+// Files are laid out as:
+//
+//   u32 version
+//   u32 count: (u32 size, char[size] path, u8 exists, i64 mtime, i64 listed,
+//               u32 count: (u32 size, char[size] name)[count])[count]
+void via::ResolveIndex::load(std::filesystem::path file)
+{
+    std::lock_guard lock(m_mutex);
+    m_file = std::move(file);
+
+    auto mapping = os::MappedFile::open(*m_file);
+    if (!mapping.has_value())
+        return;
+
+    auto bytes = mapping->bytes();
+    size_t offset = 0;
+
+    auto read = [&](auto& value) {
+        if (sizeof(value) > bytes.size() - offset)
+            return false;
+
+        std::memcpy(&value, bytes.data() + offset, sizeof(value));
+        offset += sizeof(value);
+        return true;
+    };
+
+    auto read_string = [&](std::string& str) {
+        uint32_t size;
+        if (!read(size) || size > MAX_NAME_SIZE || size > bytes.size() - offset)
+            return false;
+
+        str.assign(reinterpret_cast<const char*>(bytes.data() + offset), size);
+        offset += size;
+        return true;
+    };
+
+    uint32_t version, count;
+    if (!read(version) || version != INDEX_VERSION || !read(count))
+        return;
+
+    // Listings are only kept if the whole file reads back
+    std::unordered_map<std::string, Directory> dirs;
+    for (uint32_t i = 0; i < count; i++) {
+        std::string path;
+        uint8_t exists;
+        int64_t mtime, listed;
+        uint32_t files;
+
+        if (!read_string(path) || !read(exists) || !read(mtime) || !read(listed) ||
+            !read(files))
+            return;
+
+        Directory& dir = dirs[path];
+        dir.listed = listed;
+        if (exists != 0)
+            dir.mtime = mtime;
+
+        for (uint32_t j = 0; j < files; j++) {
+            std::string name;
+            if (!read_string(name))
+                return;
+            dir.files.insert(std::move(name));
+        }
+    }
+
+    // Directories listed by this process already are more recent
+    m_dirs.merge(dirs);
+}
+
+bool via::ResolveIndex::save() const
+{
+    std::ostringstream oss(std::ios::out | std::ios::binary);
+    auto write = [&oss](const auto& value) {
+        oss.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    auto write_string = [&](const std::string& str) {
+        write(static_cast<uint32_t>(str.size()));
+        oss.write(str.data(), str.size());
+    };
+
+    write(INDEX_VERSION);
+    write(static_cast<uint32_t>(m_dirs.size()));
+
+    for (const auto& [path, dir]: m_dirs) {
+        write_string(path);
+        write(static_cast<uint8_t>(dir.mtime.has_value()));
+        write(dir.mtime.value_or(0));
+        write(dir.listed);
+        write(static_cast<uint32_t>(dir.files.size()));
+
+        for (const std::string& name: dir.files)
+            write_string(name);
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(m_file->parent_path(), ec);
+    if (ec)
+        return false;
+
+    // Written under a name of their own and renamed into place, like cache
+    // entries, so other processes never read a partial index
+    auto temp = *m_file;
+    temp += std::format(".{:08x}.tmp", std::random_device{}());
+
+    std::ofstream ofs(temp, std::ios::binary | std::ios::trunc);
+    ofs << oss.str();
+    ofs.close();
+
+    if (ofs.good())
+        std::filesystem::rename(temp, *m_file, ec);
+
+    if (!ofs.good() || ec) {
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,74 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <via/config.hpp>
+#include "support/utility.hpp"
+
+namespace via {
+namespace config {
+
+// Name of the file in the cache directory listings are kept in
+VIA_CONSTANT const char RESOLVE_INDEX_NAME[] = "imports.index";
+
+} // namespace config
+
+// Files of the directories imports are resolved in. A directory is listed the
+// first time a file in it is looked up, instead of probing every candidate
+// path of every import. Listings can be kept in a file across runs, each is
+// checked once per process against the modification time of its directory.
+class ResolveIndex final
+{
+  public:
+    ResolveIndex() = default;
+    ~ResolveIndex();
+
+    NO_COPY(ResolveIndex);
+    NO_MOVE(ResolveIndex);
+
+  public:
+    // Whether `path` names a regular file
+    bool is_file(const std::filesystem::path& path);
+
+    // Reads the listings kept in `file`, which they are written back to on
+    // destruction if any of them changed
+    void load(std::filesystem::path file);
+
+  private:
+    struct Directory
+    {
+        std::optional<int64_t> mtime; // Unset if the directory does not exist
+        int64_t listed = 0;           // When the listing was taken
+        std::unordered_set<std::string> files;
+        bool checked = false; // Listed or checked by this process
+
+        // Whether changes to the directory after it was listed are certain to
+        // have moved its modification time past the one recorded
+        bool is_settled() const noexcept;
+    };
+
+    const Directory& directory(const std::string& path);
+    bool save() const;
+
+  private:
+    std::mutex m_mutex;
+    std::unordered_map<std::string, Directory> m_dirs;
+    std::optional<std::filesystem::path> m_file;
+    bool m_dirty = false;
+};
+
+} // namespace via
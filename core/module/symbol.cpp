@@ -29,15 +29,15 @@ std::string via::SymbolTable::to_string() const noexcept
         ansi::Style::FAINT
     );
 
-    for (const auto& symbol: m_reverse) {
+    for (SymbolId id = 0; id < size(); id++) {
         oss << "   "
             << ansi::format(
-                   std::format("{:0>4}", symbol.first),
+                   std::format("{:0>4}", id),
                    ansi::Foreground::NONE,
                    ansi::Background::NONE,
                    ansi::Style::FAINT
                );
-        oss << "    \"" << symbol.second << "\"\n";
+        oss << "    \"" << lookup(id).value_or("<interning>") << "\"\n";
     }
     oss << "\n";
     return oss.str();
@@ -32,7 +32,7 @@ inline std::string to_string(const QualName& path)
     return oss.str();
 }
 
-class SymbolTable final: public InternTable<std::string, SymbolId>
+class SymbolTable final: public InternTable<SymbolId>
 {
   public:
     using InternTable::intern;
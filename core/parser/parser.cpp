@@ -185,11 +185,41 @@ const via::ast::Parameter* via::Parser::parse_parameter()
     return par;
 }
 
+via::ast::AttributeList via::Parser::parse_attribute_list()
+{
+    ast::AttributeList attrs;
+
+    while (match(HASH)) {
+        SAVE_FIRST()
+
+        ast::Attribute attr;
+        attr.name = expect(IDENTIFIER, "parsing attribute name");
+        attr.loc = {loc.begin, m_source.get_location(*attr.name).end};
+
+        if (optional(PAREN_OPEN)) {
+            while (!match(PAREN_CLOSE)) {
+                if (match(EOF_)) {
+                    expect(PAREN_CLOSE, "terminating attribute argument list");
+                }
+
+                attr.args.push_back(advance());
+            }
+
+            attr.loc.end = m_source.get_location(*advance()).end;
+        }
+
+        attrs.push_back(attr);
+    }
+
+    return attrs;
+}
+
 const via::ast::Scope* via::Parser::parse_scope()
 {
     SAVE_FIRST()
 
     auto scope = m_alloc.emplace<ast::Scope>();
+    m_depth++;
 
     if (first->kind == COLON) {
         scope->stmts.push_back(parse_stmt());
@@ -211,9 +241,52 @@ const via::ast::Scope* via::Parser::parse_scope()
             Footnote(FootnoteKind::HINT, "Expected ':' | '{'")
         );
 
+    m_depth--;
     return scope;
 }
 
+// Skips the braced body of `fn`, leaving it to be parsed once the function is
+// referenced. Bodies without control flow are parsed as usual, importers may
+// inline them.
+bool via::Parser::skip_body(ast::StmtFunctionDecl* fn)
+{
+    const Token* const* cursor = m_cursor;
+    size_t depth = 0;
+    bool control_flow = false;
+
+    do {
+        switch ((*cursor)->kind) {
+        case BRACE_OPEN:
+            depth++;
+            break;
+        case BRACE_CLOSE:
+            depth--;
+            break;
+        case KW_IF:
+        case KW_WHILE:
+        case KW_FOR:
+        case KW_DO:
+        case KW_FN:
+            control_flow = true;
+            break;
+        case EOF_:
+            return false; // Reported when parsed
+        default:
+            break;
+        }
+        cursor++;
+    } while (depth > 0);
+
+    if (!control_flow)
+        return false;
+
+    fn->deferred = m_cursor;
+    fn->body = nullptr;
+    fn->loc.end = m_source.get_location(*cursor[-1]).end;
+    m_cursor = cursor;
+    return true;
+}
+
 const via::ast::ExprLiteral* via::Parser::parse_expr_literal()
 {
     auto* lit = m_alloc.emplace<ast::ExprLiteral>();
@@ -513,6 +586,16 @@ const via::ast::TypeBuiltin* via::Parser::parse_type_builtin()
     return bt;
 }
 
+const via::ast::TypeSymbol* via::Parser::parse_type_symbol()
+{
+    SAVE_FIRST()
+
+    auto* st = m_alloc.emplace<ast::TypeSymbol>();
+    st->symbol = first;
+    st->loc = loc;
+    return st;
+}
+
 const via::ast::TypeArray* via::Parser::parse_type_array()
 {
     SAVE_FIRST();
@@ -572,6 +655,8 @@ const via::ast::Type* via::Parser::parse_type_primary()
     case KW_FLOAT:
     case KW_STRING:
         return (const ast::Type*) parse_type_builtin();
+    case IDENTIFIER:
+        return (const ast::Type*) parse_type_symbol();
     case BRACKET_OPEN:
         return (const ast::Type*) parse_type_array();
     case BRACE_OPEN:
@@ -589,7 +674,7 @@ const via::ast::Type* via::Parser::parse_type_primary()
             Footnote(
                 FootnoteKind::HINT,
                 "Expected 'nil' | 'bool' | 'int' | 'float' | "
-                "'string' | '[' | '{' | 'fn'"
+                "'string' | <identifier> | '[' | '{' | 'fn'"
             )
         );
     }
@@ -646,11 +731,13 @@ done:
     return primary;
 }
 
-const via::ast::StmtVarDecl* via::Parser::parse_stmt_var_decl(bool semicolon)
+const via::ast::StmtVarDecl*
+via::Parser::parse_stmt_var_decl(bool semicolon, ast::AttributeList attrs)
 {
     SAVE_FIRST()
 
     auto vars = m_alloc.emplace<ast::StmtVarDecl>();
+    vars->attrs = std::move(attrs);
     vars->decl = first;
     vars->lval = parse_lvalue();
 
@@ -841,13 +928,23 @@ const via::ast::StmtImport* via::Parser::parse_stmt_import()
     return imp;
 }
 
-const via::ast::StmtFunctionDecl* via::Parser::parse_stmt_func_decl()
+const via::ast::StmtFunctionDecl*
+via::Parser::parse_stmt_func_decl(ast::AttributeList attrs)
 {
     SAVE_FIRST()
 
     auto* fn = m_alloc.emplace<ast::StmtFunctionDecl>();
+    fn->attrs = std::move(attrs);
     fn->name = expect(IDENTIFIER, "parsing function name");
 
+    if (optional(OP_LT)) {
+        do {
+            fn->type_parms.push_back(expect(IDENTIFIER, "parsing type parameter"));
+        } while (optional(COMMA));
+
+        expect(OP_GT, "terminating type parameter list");
+    }
+
     expect(PAREN_OPEN, "parsing function parameter list");
 
     while (!match(PAREN_CLOSE)) {
@@ -869,6 +966,15 @@ const via::ast::StmtFunctionDecl* via::Parser::parse_stmt_func_decl()
         fn->ret = nullptr;
     }
 
+    fn->loc.begin = loc.begin;
+
+    // Top level functions are never run unless something refers to them. Other
+    // bodies may depend on their attributes, type parameters or return type
+    // being known while parsing.
+    if (m_lazy && m_depth == 0 && fn->attrs.empty() && fn->type_parms.empty() &&
+        fn->ret != nullptr && match(BRACE_OPEN) && skip_body(fn))
+        return fn;
+
     fn->body = parse_scope();
     fn->loc = {loc.begin, fn->body->loc.end};
     return fn;
@@ -934,6 +1040,23 @@ const via::ast::Stmt* via::Parser::parse_stmt()
         return (const ast::Stmt*) parse_stmt_struct_decl();
     case KW_TYPE:
         return (const ast::Stmt*) parse_stmt_type_decl();
+    case HASH: {
+        auto attrs = parse_attribute_list();
+
+        switch (peek()->kind) {
+        case KW_VAR:
+        case KW_CONST:
+            return (const ast::Stmt*) parse_stmt_var_decl(true, std::move(attrs));
+        case KW_FN:
+            return (const ast::Stmt*) parse_stmt_func_decl(std::move(attrs));
+        default:
+            throw ParserError(
+                SourceLoc{attrs.front().loc.begin, attrs.back().loc.end},
+                "Attribute list must precede a declaration",
+                Footnote(FootnoteKind::HINT, "Expected 'var' | 'const' | 'fn'")
+            );
+        }
+    }
     case SEMICOLON: {
         auto empty = m_alloc.emplace<ast::StmtEmpty>();
         empty->loc = m_source.get_location(*advance());
@@ -987,11 +1110,24 @@ valid_expr_stmt:
     }
 }
 
+const via::ast::Scope* via::Parser::parse_deferred(const ast::StmtFunctionDecl* fn)
+{
+    m_cursor = fn->deferred;
+
+    try {
+        return parse_scope();
+    } catch (const ParserError& e) {
+        m_diags.report(e.diag);
+        return nullptr;
+    }
+}
+
 via::SyntaxTree via::Parser::parse()
 {
     SyntaxTree nodes;
     while (!match(EOF_)) {
         try {
+            m_depth = 0;
             auto* stmt = parse_stmt();
             nodes.push_back(stmt);
         } catch (const ParserError& e) {
@@ -23,16 +23,34 @@ namespace via {
 class Parser final
 {
   public:
-    Parser(const SourceBuffer& source, const TokenTree& ttree, DiagContext& diags)
+    // A lazy parse skips the bodies of top level functions, see
+    // `parse_stmt_func_decl`
+    Parser(
+        const SourceBuffer& source,
+        const TokenTree& ttree,
+        DiagContext& diags,
+        bool lazy = false
+    )
         : m_diags(diags),
           m_source(source),
-          m_cursor(ttree.data())
+          m_cursor(ttree.data()),
+          m_lazy(lazy)
+    {}
+
+    // Only parses bodies deferred by another parser
+    Parser(const SourceBuffer& source, DiagContext& diags)
+        : m_diags(diags),
+          m_source(source),
+          m_cursor(nullptr)
     {}
 
   public:
     ScopedAllocator& allocator() { return m_alloc; }
     SyntaxTree parse();
 
+    // Parses the body `fn` was declared with, returns nullptr if it is malformed
+    const ast::Scope* parse_deferred(const ast::StmtFunctionDecl* fn);
+
   private:
     bool match(TokenKind kind, int ahead = 0);
     bool optional(TokenKind kind);
@@ -45,7 +63,9 @@ class Parser final
     const ast::Path* parse_static_path();
     const ast::Expr* parse_lvalue();
     const ast::Parameter* parse_parameter();
+    ast::AttributeList parse_attribute_list();
     const ast::Scope* parse_scope();
+    bool skip_body(ast::StmtFunctionDecl* fn);
 
     // Expression
     const ast::ExprLiteral* parse_expr_literal();
@@ -66,6 +86,7 @@ class Parser final
 
     // Types
     const ast::TypeBuiltin* parse_type_builtin();
+    const ast::TypeSymbol* parse_type_symbol();
     const ast::TypeArray* parse_type_array();
     const ast::TypeMap* parse_type_map();
     const ast::TypeFunc* parse_type_function();
@@ -73,7 +94,8 @@ class Parser final
     const ast::Type* parse_type();
 
     // Statement
-    const ast::StmtVarDecl* parse_stmt_var_decl(bool semicolon);
+    const ast::StmtVarDecl*
+    parse_stmt_var_decl(bool semicolon, ast::AttributeList attrs = {});
     const ast::StmtFor* parse_stmt_for();
     const ast::StmtForEach* parse_stmt_for_each();
     const ast::StmtIf* parse_stmt_if();
@@ -82,7 +104,7 @@ class Parser final
     const ast::StmtReturn* parse_stmt_return();
     const ast::StmtEnum* parse_stmt_enum();
     const ast::StmtImport* parse_stmt_import();
-    const ast::StmtFunctionDecl* parse_stmt_func_decl();
+    const ast::StmtFunctionDecl* parse_stmt_func_decl(ast::AttributeList attrs = {});
     const ast::StmtStructDecl* parse_stmt_struct_decl();
     const ast::StmtTypeDecl* parse_stmt_type_decl();
     const ast::Stmt* parse_stmt();
@@ -91,6 +113,8 @@ class Parser final
     DiagContext& m_diags;
     const SourceBuffer& m_source;
     const Token* const* m_cursor;
+    bool m_lazy = false;
+    size_t m_depth = 0; // Scopes the cursor is in
     ScopedAllocator m_alloc;
 };
 
@@ -27,6 +27,12 @@ std::vector<const via::ir::Term*> via::get_control_paths(const ir::StmtBlock* en
         } else if TRY_COERCE (const ir::TrCondBranch, cbr, block->term) {
             dfs(cbr->iftrue);
             dfs(cbr->iffalse);
+        } else if TRY_COERCE (const ir::TrForPrep, prep, block->term) {
+            dfs(prep->body);
+            dfs(prep->exit);
+        } else if TRY_COERCE (const ir::TrForLoop, loop, block->term) {
+            dfs(loop->prep->body);
+            dfs(loop->prep->exit);
         } else {
             debug::bug("unmapped dfs block terminator");
         }
@@ -32,18 +32,21 @@ class BytecodeLocal final
 
   public:
     BytecodeLocal() = default;
-    BytecodeLocal(SymbolId symbol, size_t version)
+    BytecodeLocal(SymbolId symbol, size_t version, size_t ssa_version = 0)
         : m_symbol(symbol),
-          m_version(version)
+          m_version(version),
+          m_ssa_version(ssa_version)
     {}
 
   public:
     SymbolId get_symbol() const noexcept { return m_symbol; }
     size_t get_version() const noexcept { return m_version; }
+    size_t get_ssa_version() const noexcept { return m_ssa_version; }
 
   protected:
     SymbolId m_symbol;
     size_t m_version;
+    size_t m_ssa_version; // 0 if declared outside of SSA form
 };
 
 } // namespace via
@@ -47,6 +47,27 @@ class RegisterState
         return 0;
     }
 
+    // Allocates `count` consecutive registers and returns the first one
+    inline uint16_t alloc_range(size_t count) noexcept
+    {
+        size_t run = 0;
+        for (size_t i = 0; i < config::REGISTER_COUNT; ++i) {
+            run = m_buffer.test(i) ? 0 : run + 1;
+            if (run == count) {
+                size_t first = i + 1 - count;
+                for (size_t j = first; j <= i; ++j)
+                    m_buffer.set(j);
+                return static_cast<uint16_t>(first);
+            }
+        }
+
+        m_diags.report<Level::ERROR>(
+            {0, std::numeric_limits<size_t>::max()},
+            "Program complexity exceeds language limits (out of register space)"
+        );
+        return 0;
+    }
+
     inline void free(uint16_t reg) noexcept
     {
         debug::require(
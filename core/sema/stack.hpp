@@ -41,6 +41,20 @@ class Frame final
         return std::nullopt;
     }
 
+    // Finds the declaration of one SSA version of `symbol`, which may be shadowed
+    // by later declarations of the same name
+    std::optional<Ref> get_local(SymbolId symbol, size_t ssa_version)
+    {
+        for (int64_t i = m_locals.size() - 1; i >= 0; --i) {
+            Local& local = m_locals[i];
+            if (local.get_symbol() == symbol && local.get_ssa_version() == ssa_version) {
+                return Ref(static_cast<uint16_t>(i), &local);
+            }
+        }
+
+        return std::nullopt;
+    }
+
     template <typename... Args>
         requires(std::is_constructible_v<Local, SymbolId, size_t, Args...>)
     void set_local(SymbolId symbol, Args&&... args)
@@ -9,6 +9,7 @@
 
 #include "types.hpp"
 #include <functional>
+#include <mutex>
 #include <sstream>
 #include <vector>
 #include "ast/ast.hpp"
@@ -20,12 +21,14 @@ using enum via::CastResult;
 template <typename T, typename K, typename... Args>
     requires std::is_constructible_v<T, Args...> && std::is_constructible_v<K, Args...>
 static const T* instantiate_base(
+    std::mutex& mutex,
     via::BumpAllocator<>& alloc,
     std::unordered_map<K, const T*>& map,
     Args&&... args
 )
 {
     K key(args...);
+    std::lock_guard lock(mutex);
     if (auto it = map.find(key); it != map.end())
         return it->second;
     T* type = alloc.emplace<T>(args...);
@@ -63,7 +66,12 @@ std::string via::QualType::to_string() const
 
 const via::BuiltinType* via::BuiltinType::instance(TypeContext& ctx, BuiltinKind kind)
 {
-    return instantiate_base<BuiltinType, BuiltinKind>(ctx.m_alloc, ctx.m_builtins, kind);
+    return instantiate_base<BuiltinType, BuiltinKind>(
+        ctx.m_mutex,
+        ctx.m_alloc,
+        ctx.m_builtins,
+        kind
+    );
 }
 
 via::CastResult via::BuiltinType::cast_result(const Type* to) const
@@ -95,7 +103,12 @@ std::string via::BuiltinType::to_string() const
 
 const via::OptionalType* via::OptionalType::instance(TypeContext& ctx, QualType type)
 {
-    return instantiate_base<OptionalType, QualType>(ctx.m_alloc, ctx.m_optionals, type);
+    return instantiate_base<OptionalType, QualType>(
+        ctx.m_mutex,
+        ctx.m_alloc,
+        ctx.m_optionals,
+        type
+    );
 }
 
 via::CastResult via::OptionalType::cast_result(const Type* to) const
@@ -114,7 +127,12 @@ std::string via::OptionalType::to_string() const
 
 const via::ArrayType* via::ArrayType::instance(TypeContext& ctx, QualType type)
 {
-    return instantiate_base<ArrayType, QualType>(ctx.m_alloc, ctx.m_arrays, type);
+    return instantiate_base<ArrayType, QualType>(
+        ctx.m_mutex,
+        ctx.m_alloc,
+        ctx.m_arrays,
+        type
+    );
 }
 
 via::CastResult via::ArrayType::cast_result(const Type* to) const
@@ -138,7 +156,13 @@ std::string via::ArrayType::to_string() const
 
 const via::MapType* via::MapType::instance(TypeContext& ctx, QualType key, QualType value)
 {
-    return instantiate_base<MapType, MapKey>(ctx.m_alloc, ctx.m_maps, key, value);
+    return instantiate_base<MapType, MapKey>(
+        ctx.m_mutex,
+        ctx.m_alloc,
+        ctx.m_maps,
+        key,
+        value
+    );
 }
 
 via::CastResult via::MapType::cast_result(const Type* to) const
@@ -157,6 +181,7 @@ const via::FunctionType*
 via::FunctionType::instance(TypeContext& ctx, QualType ret, std::vector<QualType> parms)
 {
     return instantiate_base<FunctionType, FunctionKey>(
+        ctx.m_mutex,
         ctx.m_alloc,
         ctx.m_functions,
         ret,
@@ -187,6 +212,26 @@ std::string via::FunctionType::to_string() const
     return oss.str();
 }
 
+const via::FunctionType* via::TypeContext::get_instance(
+    const ast::StmtFunctionDecl* generic,
+    const std::vector<QualType>& args
+) const
+{
+    std::lock_guard lock(m_mutex);
+    auto it = m_instances.find({generic, args});
+    return it != m_instances.end() ? it->second : nullptr;
+}
+
+void via::TypeContext::add_instance(
+    const ast::StmtFunctionDecl* generic,
+    std::vector<QualType> args,
+    const FunctionType* type
+)
+{
+    std::lock_guard lock(m_mutex);
+    m_instances.emplace(InstanceKey{generic, std::move(args)}, type);
+}
+
 using via::hash_all;
 using via::hash_combine;
 using via::hash_ptr;
@@ -224,6 +269,14 @@ bool std::equal_to<via::FunctionKey>::operator()(
     return hash(a) == hash(b);
 }
 
+bool std::equal_to<via::InstanceKey>::operator()(
+    const via::InstanceKey& a,
+    const via::InstanceKey& b
+) const
+{
+    return a.generic == b.generic && a.args == b.args;
+}
+
 size_t std::hash<via::QualType>::operator()(const via::QualType& type) const
 {
     return hash_qual_type(type);
@@ -241,3 +294,11 @@ size_t std::hash<via::FunctionKey>::operator()(const via::FunctionKey& key) cons
         hash_range(key.parms.begin(), key.parms.end(), hash_qual_type)
     );
 }
+
+size_t std::hash<via::InstanceKey>::operator()(const via::InstanceKey& key) const
+{
+    return hash_all(
+        hash_ptr(key.generic),
+        hash_range(key.args.begin(), key.args.end(), hash_qual_type)
+    );
+}
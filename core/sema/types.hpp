@@ -11,6 +11,7 @@
 
 #include <concepts>
 #include <functional>
+#include <mutex>
 #include <type_traits>
 #include <vector>
 #include <via/config.hpp>
@@ -20,6 +21,11 @@
 #include "support/utility.hpp"
 
 namespace via {
+namespace ast {
+
+struct StmtFunctionDecl;
+
+}
 
 class TypeContext;
 
@@ -233,16 +239,24 @@ struct FunctionKey
     std::vector<QualType> parms;
 };
 
+struct InstanceKey
+{
+    const ast::StmtFunctionDecl* generic;
+    std::vector<QualType> args;
+};
+
 } // namespace via
 
 // clang-format off
 template <> struct std::hash<via::QualType> { size_t operator()(const via::QualType& type) const; };
 template <> struct std::hash<via::MapKey> { size_t operator()(const via::MapKey& key) const; };
 template <> struct std::hash<via::FunctionKey> { size_t operator()(const via::FunctionKey& key) const; };
+template <> struct std::hash<via::InstanceKey> { size_t operator()(const via::InstanceKey& key) const; };
 
 template <> struct std::equal_to<via::QualType> { bool operator()(const via::QualType& a, const via::QualType& b) const; };
 template <> struct std::equal_to<via::MapKey> { bool operator()(const via::MapKey& a, const via::MapKey& b) const; };
 template <> struct std::equal_to<via::FunctionKey> { bool operator()(const via::FunctionKey& a, const via::FunctionKey& b) const; };
+template <> struct std::equal_to<via::InstanceKey> { bool operator()(const via::InstanceKey& a, const via::InstanceKey& b) const; };
 // clang-format on
 
 namespace via {
@@ -264,13 +278,30 @@ class TypeContext final
     friend const FunctionType*
     FunctionType::instance(TypeContext&, QualType, std::vector<QualType>);
 
+  public:
+    // Signature of the generic function `generic` instantiated with `args`, or
+    // null if it has not been instantiated with them yet
+    const FunctionType* get_instance(
+        const ast::StmtFunctionDecl* generic,
+        const std::vector<QualType>& args
+    ) const;
+
+    void add_instance(
+        const ast::StmtFunctionDecl* generic,
+        std::vector<QualType> args,
+        const FunctionType* type
+    );
+
   private:
+    // Modules compiled in parallel share one context
+    mutable std::mutex m_mutex;
     BumpAllocator<> m_alloc{8 * 1024 * 1024};
     std::unordered_map<BuiltinKind, const BuiltinType*> m_builtins;
     std::unordered_map<QualType, const OptionalType*> m_optionals;
     std::unordered_map<QualType, const ArrayType*> m_arrays;
     std::unordered_map<MapKey, const MapType*> m_maps;
     std::unordered_map<FunctionKey, const FunctionType*> m_functions;
+    std::unordered_map<InstanceKey, const FunctionType*> m_instances;
 };
 
 } // namespace via
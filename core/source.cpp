@@ -19,6 +19,17 @@ bool via::SourceBuffer::is_valid_range(SourceLoc loc) const
            loc.begin < (m_buffer.size() - 1) && loc.end < (m_buffer.size() - 1);
 }
 
+uint64_t via::SourceBuffer::hash() const noexcept
+{
+    // FNV-1a
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (char chr: m_buffer) {
+        hash ^= static_cast<uint8_t>(chr);
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
 std::string via::SourceBuffer::get_slice(SourceLoc loc) const
 {
     debug::require(is_valid_range(loc), "Invalid range");
@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <via/config.hpp>
 
@@ -38,6 +39,9 @@ class SourceBuffer final
 
     bool is_valid_range(SourceLoc loc) const;
 
+    // Content hash, stable across platforms and runs
+    uint64_t hash() const noexcept;
+
     std::string get_slice(SourceLoc loc) const;
     SourceLoc get_location(const char* begin, const char* end) const;
     SourceLoc get_location(const Token& tok) const;
@@ -9,57 +9,155 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
-#include <map>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
-#include <string>
+#include <shared_mutex>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 #include <via/config.hpp>
+#include "utility.hpp"
 
 namespace via {
 
-template <typename T>
-struct view
-{
-    using type = std::reference_wrapper<T>;
-};
-
-template <>
-struct view<std::string>
-{
-    using type = std::string_view;
-};
-
-template <typename T, typename Id = uint64_t>
+// Interns strings under dense ids. Strings are hashed to one of a fixed set of
+// shards, each with its own lock, map and string arena, so inserting into
+// different shards does not contend. Ids map back to their string through a
+// segmented array that never moves, `lookup` reads it without locking.
+template <typename Id = uint64_t>
 class InternTable
 {
   public:
-    using view_type = typename view<T>::type;
+    InternTable() = default;
+    ~InternTable()
+    {
+        for (auto& segment: m_segments)
+            delete[] segment.load(std::memory_order_relaxed);
+    }
+
+    NO_COPY(InternTable);
+    NO_MOVE(InternTable);
 
   public:
-    Id intern(const T& val)
+    Id intern(std::string_view value)
     {
-        auto [it, inserted] = m_map.try_emplace(val, m_next_id);
-        if (inserted) {
-            m_reverse[m_next_id] = val;
-            m_next_id++;
+        Shard& shard = m_shards[std::hash<std::string_view>{}(value) % SHARD_COUNT];
+        {
+            std::shared_lock lock(shard.mutex);
+            if (auto it = shard.map.find(value); it != shard.map.end())
+                return it->second;
         }
-        return it->second;
+
+        std::unique_lock lock(shard.mutex);
+        if (auto it = shard.map.find(value); it != shard.map.end())
+            return it->second;
+
+        const char* record = shard.store(value);
+        Id id = m_size.fetch_add(1, std::memory_order_relaxed);
+        slot(id, true)->store(record, std::memory_order_release);
+        shard.map.emplace(std::string_view(record + sizeof(size_t), value.size()), id);
+        return id;
+    }
+
+    // Strings are never moved or freed, views live as long as the table
+    std::optional<std::string_view> lookup(Id id) const noexcept
+    {
+        if (id >= m_size.load(std::memory_order_acquire))
+            return std::nullopt;
+
+        // Interned concurrently, the id is taken but the string not yet stored
+        Slot* entry = slot(id, false);
+        const char* record = entry ? entry->load(std::memory_order_acquire) : nullptr;
+        if (record == nullptr)
+            return std::nullopt;
+
+        size_t size;
+        std::memcpy(&size, record, sizeof(size_t));
+        return std::string_view(record + sizeof(size_t), size);
     }
 
-    std::optional<view_type> lookup(Id id) const
+    // Number of ids handed out, lower ids may still be unresolved while
+    // another thread is interning
+    size_t size() const noexcept { return m_size.load(std::memory_order_acquire); }
+
+  private:
+    static constexpr size_t SHARD_COUNT = 16;
+    static constexpr size_t CHUNK_SIZE = 16 * 1024;
+    static constexpr size_t FIRST_SEGMENT_BITS = 8;
+    static constexpr size_t SEGMENT_COUNT = 48;
+
+    using Slot = std::atomic<const char*>;
+
+    // Records are the size of the string followed by its NUL terminated bytes
+    struct Shard
     {
-        if (auto it = m_reverse.find(id); it != m_reverse.end()) {
-            return view_type(it->second);
+        std::shared_mutex mutex;
+        std::unordered_map<std::string_view, Id> map;
+        std::vector<std::unique_ptr<char[]>> chunks;
+        char* cursor = nullptr;
+        size_t left = 0;
+
+        const char* store(std::string_view value)
+        {
+            size_t size = sizeof(size_t) + value.size() + 1;
+            if (size > left) {
+                size_t chunk_size = std::max(size, CHUNK_SIZE);
+                cursor = chunks.emplace_back(new char[chunk_size]).get();
+                left = chunk_size;
+            }
+
+            char* record = cursor;
+            size_t length = value.size();
+            std::memcpy(record, &length, sizeof(size_t));
+            std::memcpy(record + sizeof(size_t), value.data(), length);
+            record[sizeof(size_t) + length] = '\0';
+
+            cursor += size;
+            left -= size;
+            return record;
+        }
+    };
+
+    // Segment `n` holds the `2^(n + FIRST_SEGMENT_BITS)` ids following the
+    // previous segments, ids are split into a segment and an index with a few
+    // bit operations. Returns nullptr if the segment is missing and is not to be
+    // allocated.
+    Slot* slot(Id id, bool allocate) const
+    {
+        size_t biased = static_cast<size_t>(id) + (size_t(1) << FIRST_SEGMENT_BITS);
+        size_t bits = std::bit_width(biased) - 1;
+        size_t segment = bits - FIRST_SEGMENT_BITS;
+        size_t index = biased - (size_t(1) << bits);
+
+        Slot* slots = m_segments[segment].load(std::memory_order_acquire);
+        if (slots == nullptr && allocate) {
+            auto* fresh = new Slot[size_t(1) << bits]();
+            if (m_segments[segment].compare_exchange_strong(
+                    slots,
+                    fresh,
+                    std::memory_order_acq_rel,
+                    std::memory_order_acquire
+                ))
+                slots = fresh;
+            else
+                delete[] fresh; // Allocated by another shard first
         }
-        return std::nullopt;
+        return slots ? slots + index : nullptr;
     }
 
-  protected:
-    size_t m_next_id = 0;
-    std::unordered_map<T, Id> m_map;
-    std::map<Id, T> m_reverse;
+  private:
+    std::array<Shard, SHARD_COUNT> m_shards;
+    mutable std::array<std::atomic<Slot*>, SEGMENT_COUNT> m_segments{};
+    std::atomic<size_t> m_size = 0;
 };
 
 } // namespace via
@@ -10,9 +10,7 @@
 #include "memory.hpp"
 #include <mimalloc.h>
 
-via::ScopedAllocator::ScopedAllocator()
-    : m_heap(mi_heap_new())
-{}
+via::ScopedAllocator::ScopedAllocator() = default;
 
 via::ScopedAllocator::~ScopedAllocator()
 {
@@ -33,19 +31,26 @@ bool via::ScopedAllocator::owns(void* ptr) noexcept
     return m_heap && mi_heap_check_owned((mi_heap_t*) m_heap, ptr);
 }
 
+void* via::ScopedAllocator::heap() noexcept
+{
+    if (m_heap == nullptr)
+        m_heap = mi_heap_new();
+    return m_heap;
+}
+
 void* via::ScopedAllocator::alloc(size_t size) noexcept
 {
-    return mi_heap_malloc((mi_heap_t*) m_heap, size);
+    return mi_heap_malloc((mi_heap_t*) heap(), size);
 }
 
 char* via::ScopedAllocator::strdup(const char* str) noexcept
 {
-    return mi_heap_strdup((mi_heap_t*) m_heap, str);
+    return mi_heap_strdup((mi_heap_t*) heap(), str);
 }
 
 char* via::ScopedAllocator::strndup(const char* str, size_t n) noexcept
 {
-    return mi_heap_strndup((mi_heap_t*) m_heap, str, n);
+    return mi_heap_strndup((mi_heap_t*) heap(), str, n);
 }
 
 void via::ScopedAllocator::free(void* ptr)
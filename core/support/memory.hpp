@@ -162,6 +162,9 @@ class BumpAllocator final
     detail::ObRegistry m_registry;
 };
 
+// Allocations come from a heap of their own, which is created by the first
+// allocation. Heaps belong to the thread that created them, an allocator must
+// only be allocated from on that thread.
 class ScopedAllocator final
 {
   public:
@@ -204,7 +207,10 @@ class ScopedAllocator final
     }
 
   private:
-    void* m_heap;
+    void* heap() noexcept;
+
+  private:
+    void* m_heap = nullptr;
     detail::ObRegistry m_registry;
 };
 
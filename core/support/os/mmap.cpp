@@ -0,0 +1,166 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "mmap.hpp"
+#include <cstring>
+#include <format>
+#include <fstream>
+
+#if __has_include(<sys/mman.h>)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define USE_MMAN 1
+#else
+    #ifdef VIA_PLATFORM_WINDOWS
+        #include <windows.h>
+    #endif
+    #define USE_MMAN 0
+#endif
+
+std::expected<via::os::MappedFile, std::string>
+via::os::MappedFile::open(std::filesystem::path path)
+{
+    std::string path_str = path.string();
+    MappedFile file;
+
+#if USE_MMAN
+    int fd = ::open(path_str.c_str(), O_RDONLY);
+    if (fd < 0)
+        return std::unexpected(std::format("No such file or directory: '{}'", path_str));
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return std::unexpected(std::format("Could not stat '{}'", path_str));
+    }
+
+    // Mapping an empty file fails, it has nothing to view anyway
+    if (st.st_size > 0) {
+        void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            return std::unexpected(
+                std::format("Could not map '{}': {}", path_str, std::strerror(errno))
+            );
+        }
+
+        file.m_data = data;
+        file.m_size = st.st_size;
+        file.m_mapped = true;
+    }
+
+    ::close(fd); // The mapping keeps the file open
+    return file;
+#elif defined(VIA_PLATFORM_WINDOWS)
+    HANDLE handle = CreateFileA(
+        path_str.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+
+    if (handle == INVALID_HANDLE_VALUE)
+        return std::unexpected(std::format("No such file or directory: '{}'", path_str));
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size)) {
+        CloseHandle(handle);
+        return std::unexpected(std::format("Could not stat '{}'", path_str));
+    }
+
+    if (size.QuadPart > 0) {
+        HANDLE mapping =
+            CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+        if (mapping != nullptr)
+            CloseHandle(mapping); // The view keeps the mapping alive
+
+        if (data == nullptr) {
+            CloseHandle(handle);
+            return std::unexpected(std::format("Could not map '{}'", path_str));
+        }
+
+        file.m_data = data;
+        file.m_size = static_cast<size_t>(size.QuadPart);
+        file.m_mapped = true;
+    }
+
+    CloseHandle(handle);
+    return file;
+#else
+    std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+    if (!ifs.is_open())
+        return std::unexpected(std::format("No such file or directory: '{}'", path_str));
+
+    size_t size = ifs.tellg();
+    ifs.seekg(0);
+
+    file.m_data = new std::byte[size];
+    file.m_size = size;
+
+    if (!ifs.read(static_cast<char*>(file.m_data), size))
+        return std::unexpected(std::format("Could not read '{}'", path_str));
+    return file;
+#endif
+}
+
+void via::os::MappedFile::release() noexcept
+{
+    if (m_data == nullptr)
+        return;
+
+    if (m_mapped) {
+#if USE_MMAN
+        munmap(m_data, m_size);
+#elif defined(VIA_PLATFORM_WINDOWS)
+        UnmapViewOfFile(m_data);
+#endif
+    } else {
+        delete[] static_cast<std::byte*>(m_data);
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+}
+
+via::os::MappedFile::~MappedFile()
+{
+    release();
+}
+
+via::os::MappedFile::MappedFile(MappedFile&& other)
+    : m_data(other.m_data),
+      m_size(other.m_size),
+      m_mapped(other.m_mapped)
+{
+    other.m_data = nullptr;
+    other.m_size = 0;
+    other.m_mapped = false;
+}
+
+via::os::MappedFile& via::os::MappedFile::operator=(MappedFile&& other)
+{
+    if (this != &other) {
+        release();
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_mapped = other.m_mapped;
+        other.m_data = nullptr;
+        other.m_size = 0;
+        other.m_mapped = false;
+    }
+    return *this;
+}
@@ -0,0 +1,55 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <via/config.hpp>
+#include "support/utility.hpp"
+
+namespace via {
+namespace os {
+
+// Read only view of a whole file. Mapped pages are backed by the page cache,
+// so processes mapping the same file share one physical copy of it.
+class MappedFile final
+{
+  public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    IMPL_MOVE(MappedFile);
+    NO_COPY(MappedFile);
+
+  public:
+    // Where the platform cannot map files, the file is read into memory
+    static std::expected<MappedFile, std::string> open(std::filesystem::path path);
+
+  public:
+    bool is_mapped() const noexcept { return m_mapped; }
+    std::span<const std::byte> bytes() const noexcept
+    {
+        return {static_cast<const std::byte*>(m_data), m_size};
+    }
+
+  private:
+    void release() noexcept;
+
+  private:
+    void* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_mapped = false;
+};
+
+} // namespace os
+} // namespace via
@@ -0,0 +1,57 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "thread_pool.hpp"
+
+via::ThreadPool::ThreadPool(size_t threads)
+{
+    m_workers.reserve(threads);
+    for (size_t i = 0; i < threads; i++)
+        m_workers.emplace_back([this] { work(); });
+}
+
+via::ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_cond.notify_all();
+    for (auto& worker: m_workers)
+        worker.join();
+}
+
+void via::ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_cond.notify_one();
+}
+
+void via::ThreadPool::work()
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(m_mutex);
+            m_cond.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+
+            // Tasks still queued are run before stopping
+            if (m_tasks.empty())
+                return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,51 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <via/config.hpp>
+#include "utility.hpp"
+
+namespace via {
+
+// Fixed set of worker threads running tasks in the order they are submitted.
+// Workers live as long as the pool, so memory they allocate from thread bound
+// heaps stays usable until it is destroyed.
+class ThreadPool final
+{
+  public:
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+
+    NO_COPY(ThreadPool);
+    NO_MOVE(ThreadPool);
+
+  public:
+    size_t size() const noexcept { return m_workers.size(); }
+    void submit(std::function<void()> task);
+
+  private:
+    void work();
+
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<std::function<void()>> m_tasks;
+    std::vector<std::thread> m_workers;
+    bool m_stopping = false;
+};
+
+} // namespace via
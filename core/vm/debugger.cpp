@@ -315,7 +315,7 @@ void via::Debugger::register_default_commands() noexcept
             size_t index = std::get<size_t(ArgumentType::INTEGER)>(args.at(0));
             auto& consts = m_vm.m_exe->constants();
             if (index < consts.size()) {
-                auto konst = consts.at(index);
+                auto konst = consts.value(index);
                 std::cout << konst.to_string() << "\n";
             } else {
                 std::cout << "not found\n";
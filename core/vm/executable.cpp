@@ -8,6 +8,8 @@
 ** ===================================================== */
 
 #include "executable.hpp"
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <iomanip>
 #include <iostream>
@@ -16,6 +18,8 @@
 #include "debug.hpp"
 #include "diagnostics.hpp"
 #include "ir/ir.hpp"
+#include "ir/rewrite.hpp"
+#include "module/binary.hpp"
 #include "module/manager.hpp"
 #include "module/module.hpp"
 #include "sema/const.hpp"
@@ -23,6 +27,7 @@
 #include "support/ansi.hpp"
 #include "support/bit.hpp"
 #include "vm/instruction.hpp"
+#include "vm/peephole.hpp"
 
 namespace ir = via::ir;
 
@@ -85,12 +90,35 @@ void via::detail::ir_lower_expr<ir::ExprSymbol>(
 {
     set_null_dst_trap(exe, dst);
 
+    if (auto reg = exe.get_inline_register(ir_expr_symbol->symbol)) {
+        exe.push_instruction(OpCode::COPY, {*dst, *reg});
+        return;
+    }
+
+    // Versioned uses name their declaration exactly, a later declaration of the
+    // same name may be in scope on another path
     auto& frame = exe.m_stack.top();
-    if (auto lref = frame.get_local(ir_expr_symbol->symbol)) {
+    auto lref = ir_expr_symbol->version != 0
+                    ? frame.get_local(ir_expr_symbol->symbol, ir_expr_symbol->version)
+                    : std::nullopt;
+    if (!lref.has_value())
+        lref = frame.get_local(ir_expr_symbol->symbol);
+
+    if (lref.has_value()) {
         exe.push_instruction(OpCode::GETLOCAL, {*dst, lref->id});
         return;
     }
 
+    if (auto arg = exe.get_arg(ir_expr_symbol->symbol)) {
+        exe.push_instruction(OpCode::GETARG, {*dst, *arg});
+        return;
+    }
+
+    if (!exe.m_callees.empty() && exe.m_callees.back() == ir_expr_symbol->symbol) {
+        exe.push_instruction(OpCode::GETCALLEE, {*dst});
+        return;
+    }
+
     debug::unimplemented("ir symbol lookup");
 }
 
@@ -107,8 +135,8 @@ void via::detail::ir_lower_expr<ir::ExprModuleAccess>(
         OpCode::GETIMPORT,
         {
             *dst,
-            static_cast<uint16_t>(ir_expr_module_access->mod_id),
-            static_cast<uint16_t>(ir_expr_module_access->key_id),
+            exe.symbol_slot(ir_expr_module_access->mod_id),
+            exe.symbol_slot(ir_expr_module_access->key_id),
         }
     );
 }
@@ -122,6 +150,20 @@ void via::detail::ir_lower_expr<ir::ExprBinary>(
 {
     set_null_dst_trap(exe, dst);
 
+    if (ir_expr_binary->op == BinaryOp::AND || ir_expr_binary->op == BinaryOp::OR) {
+        // Materialized through branches so the right-hand side is only
+        // evaluated when it decides the result
+        size_t iffalse = exe.new_label(), merge = exe.new_label();
+        exe.lower_branch(ir_expr_binary, std::nullopt, iffalse);
+        exe.push_instruction(OpCode::LOADTRUE, {*dst});
+        exe.push_jump(OpCode::JMP, merge);
+
+        exe.set_label(iffalse);
+        exe.push_instruction(OpCode::LOADFALSE, {*dst});
+        exe.set_label(merge);
+        return;
+    }
+
     uint16_t opid = static_cast<uint16_t>(ir_expr_binary->op);
     uint16_t rlhs = exe.m_reg_state.alloc(), rrhs = exe.m_reg_state.alloc();
 
@@ -132,8 +174,9 @@ void via::detail::ir_lower_expr<ir::ExprBinary>(
         opid <= static_cast<uint16_t>(BinaryOp::MOD)) {
         /* TODO: Check if rhs is constexpr, in which case increment base by one
          * for K instructions*/
+        // Arithmetic opcodes come in groups of four: I, IK, F, FK
         uint16_t base = static_cast<uint16_t>(OpCode::IADD) +
-                        static_cast<uint16_t>(ir_expr_binary->op);
+                        (opid - static_cast<uint16_t>(BinaryOp::ADD)) * 4;
 
         if (ir_expr_binary->lhs->type.unwrap()->is_integral()) {
             if (ir_expr_binary->rhs->type.unwrap()->is_float()) {
@@ -149,23 +192,26 @@ void via::detail::ir_lower_expr<ir::ExprBinary>(
         }
 
         exe.push_instruction(static_cast<OpCode>(base), {*dst, rlhs, rrhs});
-    } else if (opid >= static_cast<uint16_t>(BinaryOp::AND) &&
-               opid <= static_cast<uint16_t>(BinaryOp::OR)) {
-        /* TODO: Check if rhs is constexpr, in which case increment base by one
-         * for K instructions*/
-        uint16_t base = static_cast<uint16_t>(OpCode::AND) +
-                        static_cast<uint16_t>(ir_expr_binary->op);
-        exe.push_instruction(static_cast<OpCode>(base), {*dst, rlhs, rrhs});
     } else if (opid >= static_cast<uint16_t>(BinaryOp::BAND) &&
                opid <= static_cast<uint16_t>(BinaryOp::BSHR)) {
         /* TODO: Check if rhs is constexpr, in which case increment base by one
          * for K instructions*/
         uint16_t base = static_cast<uint16_t>(OpCode::BAND) +
-                        static_cast<uint16_t>(ir_expr_binary->op);
+                        (opid - static_cast<uint16_t>(BinaryOp::BAND)) * 2;
         exe.push_instruction(static_cast<OpCode>(base), {*dst, rlhs, rrhs});
     }
 
-    exe.push_instruction(OpCode::FREE2, {rlhs, rrhs});
+    // Operands that do not escape are left in place for the next store into
+    // their register to overwrite
+    bool lhs_escapes = ir_expr_binary->lhs->escapes;
+    bool rhs_escapes = ir_expr_binary->rhs->escapes;
+
+    if (lhs_escapes && rhs_escapes) {
+        exe.push_instruction(OpCode::FREE2, {rlhs, rrhs});
+    } else if (lhs_escapes || rhs_escapes) {
+        exe.push_instruction(OpCode::FREE1, {lhs_escapes ? rlhs : rrhs});
+    }
+
     exe.m_reg_state.free_all(rlhs, rrhs);
 }
 
@@ -191,10 +237,129 @@ void via::detail::ir_lower_expr<ir::ExprCall>(
     exe.m_reg_state.free(callee);
 
     if (dst.has_value()) {
-        exe.push_instruction(OpCode::GETTOP, {*dst});
+        size_t pc = exe.push_instruction(OpCode::GETTOP, {*dst});
+        exe.m_sites[pc] = profile_site(ir_expr_call->loc);
     }
 }
 
+template <>
+void via::detail::ir_lower_expr<ir::ExprInline>(
+    Executable& exe,
+    const ir::ExprInline* ir_expr_inline,
+    std::optional<uint16_t> dst
+) noexcept
+{
+    const ir::StmtFuncDecl* callee = ir_expr_inline->callee;
+
+    // Arguments are evaluated in the enclosing scope, parameters are then bound
+    // directly to the registers holding them.
+    std::vector<std::pair<SymbolId, uint16_t>> frame;
+    for (size_t i = 0; const auto& parm: callee->parms) {
+        uint16_t reg = exe.m_reg_state.alloc();
+        exe.lower_expr(ir_expr_inline->args[i++], reg);
+        frame.emplace_back(parm.symbol, reg);
+    }
+
+    exe.m_inline_frames.push_back(std::move(frame));
+
+    for (const auto& stmt: callee->body->stmts) {
+        exe.lower_stmt(stmt);
+    }
+
+    auto* ret = dynamic_cast<const ir::TrReturn*>(callee->body->term);
+    debug::require(ret != nullptr, "inlined function body must end in a return");
+
+    if (dst.has_value()) {
+        if (ret->val != nullptr) {
+            exe.lower_expr(ret->val, dst);
+        } else {
+            exe.push_instruction(OpCode::LOADNIL, {*dst});
+        }
+    } else if (ret->val != nullptr) {
+        uint16_t reg = exe.m_reg_state.alloc();
+        exe.lower_expr(ret->val, reg);
+        exe.push_instruction(OpCode::FREE1, {reg});
+        exe.m_reg_state.free(reg);
+    }
+
+    for (const auto& [symbol, reg]: exe.m_inline_frames.back()) {
+        exe.push_instruction(OpCode::FREE1, {reg});
+        exe.m_reg_state.free(reg);
+    }
+
+    exe.m_inline_frames.pop_back();
+}
+
+// Whether `expr` may be evaluated even if its value ends up unused, meaning it
+// has no side effects and cannot raise.
+static bool is_speculatable(const ir::Expr* expr) noexcept
+{
+    if (TRY_IS(const ir::ExprConstant, expr) || TRY_IS(const ir::ExprSymbol, expr))
+        return true;
+
+    if TRY_COERCE (const ir::ExprBinary, binary, expr) {
+        switch (binary->op) {
+        case via::BinaryOp::ADD:
+        case via::BinaryOp::SUB:
+        case via::BinaryOp::MUL:
+        case via::BinaryOp::BAND:
+        case via::BinaryOp::BOR:
+        case via::BinaryOp::BXOR:
+        case via::BinaryOp::BSHL:
+        case via::BinaryOp::BSHR:
+            return is_speculatable(binary->lhs) && is_speculatable(binary->rhs);
+        case via::BinaryOp::DIV: {
+            // Integer division by zero raises
+            auto* divisor = dynamic_cast<const ir::ExprConstant*>(binary->rhs);
+            if (divisor == nullptr || (divisor->value.kind() == via::ValueKind::INT &&
+                                       divisor->value.value<via::ValueKind::INT>() == 0))
+                return false;
+            return is_speculatable(binary->lhs);
+        }
+        default:
+            break;
+        }
+    }
+
+    return false;
+}
+
+template <>
+void via::detail::ir_lower_expr<ir::ExprTernary>(
+    Executable& exe,
+    const ir::ExprTernary* ir_expr_ternary,
+    std::optional<uint16_t> dst
+) noexcept
+{
+    set_null_dst_trap(exe, dst);
+
+    // Both arms are evaluated up front and SELECT keeps the right one, which
+    // trades the branches for the cost of the unused arm
+    if (is_speculatable(ir_expr_ternary->iftrue) &&
+        is_speculatable(ir_expr_ternary->iffalse)) {
+        uint16_t cond = exe.m_reg_state.alloc();
+        uint16_t arms = exe.m_reg_state.alloc_range(2);
+
+        exe.lower_expr(ir_expr_ternary->cnd, cond);
+        exe.lower_expr(ir_expr_ternary->iftrue, arms);
+        exe.lower_expr(ir_expr_ternary->iffalse, arms + 1);
+        exe.push_instruction(OpCode::SELECT, {*dst, cond, arms});
+        if (ir_expr_ternary->cnd->escapes)
+            exe.push_instruction(OpCode::FREE1, {cond});
+        exe.m_reg_state.free_all(cond, arms, arms + 1);
+        return;
+    }
+
+    size_t iffalse = exe.new_label(), merge = exe.new_label();
+    exe.lower_branch(ir_expr_ternary->cnd, std::nullopt, iffalse);
+    exe.lower_expr(ir_expr_ternary->iftrue, dst);
+    exe.push_jump(OpCode::JMP, merge);
+
+    exe.set_label(iffalse);
+    exe.lower_expr(ir_expr_ternary->iffalse, dst);
+    exe.set_label(merge);
+}
+
 template <>
 void via::detail::ir_lower_expr<ir::ExprCast>(
     Executable& exe,
@@ -250,6 +415,7 @@ void via::Executable::lower_expr(
     VISIT_EXPR(ir::ExprUnary);
     VISIT_EXPR(ir::ExprBinary);
     VISIT_EXPR(ir::ExprCall);
+    VISIT_EXPR(ir::ExprInline);
     VISIT_EXPR(ir::ExprSubscript);
     VISIT_EXPR(ir::ExprCast);
     VISIT_EXPR(ir::ExprTernary);
@@ -267,6 +433,14 @@ void via::detail::ir_lower_stmt<ir::StmtVarDecl>(
     const ir::StmtVarDecl* ir_stmt_var_decl
 ) noexcept
 {
+    if (!exe.m_inline_frames.empty()) {
+        // Locals of an inline expansion live in registers for its duration
+        auto reg = exe.m_reg_state.alloc();
+        exe.lower_expr(ir_stmt_var_decl->expr, reg);
+        exe.m_inline_frames.back().emplace_back(ir_stmt_var_decl->symbol, reg);
+        return;
+    }
+
     auto dst = exe.m_reg_state.alloc();
     exe.lower_expr(ir_stmt_var_decl->expr, dst);
     exe.push_instruction(OpCode::PUSH, {dst});
@@ -274,7 +448,31 @@ void via::detail::ir_lower_stmt<ir::StmtVarDecl>(
     exe.m_reg_state.free(dst);
 
     auto& frame = exe.m_stack.top();
-    frame.set_local(ir_stmt_var_decl->symbol);
+    frame.set_local(ir_stmt_var_decl->symbol, ir_stmt_var_decl->version);
+}
+
+template <>
+void via::detail::ir_lower_stmt<ir::StmtCopy>(
+    Executable& exe,
+    const ir::StmtCopy* ir_stmt_copy
+) noexcept
+{
+    // Sources are all loaded first, one of them may be a slot written here
+    std::vector<uint16_t> regs;
+    for (const auto& move: ir_stmt_copy->moves) {
+        regs.push_back(exe.m_reg_state.alloc());
+        exe.lower_expr(move.src, regs.back());
+    }
+
+    auto& frame = exe.m_stack.top();
+    for (size_t i = 0; const auto& move: ir_stmt_copy->moves) {
+        auto lref = frame.get_local(move.dst->symbol, move.dst->version);
+        debug::require(lref.has_value(), "copy into a slot that is not declared");
+
+        exe.push_instruction(OpCode::SETLOCAL, {regs[i], lref->id});
+        exe.push_instruction(OpCode::FREE1, {regs[i]});
+        exe.m_reg_state.free(regs[i++]);
+    }
 }
 
 template <>
@@ -284,6 +482,13 @@ void via::detail::ir_lower_stmt<ir::StmtInstruction>(
 ) noexcept
 {
     exe.m_bytecode.push_back(ir_stmt_instr->instr);
+
+    // Locals of a closed scope are popped, the frame has to forget them as well
+    // or declarations after the scope get the slots they occupied
+    if (ir_stmt_instr->instr.op == OpCode::SAVE)
+        exe.m_stack.top().save();
+    else if (ir_stmt_instr->instr.op == OpCode::RESTORE)
+        exe.m_stack.top().restore();
 }
 
 template <>
@@ -292,13 +497,7 @@ void via::detail::ir_lower_stmt<ir::StmtBlock>(
     const ir::StmtBlock* ir_stmt_block
 ) noexcept
 {
-    exe.set_label(ir_stmt_block->id);
-    for (const auto& stmt: ir_stmt_block->stmts) {
-        exe.lower_stmt(stmt);
-    }
-    if (ir_stmt_block->term != nullptr) {
-        exe.lower_term(ir_stmt_block->term);
-    }
+    exe.lower_block(ir_stmt_block, std::nullopt);
 }
 
 template <>
@@ -307,11 +506,30 @@ void via::detail::ir_lower_stmt<ir::StmtFuncDecl>(
     const ir::StmtFuncDecl* ir_stmt_func_decl
 ) noexcept
 {
+    // Deferred bodies that nothing referred to are dropped along with their
+    // declaration
+    if (ir_stmt_func_decl->body == nullptr)
+        return;
+
     exe.m_stack.push({});
 
     auto dst = exe.m_reg_state.alloc();
     auto pc = exe.push_instruction(OpCode::NOP);
-    exe.lower_stmt(ir_stmt_func_decl->body);
+    exe.m_sites[pc] = profile_site(ir_stmt_func_decl->loc);
+    if (ir_stmt_func_decl->attrs & FuncAttrs::MEMOIZE)
+        exe.m_memoized[pc] = ir_stmt_func_decl->parms.size();
+
+    auto& parms = exe.m_arg_frames.emplace_back();
+    for (const auto& parm: ir_stmt_func_decl->parms)
+        parms.push_back(parm.symbol);
+    exe.m_callees.push_back(ir_stmt_func_decl->symbol);
+
+    exe.m_out_of_line.emplace_back();
+    exe.lower_block(ir_stmt_func_decl->body, std::nullopt);
+    exe.lower_out_of_line();
+    exe.m_out_of_line.pop_back();
+    exe.m_callees.pop_back();
+    exe.m_arg_frames.pop_back();
 
     size_t offset = exe.program_counter() - pc + 1;
     uint16_t high, low;
@@ -339,6 +557,9 @@ void via::detail::ir_lower_stmt<ir::StmtExpr>(
 
 void via::Executable::lower_stmt(const ir::Stmt* stmt) noexcept
 {
+    if (!TRY_IS(const ir::StmtBlock, stmt))
+        mark_line(stmt->loc);
+
 #define VISIT_STMT(TYPE)                                                                 \
     if TRY_COERCE (const TYPE, _INNER, stmt)                                             \
         return detail::ir_lower_stmt<TYPE>(*this, _INNER);
@@ -348,6 +569,7 @@ void via::Executable::lower_stmt(const ir::Stmt* stmt) noexcept
     VISIT_STMT(ir::StmtInstruction)
     VISIT_STMT(ir::StmtBlock)
     VISIT_STMT(ir::StmtExpr)
+    VISIT_STMT(ir::StmtCopy)
 
     debug::unimplemented(std::format("lower_stmt({})", VIA_TYPENAME(*stmt)));
 #undef VISIT_STMT
@@ -375,9 +597,22 @@ void via::detail::ir_lower_term<ir::TrBranch>(
     const ir::TrBranch* ir_term_branch
 ) noexcept
 {
-    uint16_t high, low;
-    unpack_halves(ir_term_branch->target->id, high, low);
-    exe.push_instruction(OpCode::JMP, {high, low});
+    const ir::StmtBlock* target = ir_term_branch->target;
+    if (exe.m_fallthrough == target->id)
+        return;
+
+    // Branching back to a loop condition repeats the test here, so each
+    // iteration takes a single conditional jump back into the body and the
+    // exit falls through
+    if (auto it = exe.m_loop_tests.find(target->id); it != exe.m_loop_tests.end()) {
+        auto frame = it->second;
+        std::swap(exe.m_stack.top(), frame);
+        exe.lower_term(target->term);
+        std::swap(exe.m_stack.top(), frame);
+        return;
+    }
+
+    exe.push_jump(OpCode::JMP, target->id);
 }
 
 template <>
@@ -386,19 +621,77 @@ void via::detail::ir_lower_term<ir::TrCondBranch>(
     const ir::TrCondBranch* ir_term_cond_branch
 ) noexcept
 {
-    uint16_t thigh, tlow, fhigh, flow;
-    unpack_halves(ir_term_cond_branch->iftrue->id, thigh, tlow);
-    unpack_halves(ir_term_cond_branch->iffalse->id, fhigh, flow);
+    std::optional<size_t> iftrue = ir_term_cond_branch->iftrue->id;
+    std::optional<size_t> iffalse = ir_term_cond_branch->iffalse->id;
 
-    uint16_t reg = exe.m_reg_state.alloc();
-    exe.lower_expr(ir_term_cond_branch->cnd, reg);
-    exe.push_instruction(OpCode::JMPIF, {reg, thigh, tlow});
-    exe.push_instruction(OpCode::JMP, {fhigh, flow});
-    exe.m_reg_state.free(reg);
+    // Fall through into whichever successor is laid out next
+    if (exe.m_fallthrough == iftrue)
+        iftrue.reset();
+    else if (exe.m_fallthrough == iffalse)
+        iffalse.reset();
+
+    exe.lower_branch(ir_term_cond_branch->cnd, iftrue, iffalse);
+}
+
+// The counter, limit and step are pushed as three consecutive locals, the
+// counter being the loop variable itself. Unlike registers, locals survive the
+// calls made by the loop body.
+template <>
+void via::detail::ir_lower_term<ir::TrForPrep>(
+    Executable& exe,
+    const ir::TrForPrep* ir_term_for_prep
+) noexcept
+{
+    auto& frame = exe.m_stack.top();
+    auto& symtab = exe.m_module->manager().symbol_table();
+
+    auto push = [&](const ir::Expr* expr, SymbolId symbol) {
+        uint16_t reg = exe.m_reg_state.alloc();
+        if (expr != nullptr)
+            exe.lower_expr(expr, reg);
+        else
+            exe.push_instruction(OpCode::LOADINT, {reg, 0, 1});
+
+        exe.push_instruction(OpCode::PUSH, {reg});
+        exe.push_instruction(OpCode::FREE1, {reg});
+        exe.m_reg_state.free(reg);
+        frame.set_local(symbol);
+    };
+
+    // Loop state lives in locals, not registers: registers are shared by every frame
+    // and are not saved across calls, so a call in the body could clobber them.
+    push(ir_term_for_prep->var->expr, ir_term_for_prep->var->symbol);
+    auto slot = static_cast<uint16_t>(frame.get().size() - 1);
+
+    // Hidden from name lookup
+    SymbolId state = symtab.intern("<for.state>");
+    push(ir_term_for_prep->limit, state);
+    push(ir_term_for_prep->step, state);
+
+    exe.push_jump(OpCode::FORPREP, ir_term_for_prep->exit->id, slot);
+    exe.m_loop_vars.push_back({ir_term_for_prep, slot});
+}
+
+template <>
+void via::detail::ir_lower_term<ir::TrForLoop>(
+    Executable& exe,
+    const ir::TrForLoop* ir_term_for_loop
+) noexcept
+{
+    debug::require(
+        !exe.m_loop_vars.empty() && exe.m_loop_vars.back().prep == ir_term_for_loop->prep,
+        "FORLOOP lowered outside of its loop"
+    );
+
+    uint16_t slot = exe.m_loop_vars.back().slot;
+    exe.m_loop_vars.pop_back();
+    exe.push_jump(OpCode::FORLOOP, ir_term_for_loop->prep->body->id, slot);
 }
 
 void via::Executable::lower_term(const ir::Term* term) noexcept
 {
+    mark_line(term->loc);
+
 #define VISIT_TERM(TYPE)                                                                 \
     if TRY_COERCE (const TYPE, _INNER, term)                                             \
         return detail::ir_lower_term<TYPE>(*this, _INNER);
@@ -406,6 +699,8 @@ void via::Executable::lower_term(const ir::Term* term) noexcept
     VISIT_TERM(ir::TrReturn);
     VISIT_TERM(ir::TrBranch);
     VISIT_TERM(ir::TrCondBranch);
+    VISIT_TERM(ir::TrForPrep);
+    VISIT_TERM(ir::TrForLoop);
     VISIT_TERM(ir::TrContinue);
     VISIT_TERM(ir::TrBreak);
 
@@ -413,6 +708,219 @@ void via::Executable::lower_term(const ir::Term* term) noexcept
 #undef VISIT_TERM
 }
 
+// Branches to `iftrue` or `iffalse` depending on `cond`, falling through where
+// a label is absent. `and`, `or` and `not` are lowered into the control flow
+// itself, so no intermediate bool is materialized and operands that do not
+// decide the outcome are never evaluated.
+void via::Executable::lower_branch(
+    const ir::Expr* cond,
+    std::optional<size_t> iftrue,
+    std::optional<size_t> iffalse
+) noexcept
+{
+    if TRY_COERCE (const ir::ExprUnary, unary, cond) {
+        if (unary->op == UnaryOp::NOT)
+            return lower_branch(unary->expr, iffalse, iftrue);
+    }
+
+    if TRY_COERCE (const ir::ExprBinary, binary, cond) {
+        if (binary->op == BinaryOp::AND || binary->op == BinaryOp::OR) {
+            std::optional<size_t> merge;
+            auto merge_label = [&] {
+                if (!merge.has_value())
+                    merge = new_label();
+                return *merge;
+            };
+
+            // The left operand decides the result when it is false for `and`
+            // and true for `or`, otherwise control falls through to the right
+            if (binary->op == BinaryOp::AND) {
+                size_t target = iffalse.has_value() ? *iffalse : merge_label();
+                lower_branch(binary->lhs, std::nullopt, target);
+            } else {
+                size_t target = iftrue.has_value() ? *iftrue : merge_label();
+                lower_branch(binary->lhs, target, std::nullopt);
+            }
+
+            lower_branch(binary->rhs, iftrue, iffalse);
+            if (merge.has_value())
+                set_label(*merge);
+            return;
+        }
+    }
+
+    uint16_t reg = m_reg_state.alloc();
+    lower_expr(cond, reg);
+
+    if (iftrue.has_value()) {
+        m_sites[push_jump(OpCode::JMPIF, *iftrue, reg)] = profile_site(cond->loc);
+        if (iffalse.has_value())
+            push_jump(OpCode::JMP, *iffalse);
+    } else if (iffalse.has_value()) {
+        m_sites[push_jump(OpCode::JMPIFX, *iffalse, reg)] = profile_site(cond->loc);
+    }
+
+    m_reg_state.free(reg);
+}
+
+// Whether lowering `expr` a second time costs little code and yields an
+// independent copy of it. Calls may expand into much more code once inlined.
+static bool is_repeatable(const ir::Expr* expr, size_t& budget) noexcept
+{
+    if (budget == 0 || TRY_IS(const ir::ExprInline, expr) ||
+        TRY_IS(const ir::ExprLambda, expr) || TRY_IS(const ir::ExprCall, expr))
+        return false;
+
+    budget--;
+
+    bool repeatable = true;
+    ir::for_each_operand(expr, [&](const ir::Expr* child) {
+        repeatable = repeatable && is_repeatable(child, budget);
+    });
+    return repeatable;
+}
+
+void via::Executable::lower_block(
+    const ir::StmtBlock* block,
+    std::optional<size_t> fallthrough
+) noexcept
+{
+    set_label(block->id);
+
+    // Only loop headers are entered again from below, any other block that
+    // just tests a condition would have its test copied for nothing
+    if TRY_COERCE (const ir::TrCondBranch, branch, block->term) {
+        size_t budget = config::LOOP_TEST_MAX_NODES;
+        if (block->loop_header && block->stmts.empty() &&
+            is_repeatable(branch->cnd, budget))
+            m_loop_tests.emplace(block->id, m_stack.top());
+    }
+
+    const auto& stmts = block->stmts;
+    for (size_t i = 0; i < stmts.size(); i++) {
+        if (is_out_of_line(stmts[i])) {
+            auto* cold = static_cast<const ir::StmtBlock*>(stmts[i]);
+            m_out_of_line.back().push_back({cold, m_stack.top()});
+            continue;
+        }
+
+        auto* child = dynamic_cast<const ir::StmtBlock*>(stmts[i]);
+        if (child == nullptr) {
+            lower_stmt(stmts[i]);
+            continue;
+        }
+
+        std::optional<size_t> next;
+        for (size_t j = i + 1; j < stmts.size(); j++) {
+            if (is_out_of_line(stmts[j]))
+                continue;
+            if TRY_COERCE (const ir::StmtBlock, sibling, stmts[j])
+                next = sibling->id;
+            break;
+        }
+
+        lower_block(child, next);
+    }
+
+    if (block->term != nullptr) {
+        m_fallthrough = fallthrough;
+        lower_term(block->term);
+        m_fallthrough.reset();
+    }
+}
+
+// Lowers the cold blocks of the function being lowered. Its code has to end in
+// a terminator that does not fall through before this is called.
+void via::Executable::lower_out_of_line() noexcept
+{
+    // Indexed, as cold blocks nested in these are appended while lowering them
+    auto& cold = m_out_of_line.back();
+    for (size_t i = 0; i < cold.size(); i++) {
+        auto [block, frame] = cold[i];
+        std::swap(m_stack.top(), frame);
+        lower_block(block, std::nullopt);
+        std::swap(m_stack.top(), frame);
+    }
+
+    cold.clear();
+}
+
+// Blocks made by SSA destruction to hold the copies of a single edge. They are
+// nested in the block the edge leaves, which branches to them.
+static bool is_edge_block(const ir::StmtBlock* block) noexcept
+{
+    return block->stmts.size() == 1 && TRY_IS(const ir::StmtCopy, block->stmts.front()) &&
+           TRY_IS(const ir::TrBranch, block->term);
+}
+
+bool via::Executable::is_out_of_line(const ir::Stmt* stmt) const noexcept
+{
+    auto* block = dynamic_cast<const ir::StmtBlock*>(stmt);
+    if (block == nullptr || !(m_cold_blocks.contains(block->id) || is_edge_block(block)))
+        return false;
+
+    // Inline expansions are lowered in the middle of an expression, and moved
+    // blocks must not fall through into whatever ends up after them
+    return m_inline_frames.empty() && (TRY_IS(const ir::TrBranch, block->term) ||
+                                       TRY_IS(const ir::TrReturn, block->term));
+}
+
+// Marks the successors of conditional branches that the profile shows are
+// almost never taken
+void via::Executable::mark_cold_blocks(
+    const ir::Stmt* stmt,
+    const Profile& profile
+) noexcept
+{
+    if TRY_COERCE (const ir::StmtFuncDecl, func_decl, stmt) {
+        if (func_decl->body != nullptr)
+            mark_cold_blocks(func_decl->body, profile);
+        return;
+    }
+
+    auto* block = dynamic_cast<const ir::StmtBlock*>(stmt);
+    if (block == nullptr)
+        return;
+
+    for (const ir::Stmt* child: block->stmts)
+        mark_cold_blocks(child, profile);
+
+    auto* branch = dynamic_cast<const ir::TrCondBranch*>(block->term);
+    if (branch == nullptr)
+        return;
+
+    // Mirrors the jumps lower_branch emits. `and` and `or` spread the
+    // condition over several sites, none of which decides the branch alone.
+    const ir::Expr* cond = branch->cnd;
+    bool negated = false;
+
+    while (auto* unary = dynamic_cast<const ir::ExprUnary*>(cond)) {
+        if (unary->op != UnaryOp::NOT)
+            break;
+        cond = unary->expr;
+        negated = !negated;
+    }
+
+    if TRY_COERCE (const ir::ExprBinary, binary, cond) {
+        if (binary->op == BinaryOp::AND || binary->op == BinaryOp::OR)
+            return;
+    }
+
+    auto counts = profile.branch(profile_site(cond->loc));
+    if (!counts.has_value() || counts->total() < config::PROFILE_MIN_SAMPLES)
+        return;
+
+    auto is_cold = [&](uint64_t taken) {
+        return taken * 1000 <= counts->total() * config::PROFILE_COLD_PERMILLE;
+    };
+
+    uint64_t iftrue = negated ? counts->falsy : counts->truthy;
+    if (is_cold(iftrue))
+        m_cold_blocks.insert(branch->iftrue->id);
+    if (is_cold(counts->total() - iftrue))
+        m_cold_blocks.insert(branch->iffalse->id);
+}
+
 via::Executable* via::Executable::build_from_ir(
     Module* module,
     DiagContext& diags,
@@ -425,15 +933,39 @@ via::Executable* via::Executable::build_from_ir(
     exe->m_module = module;
     exe->m_flags = flags;
 
+    if (const Profile* profile = module->profile()) {
+        for (const auto& stmt: ir_tree)
+            exe->mark_cold_blocks(stmt, *profile);
+    }
+
+    exe->m_out_of_line.emplace_back();
+
     for (const auto& stmt: ir_tree) {
         exe->lower_stmt(stmt);
     }
 
+    if (!exe->m_out_of_line.back().empty()) {
+        exe->push_instruction(OpCode::HALT);
+        exe->lower_out_of_line();
+    }
+
     exe->lower_jumps();
     exe->push_instruction(OpCode::HALT);
+    exe->resolve_lines();
+
+    Peephole peephole(*exe);
+    exe->m_removed = peephole.run();
+    exe->finalize();
     return exe;
 }
 
+void via::Executable::finalize() noexcept
+{
+    ConstantPool::pack(m_constants, m_pool_entries, m_pool_strings);
+    m_pool = ConstantPool(m_pool_entries, m_pool_strings);
+    m_code = m_bytecode;
+}
+
 void via::Executable::lower_jumps() noexcept
 {
     size_t pc = 0;
@@ -471,6 +1003,25 @@ void via::Executable::lower_jumps() noexcept
             unpack_halves(offset, instr.b, instr.c);
             break;
         }
+        case OpCode::FORPREP:
+        case OpCode::FORLOOP: {
+            uint32_t label = pack_halves<uint32_t>(instr.b, instr.c);
+            uint32_t address = m_labels.at(label);
+
+            // FORPREP only skips forward past the loop, FORLOOP only branches
+            // back to its body
+            uint32_t offset;
+            if (instr.op == OpCode::FORLOOP) {
+                debug::require(address < pc, "FORLOOP target is not behind it");
+                offset = pc - address - 1;
+            } else {
+                debug::require(address >= pc, "FORPREP target is not ahead of it");
+                offset = address - pc + 1;
+            }
+
+            unpack_halves(offset, instr.b, instr.c);
+            break;
+        }
         default:
             break;
         }
@@ -478,6 +1029,217 @@ void via::Executable::lower_jumps() noexcept
     }
 }
 
+// Statements are recorded in the order their code is emitted rather than in
+// source order, so their offsets are resolved through a sorted copy in a
+// single pass over the source
+void via::Executable::resolve_lines() noexcept
+{
+    std::vector<size_t> offsets;
+    for (const auto& [pc, offset]: m_lines)
+        offsets.push_back(offset);
+
+    std::sort(offsets.begin(), offsets.end());
+    offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+
+    const SourceBuffer& source = m_module->source();
+    std::vector<size_t> lines(offsets.size());
+    const char* chr = source.begin();
+
+    for (size_t i = 0, line = 0; i < offsets.size(); i++) {
+        for (; chr < source.end() && chr < source.begin() + offsets[i]; chr++) {
+            if (*chr == '\n')
+                line++;
+        }
+        lines[i] = line;
+    }
+
+    std::vector<std::pair<size_t, size_t>> resolved;
+    for (const auto& [pc, offset]: m_lines) {
+        auto it = std::lower_bound(offsets.begin(), offsets.end(), offset);
+        size_t line = lines[it - offsets.begin()];
+
+        // Statements that emit no code share their first instruction with the
+        // statement after them, which is the one that starts there
+        if (!resolved.empty() && resolved.back().first == pc)
+            resolved.pop_back();
+        if (resolved.empty() || resolved.back().second != line)
+            resolved.emplace_back(pc, line);
+    }
+
+    m_lines = std::move(resolved);
+}
+
+std::optional<size_t> via::Executable::line_of(size_t pc) const noexcept
+{
+    auto it = std::upper_bound(
+        m_lines.begin(),
+        m_lines.end(),
+        pc,
+        [](size_t value, const auto& entry) { return value < entry.first; }
+    );
+
+    if (it == m_lines.begin())
+        return std::nullopt;
+    return std::prev(it)->second;
+}
+
+// Absolute target of a jump at `pc`, or nullopt if `insn` does not branch
+static std::optional<size_t> jump_target(const via::Instruction& insn, size_t pc) noexcept
+{
+    using via::OpCode;
+
+    const via::OpInfo& info = via::op_info(insn.op);
+    std::array<uint16_t, 3> ops = {insn.a, insn.b, insn.c};
+
+    for (size_t i = 0; i < 2; i++) {
+        if (info.operand(i) != via::OpInfo::OFFSET_HIGH)
+            continue;
+
+        size_t offset = via::pack_halves<uint32_t>(ops[i], ops[i + 1]);
+        switch (insn.op) {
+        case OpCode::JMPBACK:
+        case OpCode::JMPBACKIF:
+        case OpCode::JMPBACKIFX:
+        case OpCode::FORLOOP:
+            return pc - offset;
+        default:
+            return pc + offset;
+        }
+    }
+    return std::nullopt;
+}
+
+// Layout, the pool and the code are aligned to 8 so they can be used in place:
+//
+//   u32 count: u32[count]                  symbols named by GETIMPORT
+//   u32 count, u32 size: PoolConstant[count], char[size]
+//   u32 count: Instruction[count]
+//   u32 count: (u32 pc, u32 arity)[count]   memoized closures
+//   u32 count: (u32 pc, u32 line)[count]    line table
+void via::Executable::write_binary(BinaryWriter& writer) const noexcept
+{
+    writer.write<uint32_t>(m_symbols.size());
+    for (SymbolId symbol: m_symbols)
+        writer.write_symbol(symbol);
+
+    auto entries = m_pool.entries();
+    auto strings = m_pool.strings();
+    writer.write<uint32_t>(entries.size());
+    writer.write<uint32_t>(strings.size());
+    writer.align(8);
+    writer.write_bytes(entries.data(), entries.size_bytes());
+    writer.write_bytes(strings.data(), strings.size());
+
+    writer.write<uint32_t>(m_code.size());
+    writer.align(8);
+    writer.write_bytes(m_code.data(), m_code.size_bytes());
+
+    writer.write<uint32_t>(m_memoized.size());
+    for (const auto& [pc, arity]: m_memoized) {
+        writer.write<uint32_t>(pc);
+        writer.write<uint32_t>(arity);
+    }
+
+    writer.write<uint32_t>(m_lines.size());
+    for (const auto& [pc, line]: m_lines) {
+        writer.write<uint32_t>(pc);
+        writer.write<uint32_t>(line);
+    }
+}
+
+via::Executable* via::Executable::build_from_binary(
+    Module* module,
+    DiagContext& diags,
+    BinaryReader& reader,
+    ExeFlags flags
+) noexcept
+{
+    auto& alloc = module->allocator();
+    auto* exe = alloc.emplace<Executable>(diags);
+    exe->m_module = module;
+    exe->m_flags = flags;
+
+    uint32_t count, size;
+    if (!reader.read(count) || count > std::numeric_limits<uint16_t>::max())
+        return nullptr;
+
+    for (uint32_t i = 0; i < count; i++) {
+        auto symbol = reader.read_symbol();
+        if (!symbol.has_value())
+            return nullptr;
+        exe->m_symbols.push_back(*symbol);
+    }
+
+    if (!reader.read(count) || !reader.read(size) ||
+        count > std::numeric_limits<uint16_t>::max() || !reader.align(8))
+        return nullptr;
+
+    auto* entries = reader.view<PoolConstant>(count);
+    auto* strings = reader.view<char>(size);
+    if (entries == nullptr || strings == nullptr)
+        return nullptr;
+
+    exe->m_pool = ConstantPool({entries, count}, {strings, size});
+    if (!exe->m_pool.is_valid())
+        return nullptr;
+
+    if (!reader.read(count) || !reader.align(8))
+        return nullptr;
+
+    auto* code = reader.view<Instruction>(count);
+    if (code == nullptr)
+        return nullptr;
+
+    exe->m_code = {code, count};
+
+    // The code is not copied, so it is checked as is: jumps may only land on an
+    // instruction and operands must refer to entries that exist
+    for (size_t pc = 0; pc < count; pc++) {
+        const Instruction& insn = code[pc];
+        if (!is_valid_opcode(static_cast<uint16_t>(insn.op)))
+            return nullptr;
+
+        const OpInfo& info = op_info(insn.op);
+        std::array<uint16_t, 3> ops = {insn.a, insn.b, insn.c};
+
+        for (size_t i = 0; i < 3; i++) {
+            if (info.operand(i) == OpInfo::CONSTANT && ops[i] >= exe->m_pool.size())
+                return nullptr;
+        }
+
+        if (auto target = jump_target(insn, pc); target && *target >= count)
+            return nullptr;
+
+        if (insn.op == OpCode::GETIMPORT &&
+            (insn.b >= exe->m_symbols.size() || insn.c >= exe->m_symbols.size()))
+            return nullptr;
+    }
+
+    if (!reader.read(count))
+        return nullptr;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t pc, arity;
+        if (!reader.read(pc) || !reader.read(arity) || pc >= exe->m_code.size() ||
+            code[pc].op != OpCode::NEWCLOSURE)
+            return nullptr;
+        exe->m_memoized[pc] = arity;
+    }
+
+    if (!reader.read(count))
+        return nullptr;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t pc, line;
+        if (!reader.read(pc) || !reader.read(line) || pc >= exe->m_code.size() ||
+            (!exe->m_lines.empty() && pc <= exe->m_lines.back().first))
+            return nullptr;
+        exe->m_lines.emplace_back(pc, line);
+    }
+
+    return exe;
+}
+
 std::string via::Executable::to_string() const
 {
     std::ostringstream oss;
@@ -496,7 +1258,7 @@ std::string via::Executable::to_string() const
         ansi::Style::FAINT
     );
 
-    for (size_t pc = 0; const Instruction& insn: m_bytecode) {
+    for (size_t pc = 0; const Instruction& insn: m_code) {
         oss << "  "
             << ansi::format(
                    std::format("0x{:0>4x}", pc * 8),
@@ -507,6 +1269,16 @@ std::string via::Executable::to_string() const
         oss << "  " << insn.to_string(true, pc) << "\n";
         pc++;
     }
+
+    if (m_removed > 0) {
+        oss << ansi::format(
+            std::format("  ({} instructions removed by peephole pass)\n", m_removed),
+            ansi::Foreground::NONE,
+            ansi::Background::NONE,
+            ansi::Style::FAINT
+        );
+    }
+
     oss << ansi::format(
         "\n[disassembly of program data]:\n",
         ansi::Foreground::YELLOW,
@@ -522,10 +1294,11 @@ std::string via::Executable::to_string() const
         ansi::Style::FAINT
     );
 
-    for (size_t i = 0; const auto& cv: m_constants) {
+    for (size_t i = 0; i < m_pool.size(); i++) {
+        ConstValue cv = m_pool.value(i);
         oss << "  "
             << ansi::format(
-                   std::format("0x{:0>4x}", i++),
+                   std::format("0x{:0>4x}", i),
                    ansi::Foreground::NONE,
                    ansi::Background::NONE,
                    ansi::Style::FAINT
@@ -14,14 +14,20 @@
 #include <iostream>
 #include <limits>
 #include <optional>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
 #include <via/config.hpp>
 #include "diagnostics.hpp"
 #include "instruction.hpp"
 #include "ir/ir.hpp"
+#include "pool.hpp"
+#include "profile.hpp"
 #include "sema/const.hpp"
 #include "sema/local_bc.hpp"
 #include "sema/register.hpp"
 #include "sema/stack.hpp"
+#include "support/bit.hpp"
 #include "support/traits.hpp"
 
 namespace via {
@@ -29,6 +35,10 @@ namespace config {
 
 VIA_CONSTANT uint32_t MAGIC = 0x2E766961; // .via
 
+// Maximum number of expression nodes in a loop condition repeated at the
+// bottom of the loop body
+VIA_CONSTANT size_t LOOP_TEST_MAX_NODES = 16;
+
 }
 
 class Executable;
@@ -67,9 +77,14 @@ enum ExeFlags : uint64_t
 };
 
 class Module;
+class Peephole;
+class BinaryReader;
+class BinaryWriter;
 class Executable final
 {
   public:
+    friend class Peephole;
+
     friend void
     detail::set_null_dst_trap(Executable&, const std::optional<uint16_t>& dst) noexcept;
 
@@ -97,19 +112,50 @@ class Executable final
         ExeFlags flags = ExeFlags::NONE
     ) noexcept;
 
+    // Returns nullptr if the bytecode read is malformed: an unknown opcode, a
+    // constant operand out of range or a jump leaving the program
     static Executable* build_from_binary(
         Module* module,
         DiagContext& diags,
-        std::ostream& bytes,
+        BinaryReader& reader,
         ExeFlags flags = ExeFlags::NONE
     ) noexcept;
 
+    void write_binary(BinaryWriter& writer) const noexcept;
+
   public:
     auto flags() const noexcept { return m_flags; }
-    auto& constants() const noexcept { return m_constants; }
-    auto& bytecode() const noexcept { return m_bytecode; }
+    auto& constants() const noexcept { return m_pool; }
+    auto bytecode() const noexcept { return m_code; }
+    auto removed_instructions() const noexcept { return m_removed; }
     std::string to_string() const;
 
+    // Source line of the statement `pc` belongs to, counting from zero
+    std::optional<size_t> line_of(size_t pc) const noexcept;
+
+    std::optional<ProfileSite> site_of(size_t pc) const noexcept
+    {
+        if (auto it = m_sites.find(pc); it != m_sites.end())
+            return it->second;
+        return std::nullopt;
+    }
+
+    // Symbol GETIMPORT operands refer to by slot
+    SymbolId symbol(uint16_t slot) const noexcept
+    {
+        debug::require(slot < m_symbols.size(), "symbol slot out of range");
+        return m_symbols[slot];
+    }
+
+    // Parameter count of the memoized function whose closure is created at
+    // `pc`, or nullopt if its results are not memoized
+    std::optional<size_t> memo_arity(size_t pc) const noexcept
+    {
+        if (auto it = m_memoized.find(pc); it != m_memoized.end())
+            return it->second;
+        return std::nullopt;
+    }
+
   private:
     size_t program_counter() const noexcept { return m_bytecode.size() - 1; }
     size_t constant_id() const noexcept { return m_constants.size() - 1; }
@@ -119,6 +165,13 @@ class Executable final
         return m_labels.size() - 1;
     }
 
+    // Labels internal to an expression, counting down from the top of the label
+    // space so they never collide with block ids
+    size_t new_label() noexcept
+    {
+        return std::numeric_limits<uint32_t>::max() - m_local_labels++;
+    }
+
     void push_constant(ConstValue cv) noexcept
     {
         debug::require(
@@ -134,6 +187,41 @@ class Executable final
         return program_counter();
     }
 
+    // Records the next instruction as the first of the statement at `loc`.
+    // Instructions made up by passes have no location and are not recorded.
+    void mark_line(SourceLoc loc) noexcept
+    {
+        if (loc.end != 0)
+            m_lines.emplace_back(m_bytecode.size(), loc.begin);
+    }
+
+    // Emits a jump to `label`, resolved by lower_jumps. Conditional jumps take
+    // the register holding the condition.
+    size_t push_jump(OpCode op, size_t label, std::optional<uint16_t> reg = {}) noexcept
+    {
+        uint16_t high, low;
+        unpack_halves(static_cast<uint32_t>(label), high, low);
+        if (reg.has_value())
+            return push_instruction(op, {*reg, high, low});
+        return push_instruction(op, {high, low});
+    }
+
+    // Slot of `symbol` in the symbol table of the executable
+    uint16_t symbol_slot(SymbolId symbol) noexcept
+    {
+        for (size_t slot = 0; slot < m_symbols.size(); slot++) {
+            if (m_symbols[slot] == symbol)
+                return static_cast<uint16_t>(slot);
+        }
+
+        debug::require(
+            m_symbols.size() < (size_t) std::numeric_limits<uint16_t>::max(),
+            "Symbol count exceeds limit"
+        );
+        m_symbols.push_back(symbol);
+        return static_cast<uint16_t>(m_symbols.size() - 1);
+    }
+
     void set_instruction(size_t pc, OpCode op, std::array<uint16_t, 3> ops = {}) noexcept
     {
         auto& insn = m_bytecode[pc];
@@ -143,10 +231,48 @@ class Executable final
         insn.c = ops[2];
     }
 
+    std::optional<uint16_t> get_inline_register(SymbolId symbol) const noexcept
+    {
+        if (m_inline_frames.empty())
+            return std::nullopt;
+
+        auto& frame = m_inline_frames.back();
+        for (auto it = frame.rbegin(); it != frame.rend(); ++it) {
+            if (it->first == symbol)
+                return it->second;
+        }
+        return std::nullopt;
+    }
+
+    std::optional<uint16_t> get_arg(SymbolId symbol) const noexcept
+    {
+        if (m_arg_frames.empty())
+            return std::nullopt;
+
+        auto& parms = m_arg_frames.back();
+        for (size_t i = parms.size(); i-- > 0;) {
+            if (parms[i] == symbol)
+                return static_cast<uint16_t>(i);
+        }
+        return std::nullopt;
+    }
+
     void lower_expr(const ir::Expr* expr, std::optional<uint16_t> dst) noexcept;
     void lower_stmt(const ir::Stmt* stmt) noexcept;
     void lower_term(const ir::Term* term) noexcept;
+    void
+    lower_block(const ir::StmtBlock* block, std::optional<size_t> fallthrough) noexcept;
+    void lower_out_of_line() noexcept;
+    bool is_out_of_line(const ir::Stmt* stmt) const noexcept;
+    void mark_cold_blocks(const ir::Stmt* stmt, const Profile& profile) noexcept;
+    void lower_branch(
+        const ir::Expr* cond,
+        std::optional<size_t> iftrue,
+        std::optional<size_t> iffalse
+    ) noexcept;
     void lower_jumps() noexcept;
+    void resolve_lines() noexcept;
+    void finalize() noexcept;
 
   private:
     Module* m_module;
@@ -156,6 +282,68 @@ class Executable final
     std::vector<Instruction> m_bytecode;
     std::vector<ConstValue> m_constants;
     std::unordered_map<size_t, size_t> m_labels;
+
+    // What the VM runs. Views into the storage below once lowering ends, or
+    // into the file of a compiled module, which is used in place.
+    std::span<const Instruction> m_code;
+    ConstantPool m_pool;
+    std::vector<PoolConstant> m_pool_entries;
+    std::string m_pool_strings;
+
+    // Symbols named by GETIMPORT operands. Operands hold slots in this table
+    // rather than symbol ids, which differ between processes, so the code of a
+    // compiled module can be run without patching it.
+    std::vector<SymbolId> m_symbols;
+    size_t m_local_labels = 0;
+
+    // Parameters of the functions being lowered, in argument order
+    std::vector<std::vector<SymbolId>> m_arg_frames;
+
+    // Functions being lowered, a body reads its own function with GETCALLEE
+    std::vector<SymbolId> m_callees;
+
+    // Symbol to register bindings of the inline expansions being lowered
+    std::vector<std::vector<std::pair<SymbolId, uint16_t>>> m_inline_frames;
+
+    // Range loops being lowered, `slot` is the local holding the counter
+    struct LoopVar
+    {
+        const ir::TrForPrep* prep;
+        uint16_t slot;
+    };
+
+    std::vector<LoopVar> m_loop_vars;
+
+    // Source sites of the instructions the VM reports to an attached profile
+    std::unordered_map<size_t, ProfileSite> m_sites;
+
+    // NEWCLOSURE instructions of memoized functions, mapped to their arity
+    std::unordered_map<size_t, size_t> m_memoized;
+
+    // First instruction of each statement with the line it starts on, sorted by
+    // instruction. Holds source offsets instead of lines until lowering ends.
+    std::vector<std::pair<size_t, size_t>> m_lines;
+
+    // Instructions the peephole pass removed from the lowered code
+    size_t m_removed = 0;
+
+    // Blocks the profile shows are rarely entered. They are lowered after the
+    // rest of their function, with the frame they would have been lowered in.
+    struct OutOfLine
+    {
+        const ir::StmtBlock* block;
+        Frame<BytecodeLocal> frame;
+    };
+
+    std::unordered_set<size_t> m_cold_blocks;
+    std::vector<std::vector<OutOfLine>> m_out_of_line;
+
+    // Blocks made of a condition only, with the frame they were lowered in. A
+    // branch back to one repeats the test instead of jumping to it.
+    std::unordered_map<size_t, Frame<BytecodeLocal>> m_loop_tests;
+
+    // Block laid out right after the terminator being lowered, if any
+    std::optional<size_t> m_fallthrough;
 };
 
 } // namespace via
@@ -7,11 +7,13 @@
 **         https://github.com/XnLogicaL/via-lang         **
 ** ===================================================== */
 
+#include <cmath>
 #include "debug.hpp"
 #include "machine.hpp"
 #include "module/manager.hpp"
 #include "ref.hpp"
 #include "support/bit.hpp"
+#include "support/math.hpp"
 #include "value.hpp"
 
 #if defined(VIA_COMPILER_GCC) || defined(VIA_COMPILER_CLANG)
@@ -35,27 +37,26 @@
         }                                                                                \
     }
 
-#define CONST_VALUE(ID)                                                                  \
-    ({                                                                                   \
-        auto cv = consts.at(ID);                                                         \
-        auto* val = Value::create(vm, cv);                                               \
-        val;                                                                             \
-    })
+#define CONST_VALUE(ID) Value::create(vm, consts, ID)
 
-#define CONST_VALUE_REF(ID)                                                              \
-    ({                                                                                   \
-        auto cv = consts.at(ID);                                                         \
-        auto* val = Value::create(vm, cv);                                               \
-        ValueRef(vm, val);                                                               \
-    })
+// Reads a constant in place, without materializing a value for it
+#define CONST_INT(ID) consts.integer(ID)
+#define CONST_FLOAT(ID) consts.float_(ID)
+#define CONST_BOOL(ID) consts.boolean(ID)
+#define CONST_STRING(ID) consts.string(ID)
+#define CONST_VALUE_REF(ID) ValueRef(vm, CONST_VALUE(ID))
 
 #define GET_LOCAL(ID) reinterpret_cast<Value*>(stack.at(ID))
 #define SET_LOCAL(ID, VAL) stack.at(ID) = reinterpret_cast<uintptr_t>(VAL);
 #define FREE_LOCAL(ID)                                                                   \
-    if (GET_REGISTER(ID) != nullptr) {                                                   \
+    if (stack.at(ID) != 0) {                                                             \
         reinterpret_cast<Value*>(stack.at(ID))->unref();                                 \
     }
 
+// Arguments sit below the four words saved by `call`, the first one on top
+#define GET_ARG(ID) reinterpret_cast<Value*>(*(vm->m_fp - 4 - (ID)))
+#define GET_CALLEE() reinterpret_cast<Value*>(*(vm->m_fp - 3))
+
 #define GET_REGISTER(ID) regs[ID]
 #define SET_REGISTER(ID, VAL) regs[ID] = VAL
 #define FREE_REGISTER(ID)                                                                \
@@ -64,6 +65,12 @@
         SET_REGISTER(ID, nullptr);                                                       \
     }
 
+// Only the profiling instantiation of the interpreter calls the hooks
+#define PROFILE(HOOK)                                                                    \
+    if constexpr (Profiling) {                                                           \
+        vm->HOOK;                                                                        \
+    }
+
 #define JUMP_FWD(OFF) pc += (OFF) - 1
 #define JUMP_BACK(OFF) pc -= (OFF) + 1
 
@@ -74,7 +81,7 @@
 
 #define DEBUG_TRAP(FORMAT, ...) debug::bug(std::format(FORMAT, __VA_ARGS__));
 
-template <bool SingleStep, bool OverridePC>
+template <bool SingleStep, bool OverridePC, bool Profiling>
 [[gnu::flatten]] void via::detail::execute(VirtualMachine* vm)
 {
 #ifdef HAS_CGOTO
@@ -169,8 +176,7 @@ template <bool SingleStep, bool OverridePC>
         CASE(COPY)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(a, GET_REGISTER(pc->b)->clone());
+            Value::store_copy(vm, GET_REGISTER(a), GET_REGISTER(pc->b));
             DISPATCH();
         }
         CASE(COPYREF)
@@ -180,6 +186,19 @@ template <bool SingleStep, bool OverridePC>
             SET_REGISTER(a, GET_REGISTER(pc->b));
             DISPATCH();
         }
+        CASE(SELECT)
+        {
+            // R[a] = R[b] ? R[c] : R[c + 1], both arms are consumed
+            CSE_OPERANDS_A();
+            bool cond = GET_REGISTER(pc->b)->as_cbool();
+            const uint16_t taken = pc->c + !cond, other = pc->c + cond;
+
+            FREE_REGISTER(a);
+            SET_REGISTER(a, GET_REGISTER(taken));
+            SET_REGISTER(taken, nullptr);
+            FREE_REGISTER(other);
+            DISPATCH();
+        }
         CASE(LOADK)
         {
             CSE_OPERANDS_A();
@@ -197,26 +216,23 @@ template <bool SingleStep, bool OverridePC>
         CASE(LOADTRUE)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(a, Value::create(vm, true));
+            Value::store(vm, GET_REGISTER(a), true);
             DISPATCH();
         }
         CASE(LOADFALSE)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(a, Value::create(vm, false));
+            Value::store(vm, GET_REGISTER(a), false);
             DISPATCH();
         }
         CASE(LOADINT)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    static_cast<int64_t>(pack_halves<uint32_t>(pc->b, pc->c))
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                static_cast<int64_t>(
+                    static_cast<int32_t>(pack_halves<uint32_t>(pc->b, pc->c))
                 )
             );
             DISPATCH();
@@ -231,6 +247,7 @@ template <bool SingleStep, bool OverridePC>
         CASE(NEWCLOSURE)
         {
             auto closure = Closure::create(vm, vm->m_pc);
+            FREE_REGISTER(pc->a);
             SET_REGISTER(pc->a, Value::create(vm, closure));
             JUMP_FWD(pack_halves<uint32_t>(pc->b, pc->c));
             DISPATCH();
@@ -238,15 +255,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(IADD)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    int64_t(
-                        GET_REGISTER(pc->b)->m_data.integer +
-                        GET_REGISTER(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(
+                    GET_REGISTER(pc->b)->m_data.integer +
+                    GET_REGISTER(pc->c)->m_data.integer
                 )
             );
             DISPATCH();
@@ -254,15 +268,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(IADDK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    int64_t(
-                        GET_REGISTER(pc->b)->m_data.integer +
-                        CONST_VALUE(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(
+                    GET_REGISTER(pc->b)->m_data.integer +
+                    CONST_INT(pc->c)
                 )
             );
             DISPATCH();
@@ -270,15 +281,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FADD)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    double_t(
-                        GET_REGISTER(pc->b)->m_data.float_ +
-                        GET_REGISTER(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                double_t(
+                    GET_REGISTER(pc->b)->m_data.float_ +
+                    GET_REGISTER(pc->c)->m_data.float_
                 )
             );
             DISPATCH();
@@ -286,15 +294,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FADDK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    double_t(
-                        GET_REGISTER(pc->b)->m_data.float_ +
-                        CONST_VALUE(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                double_t(
+                    GET_REGISTER(pc->b)->m_data.float_ +
+                    CONST_FLOAT(pc->c)
                 )
             );
             DISPATCH();
@@ -302,15 +307,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(ISUB)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    int64_t(
-                        GET_REGISTER(pc->b)->m_data.integer -
-                        GET_REGISTER(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(
+                    GET_REGISTER(pc->b)->m_data.integer -
+                    GET_REGISTER(pc->c)->m_data.integer
                 )
             );
             DISPATCH();
@@ -318,15 +320,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(ISUBK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    int64_t(
-                        GET_REGISTER(pc->b)->m_data.integer -
-                        CONST_VALUE(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(
+                    GET_REGISTER(pc->b)->m_data.integer -
+                    CONST_INT(pc->c)
                 )
             );
             DISPATCH();
@@ -334,15 +333,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FSUB)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    double_t(
-                        GET_REGISTER(pc->b)->m_data.float_ -
-                        GET_REGISTER(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                double_t(
+                    GET_REGISTER(pc->b)->m_data.float_ -
+                    GET_REGISTER(pc->c)->m_data.float_
                 )
             );
             DISPATCH();
@@ -350,15 +346,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FSUBK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    double_t(
-                        GET_REGISTER(pc->b)->m_data.float_ -
-                        CONST_VALUE(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                double_t(
+                    GET_REGISTER(pc->b)->m_data.float_ -
+                    CONST_FLOAT(pc->c)
                 )
             );
             DISPATCH();
@@ -366,15 +359,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(IMUL)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    int64_t(
-                        GET_REGISTER(pc->b)->m_data.integer *
-                        GET_REGISTER(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(
+                    GET_REGISTER(pc->b)->m_data.integer *
+                    GET_REGISTER(pc->c)->m_data.integer
                 )
             );
             DISPATCH();
@@ -382,15 +372,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(IMULK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    int64_t(
-                        GET_REGISTER(pc->b)->m_data.integer *
-                        CONST_VALUE(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(
+                    GET_REGISTER(pc->b)->m_data.integer *
+                    CONST_INT(pc->c)
                 )
             );
             DISPATCH();
@@ -398,15 +385,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FMUL)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    double_t(
-                        GET_REGISTER(pc->b)->m_data.float_ *
-                        GET_REGISTER(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                double_t(
+                    GET_REGISTER(pc->b)->m_data.float_ *
+                    GET_REGISTER(pc->c)->m_data.float_
                 )
             );
             DISPATCH();
@@ -414,15 +398,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FMULK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    double_t(
-                        GET_REGISTER(pc->b)->m_data.float_ *
-                        CONST_VALUE(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                double_t(
+                    GET_REGISTER(pc->b)->m_data.float_ *
+                    CONST_FLOAT(pc->c)
                 )
             );
             DISPATCH();
@@ -430,15 +411,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(IDIV)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    int64_t(
-                        GET_REGISTER(pc->b)->m_data.integer /
-                        GET_REGISTER(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(
+                    GET_REGISTER(pc->b)->m_data.integer /
+                    GET_REGISTER(pc->c)->m_data.integer
                 )
             );
             DISPATCH();
@@ -446,15 +424,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(IDIVK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    int64_t(
-                        GET_REGISTER(pc->b)->m_data.integer /
-                        CONST_VALUE(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(
+                    GET_REGISTER(pc->b)->m_data.integer /
+                    CONST_INT(pc->c)
                 )
             );
             DISPATCH();
@@ -462,15 +437,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FDIV)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    double_t(
-                        GET_REGISTER(pc->b)->m_data.float_ /
-                        GET_REGISTER(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                double_t(
+                    GET_REGISTER(pc->b)->m_data.float_ /
+                    GET_REGISTER(pc->c)->m_data.float_
                 )
             );
             DISPATCH();
@@ -478,71 +450,175 @@ template <bool SingleStep, bool OverridePC>
         CASE(FDIVK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    double_t(
-                        GET_REGISTER(pc->b)->m_data.float_ /
-                        CONST_VALUE(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                double_t(
+                    GET_REGISTER(pc->b)->m_data.float_ /
+                    CONST_FLOAT(pc->c)
                 )
             );
             DISPATCH();
         }
+        CASE(IPOW)
+        {
+            CSE_OPERANDS_A();
+            int64_t exp = GET_REGISTER(pc->c)->m_data.integer;
+            [[unlikely]] if (exp < 0) {
+                vm->raise("negative integer exponent");
+                DISPATCH();
+            }
+
+            // Computed unsigned so overflow wraps like the other integer opcodes
+            auto base = static_cast<uint64_t>(GET_REGISTER(pc->b)->m_data.integer);
+            auto power = ipow<uint64_t>(base, static_cast<uint64_t>(exp));
+            Value::store(vm, GET_REGISTER(a), static_cast<int64_t>(power));
+            DISPATCH();
+        }
+        CASE(IPOWK)
+        {
+            CSE_OPERANDS_A();
+            int64_t exp = CONST_INT(pc->c);
+            [[unlikely]] if (exp < 0) {
+                vm->raise("negative integer exponent");
+                DISPATCH();
+            }
+
+            // Computed unsigned so overflow wraps like the other integer opcodes
+            auto base = static_cast<uint64_t>(GET_REGISTER(pc->b)->m_data.integer);
+            auto power = ipow<uint64_t>(base, static_cast<uint64_t>(exp));
+            Value::store(vm, GET_REGISTER(a), static_cast<int64_t>(power));
+            DISPATCH();
+        }
+        CASE(FPOW)
+        {
+            CSE_OPERANDS_A();
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                double_t(std::pow(
+                    GET_REGISTER(pc->b)->m_data.float_,
+                    GET_REGISTER(pc->c)->m_data.float_
+                ))
+            );
+            DISPATCH();
+        }
+        CASE(FPOWK)
+        {
+            CSE_OPERANDS_A();
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                double_t(std::pow(
+                    GET_REGISTER(pc->b)->m_data.float_,
+                    CONST_FLOAT(pc->c)
+                ))
+            );
+            DISPATCH();
+        }
+        CASE(IMOD)
+        {
+            CSE_OPERANDS_A();
+            int64_t divisor = GET_REGISTER(pc->c)->m_data.integer;
+            [[unlikely]] if (divisor == 0) {
+                vm->raise("integer modulo by zero");
+                DISPATCH();
+            }
+
+            // -1 would overflow INT64_MIN, and any integer modulo -1 is zero
+            int64_t dividend = GET_REGISTER(pc->b)->m_data.integer;
+            Value::store(vm, GET_REGISTER(a), divisor == -1 ? 0 : dividend % divisor);
+            DISPATCH();
+        }
+        CASE(IMODK)
+        {
+            CSE_OPERANDS_A();
+            int64_t divisor = CONST_INT(pc->c);
+            [[unlikely]] if (divisor == 0) {
+                vm->raise("integer modulo by zero");
+                DISPATCH();
+            }
+
+            // -1 would overflow INT64_MIN, and any integer modulo -1 is zero
+            int64_t dividend = GET_REGISTER(pc->b)->m_data.integer;
+            Value::store(vm, GET_REGISTER(a), divisor == -1 ? 0 : dividend % divisor);
+            DISPATCH();
+        }
+        CASE(FMOD)
+        {
+            CSE_OPERANDS_A();
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                double_t(std::fmod(
+                    GET_REGISTER(pc->b)->m_data.float_,
+                    GET_REGISTER(pc->c)->m_data.float_
+                ))
+            );
+            DISPATCH();
+        }
+        CASE(FMODK)
+        {
+            CSE_OPERANDS_A();
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                double_t(std::fmod(
+                    GET_REGISTER(pc->b)->m_data.float_,
+                    CONST_FLOAT(pc->c)
+                ))
+            );
+            DISPATCH();
+        }
         CASE(INEG)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(vm, int64_t(-GET_REGISTER(pc->b)->m_data.integer))
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(-GET_REGISTER(pc->b)->m_data.integer)
             );
             DISPATCH();
         }
         CASE(INEGK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(vm, int64_t(-CONST_VALUE(pc->b)->m_data.integer))
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(-CONST_INT(pc->b))
             );
             DISPATCH();
         }
         CASE(FNEG)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(vm, double_t(-GET_REGISTER(pc->b)->m_data.float_))
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                double_t(-GET_REGISTER(pc->b)->m_data.float_)
             );
             DISPATCH();
         }
         CASE(FNEGK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(vm, double_t(-CONST_VALUE(pc->b)->m_data.float_))
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                double_t(-CONST_FLOAT(pc->b))
             );
             DISPATCH();
         }
         CASE(BAND)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    int64_t(
-                        GET_REGISTER(pc->b)->m_data.integer &
-                        GET_REGISTER(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(
+                    GET_REGISTER(pc->b)->m_data.integer &
+                    GET_REGISTER(pc->c)->m_data.integer
                 )
             );
             DISPATCH();
@@ -550,15 +626,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(BANDK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    int64_t(
-                        GET_REGISTER(pc->b)->m_data.integer &
-                        CONST_VALUE(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(
+                    GET_REGISTER(pc->b)->m_data.integer &
+                    CONST_INT(pc->c)
                 )
             );
             DISPATCH();
@@ -566,15 +639,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(BOR)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    int64_t(
-                        GET_REGISTER(pc->b)->m_data.integer |
-                        GET_REGISTER(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(
+                    GET_REGISTER(pc->b)->m_data.integer |
+                    GET_REGISTER(pc->c)->m_data.integer
                 )
             );
             DISPATCH();
@@ -582,15 +652,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(BORK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    int64_t(
-                        GET_REGISTER(pc->b)->m_data.integer |
-                        CONST_VALUE(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(
+                    GET_REGISTER(pc->b)->m_data.integer |
+                    CONST_INT(pc->c)
                 )
             );
             DISPATCH();
@@ -598,15 +665,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(BXOR)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    int64_t(
-                        GET_REGISTER(pc->b)->m_data.integer ^
-                        GET_REGISTER(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(
+                    GET_REGISTER(pc->b)->m_data.integer ^
+                    GET_REGISTER(pc->c)->m_data.integer
                 )
             );
             DISPATCH();
@@ -614,15 +678,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(BXORK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    int64_t(
-                        GET_REGISTER(pc->b)->m_data.integer ^
-                        CONST_VALUE(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(
+                    GET_REGISTER(pc->b)->m_data.integer ^
+                    CONST_INT(pc->c)
                 )
             );
             DISPATCH();
@@ -630,15 +691,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(BSHL)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    int64_t(
-                        GET_REGISTER(pc->b)->m_data.integer
-                        << GET_REGISTER(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(
+                    GET_REGISTER(pc->b)->m_data.integer
+                    << GET_REGISTER(pc->c)->m_data.integer
                 )
             );
             DISPATCH();
@@ -646,15 +704,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(BSHLK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    int64_t(
-                        GET_REGISTER(pc->b)->m_data.integer
-                        << CONST_VALUE(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(
+                    GET_REGISTER(pc->b)->m_data.integer
+                    << CONST_INT(pc->c)
                 )
             );
             DISPATCH();
@@ -662,15 +717,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(BSHR)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    int64_t(
-                        GET_REGISTER(pc->b)->m_data.integer >>
-                        GET_REGISTER(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(
+                    GET_REGISTER(pc->b)->m_data.integer >>
+                    GET_REGISTER(pc->c)->m_data.integer
                 )
             );
             DISPATCH();
@@ -678,15 +730,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(BSHRK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    int64_t(
-                        GET_REGISTER(pc->b)->m_data.integer >>
-                        CONST_VALUE(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(
+                    GET_REGISTER(pc->b)->m_data.integer >>
+                    CONST_INT(pc->c)
                 )
             );
             DISPATCH();
@@ -694,35 +743,32 @@ template <bool SingleStep, bool OverridePC>
         CASE(BNOT)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(vm, int64_t(~GET_REGISTER(pc->b)->m_data.integer))
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(~GET_REGISTER(pc->b)->m_data.integer)
             );
             DISPATCH();
         }
         CASE(BNOTK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(vm, int64_t(CONST_VALUE(pc->b)->m_data.integer))
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                int64_t(CONST_INT(pc->b))
             );
             DISPATCH();
         }
         CASE(AND)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.boolean &&
-                        GET_REGISTER(pc->c)->m_data.boolean
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.boolean &&
+                    GET_REGISTER(pc->c)->m_data.boolean
                 )
             );
             DISPATCH();
@@ -730,15 +776,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(ANDK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.boolean &&
-                        CONST_VALUE(pc->c)->m_data.boolean
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.boolean &&
+                    CONST_BOOL(pc->c)
                 )
             );
             DISPATCH();
@@ -746,15 +789,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(OR)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.boolean ||
-                        GET_REGISTER(pc->c)->m_data.boolean
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.boolean ||
+                    GET_REGISTER(pc->c)->m_data.boolean
                 )
             );
             DISPATCH();
@@ -762,15 +802,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(ORK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.boolean ||
-                        CONST_VALUE(pc->c)->m_data.boolean
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.boolean ||
+                    CONST_BOOL(pc->c)
                 )
             );
             DISPATCH();
@@ -778,15 +815,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(IEQ)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.integer ==
-                        GET_REGISTER(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.integer ==
+                    GET_REGISTER(pc->c)->m_data.integer
                 )
             );
             DISPATCH();
@@ -794,15 +828,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(IEQK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.integer ==
-                        CONST_VALUE(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.integer ==
+                    CONST_INT(pc->c)
                 )
             );
             DISPATCH();
@@ -810,15 +841,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FEQ)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.float_ ==
-                        GET_REGISTER(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.float_ ==
+                    GET_REGISTER(pc->c)->m_data.float_
                 )
             );
             DISPATCH();
@@ -826,15 +854,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FEQK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.float_ ==
-                        CONST_VALUE(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.float_ ==
+                    CONST_FLOAT(pc->c)
                 )
             );
             DISPATCH();
@@ -842,15 +867,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(BEQ)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.boolean ==
-                        GET_REGISTER(pc->c)->m_data.boolean
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.boolean ==
+                    GET_REGISTER(pc->c)->m_data.boolean
                 )
             );
             DISPATCH();
@@ -858,15 +880,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(BEQK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.boolean ==
-                        CONST_VALUE(pc->c)->m_data.boolean
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.boolean ==
+                    CONST_BOOL(pc->c)
                 )
             );
             DISPATCH();
@@ -874,17 +893,14 @@ template <bool SingleStep, bool OverridePC>
         CASE(SEQ)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a)
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        std::strcmp(
-                            GET_REGISTER(pc->b)->m_data.string,
-                            GET_REGISTER(pc->c)->m_data.string
-                        ) == 0
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    std::strcmp(
+                        GET_REGISTER(pc->b)->m_data.string,
+                        GET_REGISTER(pc->c)->m_data.string
+                    ) == 0
                 )
             );
             DISPATCH();
@@ -892,17 +908,14 @@ template <bool SingleStep, bool OverridePC>
         CASE(SEQK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a)
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        std::strcmp(
-                            GET_REGISTER(pc->b)->m_data.string,
-                            CONST_VALUE(pc->c)->m_data.string
-                        ) == 0
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    std::strcmp(
+                        GET_REGISTER(pc->b)->m_data.string,
+                        CONST_STRING(pc->c)
+                    ) == 0
                 )
             );
             DISPATCH();
@@ -910,15 +923,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(INEQ)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.integer !=
-                        GET_REGISTER(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.integer !=
+                    GET_REGISTER(pc->c)->m_data.integer
                 )
             );
             DISPATCH();
@@ -926,15 +936,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(INEQK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.integer !=
-                        CONST_VALUE(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.integer !=
+                    CONST_INT(pc->c)
                 )
             );
             DISPATCH();
@@ -942,15 +949,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FNEQ)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.float_ !=
-                        GET_REGISTER(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.float_ !=
+                    GET_REGISTER(pc->c)->m_data.float_
                 )
             );
             DISPATCH();
@@ -958,15 +962,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FNEQK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.float_ !=
-                        CONST_VALUE(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.float_ !=
+                    CONST_FLOAT(pc->c)
                 )
             );
             DISPATCH();
@@ -974,15 +975,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(BNEQ)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.boolean !=
-                        GET_REGISTER(pc->c)->m_data.boolean
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.boolean !=
+                    GET_REGISTER(pc->c)->m_data.boolean
                 )
             );
             DISPATCH();
@@ -990,15 +988,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(BNEQK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.boolean !=
-                        CONST_VALUE(pc->c)->m_data.boolean
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.boolean !=
+                    CONST_BOOL(pc->c)
                 )
             );
             DISPATCH();
@@ -1006,17 +1001,14 @@ template <bool SingleStep, bool OverridePC>
         CASE(SNEQ)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a)
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        std::strcmp(
-                            GET_REGISTER(pc->b)->m_data.string,
-                            GET_REGISTER(pc->c)->m_data.string
-                        ) != 0
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    std::strcmp(
+                        GET_REGISTER(pc->b)->m_data.string,
+                        GET_REGISTER(pc->c)->m_data.string
+                    ) != 0
                 )
             );
             DISPATCH();
@@ -1024,17 +1016,14 @@ template <bool SingleStep, bool OverridePC>
         CASE(SNEQK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a)
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        std::strcmp(
-                            GET_REGISTER(pc->b)->m_data.string,
-                            CONST_VALUE(pc->c)->m_data.string
-                        ) != 0
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    std::strcmp(
+                        GET_REGISTER(pc->b)->m_data.string,
+                        CONST_STRING(pc->c)
+                    ) != 0
                 )
             );
             DISPATCH();
@@ -1042,25 +1031,22 @@ template <bool SingleStep, bool OverridePC>
         CASE(IS)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(vm, bool(GET_REGISTER(pc->b) == GET_REGISTER(pc->c)))
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(GET_REGISTER(pc->b) == GET_REGISTER(pc->c))
             );
             DISPATCH();
         }
         CASE(ILT)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.integer <
-                        GET_REGISTER(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.integer <
+                    GET_REGISTER(pc->c)->m_data.integer
                 )
             );
             DISPATCH();
@@ -1068,15 +1054,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(ILTK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.integer <
-                        CONST_VALUE(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.integer <
+                    CONST_INT(pc->c)
                 )
             );
             DISPATCH();
@@ -1084,15 +1067,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FLT)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.float_ <
-                        GET_REGISTER(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.float_ <
+                    GET_REGISTER(pc->c)->m_data.float_
                 )
             );
             DISPATCH();
@@ -1100,15 +1080,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FLTK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.float_ <
-                        CONST_VALUE(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.float_ <
+                    CONST_FLOAT(pc->c)
                 )
             );
             DISPATCH();
@@ -1116,15 +1093,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(IGT)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.integer >
-                        GET_REGISTER(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.integer >
+                    GET_REGISTER(pc->c)->m_data.integer
                 )
             );
             DISPATCH();
@@ -1132,15 +1106,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(IGTK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.integer >
-                        CONST_VALUE(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.integer >
+                    CONST_INT(pc->c)
                 )
             );
             DISPATCH();
@@ -1148,15 +1119,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FGT)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.float_ >
-                        GET_REGISTER(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.float_ >
+                    GET_REGISTER(pc->c)->m_data.float_
                 )
             );
             DISPATCH();
@@ -1164,15 +1132,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FGTK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.float_ >
-                        CONST_VALUE(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.float_ >
+                    CONST_FLOAT(pc->c)
                 )
             );
             DISPATCH();
@@ -1180,15 +1145,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(ILTEQ)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.integer <=
-                        GET_REGISTER(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.integer <=
+                    GET_REGISTER(pc->c)->m_data.integer
                 )
             );
             DISPATCH();
@@ -1196,15 +1158,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(ILTEQK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.integer <=
-                        CONST_VALUE(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.integer <=
+                    CONST_INT(pc->c)
                 )
             );
             DISPATCH();
@@ -1212,15 +1171,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FLTEQ)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.float_ <=
-                        GET_REGISTER(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.float_ <=
+                    GET_REGISTER(pc->c)->m_data.float_
                 )
             );
             DISPATCH();
@@ -1228,15 +1184,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FLTEQK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.float_ <=
-                        CONST_VALUE(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.float_ <=
+                    CONST_FLOAT(pc->c)
                 )
             );
             DISPATCH();
@@ -1244,15 +1197,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(IGTEQ)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.integer >=
-                        GET_REGISTER(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.integer >=
+                    GET_REGISTER(pc->c)->m_data.integer
                 )
             );
             DISPATCH();
@@ -1260,15 +1210,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(IGTEQK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.integer >=
-                        CONST_VALUE(pc->c)->m_data.integer
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.integer >=
+                    CONST_INT(pc->c)
                 )
             );
             DISPATCH();
@@ -1276,15 +1223,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FGTEQ)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.float_ >=
-                        GET_REGISTER(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.float_ >=
+                    GET_REGISTER(pc->c)->m_data.float_
                 )
             );
             DISPATCH();
@@ -1292,15 +1236,12 @@ template <bool SingleStep, bool OverridePC>
         CASE(FGTEQK)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(
-                    vm,
-                    bool(
-                        GET_REGISTER(pc->b)->m_data.float_ >=
-                        CONST_VALUE(pc->c)->m_data.float_
-                    )
+            Value::store(
+                vm,
+                GET_REGISTER(a),
+                bool(
+                    GET_REGISTER(pc->b)->m_data.float_ >=
+                    CONST_FLOAT(pc->c)
                 )
             );
             DISPATCH();
@@ -1308,11 +1249,7 @@ template <bool SingleStep, bool OverridePC>
         CASE(NOT)
         {
             CSE_OPERANDS_A();
-            FREE_REGISTER(a);
-            SET_REGISTER(
-                a,
-                Value::create(vm, bool(!GET_REGISTER(pc->b)->m_data.boolean))
-            );
+            Value::store(vm, GET_REGISTER(a), bool(!GET_REGISTER(pc->b)->m_data.boolean));
             DISPATCH();
         }
         CASE(JMP)
@@ -1322,7 +1259,10 @@ template <bool SingleStep, bool OverridePC>
         }
         CASE(JMPIF)
         {
-            if (GET_REGISTER(pc->a)->as_cbool()) {
+            bool cond = GET_REGISTER(pc->a)->as_cbool();
+            PROFILE(profile_branch(pc, cond));
+
+            if (cond) {
                 JUMP_FWD(pack_halves<uint32_t>(pc->b, pc->c));
                 DISPATCH();
             }
@@ -1330,7 +1270,10 @@ template <bool SingleStep, bool OverridePC>
         }
         CASE(JMPIFX)
         {
-            if (!GET_REGISTER(pc->a)->as_cbool()) {
+            bool cond = GET_REGISTER(pc->a)->as_cbool();
+            PROFILE(profile_branch(pc, cond));
+
+            if (!cond) {
                 JUMP_FWD(pack_halves<uint32_t>(pc->b, pc->c));
                 DISPATCH();
             }
@@ -1343,7 +1286,10 @@ template <bool SingleStep, bool OverridePC>
         }
         CASE(JMPBACKIF)
         {
-            if (GET_REGISTER(pc->a)->as_cbool()) {
+            bool cond = GET_REGISTER(pc->a)->as_cbool();
+            PROFILE(profile_branch(pc, cond));
+
+            if (cond) {
                 JUMP_BACK(pack_halves<uint32_t>(pc->b, pc->c));
                 DISPATCH();
             }
@@ -1351,12 +1297,57 @@ template <bool SingleStep, bool OverridePC>
         }
         CASE(JMPBACKIFX)
         {
-            if (!GET_REGISTER(pc->a)->as_cbool()) {
+            bool cond = GET_REGISTER(pc->a)->as_cbool();
+            PROFILE(profile_branch(pc, cond));
+
+            if (!cond) {
                 JUMP_BACK(pack_halves<uint32_t>(pc->b, pc->c));
                 DISPATCH();
             }
             DISPATCH();
         }
+        CASE(FORPREP)
+        {
+            // L[a] = counter, L[a + 1] = limit, L[a + 2] = step
+            CSE_OPERANDS_A();
+            int64_t counter = GET_LOCAL(a)->m_data.integer;
+            int64_t limit = GET_LOCAL(a + 1)->m_data.integer;
+            int64_t step = GET_LOCAL(a + 2)->m_data.integer;
+
+            [[unlikely]] if (step == 0) {
+                vm->raise("'for' loop step is zero");
+                DISPATCH();
+            }
+
+            if (step > 0 ? counter >= limit : counter <= limit) {
+                JUMP_FWD(pack_halves<uint32_t>(pc->b, pc->c));
+            }
+            DISPATCH();
+        }
+        CASE(FORLOOP)
+        {
+            CSE_OPERANDS_A();
+            Value* counter = GET_LOCAL(a);
+            int64_t limit = GET_LOCAL(a + 1)->m_data.integer;
+            int64_t step = GET_LOCAL(a + 2)->m_data.integer;
+
+            // The counter is strictly inside the range, so the remaining distance
+            // is positive and fits in 64 bits unsigned. Comparing it against the
+            // step avoids overflowing the counter near the integer limits.
+            auto current = static_cast<uint64_t>(counter->m_data.integer);
+            auto bound = static_cast<uint64_t>(limit);
+            auto stride = static_cast<uint64_t>(step);
+
+            uint64_t remaining = step > 0 ? bound - current : current - bound;
+            if (step < 0)
+                stride = 0 - stride;
+
+            if (remaining > stride) {
+                counter->m_data.integer += step;
+                JUMP_BACK(pack_halves<uint32_t>(pc->b, pc->c));
+            }
+            DISPATCH();
+        }
         CASE(SAVE)
         {
             vm->save_stack();
@@ -1379,24 +1370,46 @@ template <bool SingleStep, bool OverridePC>
             vm->push_local(CONST_VALUE_REF(pc->a));
             DISPATCH();
         }
+        CASE(PUSHMOVE)
+        {
+            // Hands the register's reference over to the stack
+            vm->push_local(ValueRef(vm, GET_REGISTER(pc->a)));
+            SET_REGISTER(pc->a, nullptr);
+            DISPATCH();
+        }
         CASE(GETTOP)
         {
             auto* val = reinterpret_cast<Value*>(stack.top());
             val->m_rc++;
+            FREE_REGISTER(pc->a);
             SET_REGISTER(pc->a, val);
             DISPATCH();
         }
         CASE(GETARG)
+        {
+            CSE_OPERANDS_A();
+            Value::store_copy(vm, GET_REGISTER(a), GET_ARG(pc->b));
+            DISPATCH();
+        }
         CASE(GETARGREF)
         CASE(SETARG)
         {
             goto trap__unimplemented_opcode;
         }
-        CASE(GETLOCAL)
+        CASE(GETCALLEE)
         {
+            // Shared rather than copied, so calls through it are memoized too
             CSE_OPERANDS_A();
+            auto* callee = GET_CALLEE();
+            callee->m_rc++;
             FREE_REGISTER(a);
-            SET_REGISTER(a, GET_LOCAL(pc->b)->clone());
+            SET_REGISTER(a, callee);
+            DISPATCH();
+        }
+        CASE(GETLOCAL)
+        {
+            CSE_OPERANDS_A();
+            Value::store_copy(vm, GET_REGISTER(a), GET_LOCAL(pc->b));
             DISPATCH();
         }
         CASE(GETLOCALREF)
@@ -1411,8 +1424,10 @@ template <bool SingleStep, bool OverridePC>
         CASE(SETLOCAL)
         {
             CSE_OPERANDS_AB()
+            auto* val = GET_REGISTER(a);
+            val->m_rc++;
             FREE_LOCAL(b);
-            SET_LOCAL(b, GET_REGISTER(a));
+            SET_LOCAL(b, val);
             DISPATCH();
         }
         CASE(CALL)
@@ -1452,28 +1467,37 @@ template <bool SingleStep, bool OverridePC>
         }
         CASE(TOINT)
         {
-            SET_REGISTER(pc->a, GET_REGISTER(pc->b)->as_int());
+            auto* result = GET_REGISTER(pc->b)->as_int();
+            FREE_REGISTER(pc->a);
+            SET_REGISTER(pc->a, result);
             DISPATCH();
         }
         CASE(TOFLOAT)
         {
-            SET_REGISTER(pc->a, GET_REGISTER(pc->b)->as_float());
+            auto* result = GET_REGISTER(pc->b)->as_float();
+            FREE_REGISTER(pc->a);
+            SET_REGISTER(pc->a, result);
             DISPATCH();
         }
         CASE(TOBOOL)
         {
-            SET_REGISTER(pc->a, GET_REGISTER(pc->b)->as_bool());
+            auto* result = GET_REGISTER(pc->b)->as_bool();
+            FREE_REGISTER(pc->a);
+            SET_REGISTER(pc->a, result);
             DISPATCH();
         }
         CASE(TOSTRING)
         {
-            SET_REGISTER(pc->a, GET_REGISTER(pc->b)->as_string());
+            auto* result = GET_REGISTER(pc->b)->as_string();
+            FREE_REGISTER(pc->a);
+            SET_REGISTER(pc->a, result);
             DISPATCH();
         }
         CASE(GETIMPORT)
         {
             CSE_OPERANDS_A();
-            auto import = vm->get_import(pc->b, pc->c);
+            auto& exe = *vm->m_exe;
+            auto import = vm->get_import(exe.symbol(pc->b), exe.symbol(pc->c));
             import->m_rc++;
             FREE_REGISTER(a);
             SET_REGISTER(a, import.get());
@@ -1502,10 +1526,30 @@ exit:;
 
 void via::VirtualMachine::execute()
 {
-    detail::execute<false, false>(this);
+    if (m_profile != nullptr)
+        detail::execute<false, false, true>(this);
+    else
+        detail::execute<false, false, false>(this);
 }
 
 void via::VirtualMachine::execute_once()
 {
-    detail::execute<true, false>(this);
+    if (m_profile != nullptr)
+        detail::execute<true, false, true>(this);
+    else
+        detail::execute<true, false, false>(this);
+}
+
+// Executes at most `budget` instructions, returns whether the program halted
+bool via::VirtualMachine::execute_bounded(size_t budget)
+{
+    for (size_t steps = 0; steps < budget; steps++) {
+        if (m_pc->op == OpCode::HALT)
+            return true;
+        if (m_int == Interrupt::ERROR)
+            return false;
+
+        execute_once();
+    }
+    return m_pc->op == OpCode::HALT;
 }
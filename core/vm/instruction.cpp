@@ -14,150 +14,175 @@
 #include "support/bit.hpp"
 
 using OpCode = via::OpCode;
+using OpInfo = via::OpInfo;
+using enum OpInfo::Operand;
+using enum OpInfo::Access;
 
-enum Operand
-{
-    UNUSED,
-    LITERAL,
-    REGISTER,
-    CONSTANT,
-    HIGH,
-    LOW,
-    OFFSET_HIGH,
-    OFFSET_LOW,
-};
-
-struct OpInfo
-{
-    OpCode op;
-    Operand a = UNUSED, b = UNUSED, c = UNUSED;
-};
+static constexpr uint8_t TAKEN = READ | SHARE | FREE;
+static constexpr uint8_t SWAPPED = READ | WRITE | SHARE;
 
-static OpInfo OPERAND_INFO_MAP[] = {
+// Indexed by opcode, entries must follow the order of FOR_EACH_OPCODE
+static constexpr OpInfo OPERAND_INFO_MAP[] = {
     {OpCode::NOP},
-    {OpCode::HALT},
-    {OpCode::EXTRAARG, LITERAL, LITERAL, LITERAL},
-    {OpCode::MOVE, REGISTER, REGISTER},
-    {OpCode::FREE1, REGISTER},
-    {OpCode::FREE2, REGISTER, REGISTER},
-    {OpCode::FREE3, REGISTER, REGISTER, REGISTER},
-    {OpCode::XCHG, REGISTER, REGISTER},
-    {OpCode::COPY, REGISTER, REGISTER},
-    {OpCode::COPYREF, REGISTER, REGISTER},
-    {OpCode::LOADK, REGISTER, CONSTANT},
-    {OpCode::LOADNIL, REGISTER},
-    {OpCode::LOADTRUE, REGISTER},
-    {OpCode::LOADFALSE, REGISTER},
-    {OpCode::NEWSTR},
-    {OpCode::NEWARR},
-    {OpCode::NEWDICT},
-    {OpCode::NEWTUPLE},
-    {OpCode::NEWCLOSURE, REGISTER, OFFSET_HIGH, OFFSET_LOW},
-    {OpCode::IADD, REGISTER, REGISTER, REGISTER},
-    {OpCode::IADDK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::FADD, REGISTER, REGISTER, REGISTER},
-    {OpCode::FADDK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::ISUB, REGISTER, REGISTER, REGISTER},
-    {OpCode::ISUBK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::FSUB, REGISTER, REGISTER, REGISTER},
-    {OpCode::FSUBK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::IMUL, REGISTER, REGISTER, REGISTER},
-    {OpCode::IMULK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::FMUL, REGISTER, REGISTER, REGISTER},
-    {OpCode::FMULK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::IDIV, REGISTER, REGISTER, REGISTER},
-    {OpCode::IDIVK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::FDIV, REGISTER, REGISTER, REGISTER},
-    {OpCode::FDIVK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::IADD, REGISTER, REGISTER, REGISTER},
-    {OpCode::IADDK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::FADD, REGISTER, REGISTER, REGISTER},
-    {OpCode::FADDK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::INEG, REGISTER, REGISTER},
-    {OpCode::INEGK, REGISTER, CONSTANT},
-    {OpCode::FNEG, REGISTER, REGISTER},
-    {OpCode::FNEGK, REGISTER, CONSTANT},
-    {OpCode::BAND, REGISTER, REGISTER, REGISTER},
-    {OpCode::BANDK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::BOR, REGISTER, REGISTER, REGISTER},
-    {OpCode::BORK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::BXOR, REGISTER, REGISTER, REGISTER},
-    {OpCode::BXORK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::BSHL, REGISTER, REGISTER, REGISTER},
-    {OpCode::BSHLK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::BSHR, REGISTER, REGISTER, REGISTER},
-    {OpCode::BSHRK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::BNOT, REGISTER, REGISTER},
-    {OpCode::BNOTK, REGISTER, CONSTANT},
-    {OpCode::AND, REGISTER, REGISTER, REGISTER},
-    {OpCode::ANDK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::OR, REGISTER, REGISTER, REGISTER},
-    {OpCode::ORK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::IEQ, REGISTER, REGISTER, REGISTER},
-    {OpCode::IEQK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::FEQ, REGISTER, REGISTER, REGISTER},
-    {OpCode::FEQK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::BEQ, REGISTER, REGISTER, REGISTER},
-    {OpCode::BEQK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::SEQ, REGISTER, REGISTER, REGISTER},
-    {OpCode::SEQK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::INEQ, REGISTER, REGISTER, REGISTER},
-    {OpCode::INEQK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::FNEQ, REGISTER, REGISTER, REGISTER},
-    {OpCode::FNEQK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::BNEQ, REGISTER, REGISTER, REGISTER},
-    {OpCode::BNEQK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::SNEQ, REGISTER, REGISTER, REGISTER},
-    {OpCode::SNEQK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::IS, REGISTER, REGISTER, REGISTER},
-    {OpCode::ILT, REGISTER, REGISTER, REGISTER},
-    {OpCode::ILTK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::FLT, REGISTER, REGISTER, REGISTER},
-    {OpCode::FLTK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::IGT, REGISTER, REGISTER, REGISTER},
-    {OpCode::IGTK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::FGT, REGISTER, REGISTER, REGISTER},
-    {OpCode::FGTK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::ILTEQ, REGISTER, REGISTER, REGISTER},
-    {OpCode::ILTEQK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::FLTEQ, REGISTER, REGISTER, REGISTER},
-    {OpCode::FLTEQK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::IGTEQ, REGISTER, REGISTER, REGISTER},
-    {OpCode::IGTEQK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::FGTEQ, REGISTER, REGISTER, REGISTER},
-    {OpCode::FGTEQK, REGISTER, REGISTER, CONSTANT},
-    {OpCode::NOT, REGISTER, REGISTER},
-    {OpCode::JMP, OFFSET_HIGH, OFFSET_LOW},
-    {OpCode::JMPIF, REGISTER, OFFSET_HIGH, OFFSET_LOW},
-    {OpCode::JMPIFX, REGISTER, OFFSET_HIGH, OFFSET_LOW},
-    {OpCode::JMPBACK, OFFSET_HIGH, OFFSET_LOW},
-    {OpCode::JMPBACKIF, REGISTER, OFFSET_HIGH, OFFSET_LOW},
-    {OpCode::JMPBACKIFX, REGISTER, OFFSET_HIGH, OFFSET_LOW},
+    {OpCode::HALT, UNUSED, UNUSED, UNUSED, NONE, NONE, NONE, true},
+    {OpCode::EXTRAARG, LITERAL, LITERAL, LITERAL, NONE, NONE, NONE, true},
+    {OpCode::MOVE, REGISTER, REGISTER, UNUSED, WRITE, TAKEN},
+    {OpCode::FREE1, REGISTER, UNUSED, UNUSED, FREE},
+    {OpCode::FREE2, REGISTER, REGISTER, UNUSED, FREE, FREE},
+    {OpCode::FREE3, REGISTER, REGISTER, REGISTER, FREE, FREE, FREE},
+    {OpCode::XCHG, REGISTER, REGISTER, UNUSED, SWAPPED, SWAPPED},
+    {OpCode::COPY, REGISTER, REGISTER, UNUSED, WRITE, READ},
+    {OpCode::COPYREF, REGISTER, REGISTER, UNUSED, WRITE | SHARE, READ | SHARE},
+    {OpCode::SELECT, REGISTER, REGISTER, REGISTER, WRITE | SHARE, READ, TAKEN, true},
+    {OpCode::LOADK, REGISTER, CONSTANT, UNUSED, WRITE},
+    {OpCode::LOADNIL, REGISTER, UNUSED, UNUSED, WRITE},
+    {OpCode::LOADTRUE, REGISTER, UNUSED, UNUSED, WRITE},
+    {OpCode::LOADFALSE, REGISTER, UNUSED, UNUSED, WRITE},
+    {OpCode::LOADINT, REGISTER, HIGH, LOW, WRITE},
+    {OpCode::NEWSTR, UNUSED, UNUSED, UNUSED, NONE, NONE, NONE, true},
+    {OpCode::NEWARR, UNUSED, UNUSED, UNUSED, NONE, NONE, NONE, true},
+    {OpCode::NEWDICT, UNUSED, UNUSED, UNUSED, NONE, NONE, NONE, true},
+    {OpCode::NEWTUPLE, UNUSED, UNUSED, UNUSED, NONE, NONE, NONE, true},
+    {OpCode::NEWCLOSURE, REGISTER, OFFSET_HIGH, OFFSET_LOW, WRITE, NONE, NONE, true},
+    {OpCode::IADD, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::IADDK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::FADD, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::FADDK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::ISUB, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::ISUBK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::FSUB, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::FSUBK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::IMUL, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::IMULK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::FMUL, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::FMULK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::IDIV, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::IDIVK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::FDIV, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::FDIVK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::IPOW, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::IPOWK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::FPOW, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::FPOWK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::IMOD, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::IMODK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::FMOD, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::FMODK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::INEG, REGISTER, REGISTER, UNUSED, WRITE, READ},
+    {OpCode::INEGK, REGISTER, CONSTANT, UNUSED, WRITE},
+    {OpCode::FNEG, REGISTER, REGISTER, UNUSED, WRITE, READ},
+    {OpCode::FNEGK, REGISTER, CONSTANT, UNUSED, WRITE},
+    {OpCode::BAND, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::BANDK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::BOR, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::BORK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::BXOR, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::BXORK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::BSHL, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::BSHLK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::BSHR, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::BSHRK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::BNOT, REGISTER, REGISTER, UNUSED, WRITE, READ},
+    {OpCode::BNOTK, REGISTER, CONSTANT, UNUSED, WRITE},
+    {OpCode::AND, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::ANDK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::OR, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::ORK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::IEQ, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::IEQK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::FEQ, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::FEQK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::BEQ, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::BEQK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::SEQ, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::SEQK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::INEQ, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::INEQK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::FNEQ, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::FNEQK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::BNEQ, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::BNEQK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::SNEQ, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::SNEQK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::IS, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::ILT, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::ILTK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::FLT, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::FLTK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::IGT, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::IGTK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::FGT, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::FGTK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::ILTEQ, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::ILTEQK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::FLTEQ, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::FLTEQK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::IGTEQ, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::IGTEQK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::FGTEQ, REGISTER, REGISTER, REGISTER, WRITE, READ, READ},
+    {OpCode::FGTEQK, REGISTER, REGISTER, CONSTANT, WRITE, READ},
+    {OpCode::NOT, REGISTER, REGISTER, UNUSED, WRITE, READ},
+    {OpCode::JMP, OFFSET_HIGH, OFFSET_LOW, UNUSED, NONE, NONE, NONE, true},
+    {OpCode::JMPIF, REGISTER, OFFSET_HIGH, OFFSET_LOW, READ, NONE, NONE, true},
+    {OpCode::JMPIFX, REGISTER, OFFSET_HIGH, OFFSET_LOW, READ, NONE, NONE, true},
+    {OpCode::JMPBACK, OFFSET_HIGH, OFFSET_LOW, UNUSED, NONE, NONE, NONE, true},
+    {OpCode::JMPBACKIF, REGISTER, OFFSET_HIGH, OFFSET_LOW, READ, NONE, NONE, true},
+    {OpCode::JMPBACKIFX, REGISTER, OFFSET_HIGH, OFFSET_LOW, READ, NONE, NONE, true},
+    {OpCode::FORPREP, LITERAL, OFFSET_HIGH, OFFSET_LOW, NONE, NONE, NONE, true},
+    {OpCode::FORLOOP, LITERAL, OFFSET_HIGH, OFFSET_LOW, NONE, NONE, NONE, true},
     {OpCode::SAVE},
     {OpCode::RESTORE},
-    {OpCode::PUSH, REGISTER},
+    {OpCode::PUSH, REGISTER, UNUSED, UNUSED, READ | SHARE},
     {OpCode::PUSHK, CONSTANT},
-    {OpCode::GETTOP, REGISTER},
-    {OpCode::GETARG, REGISTER, LITERAL},
-    {OpCode::GETARGREF, REGISTER, LITERAL},
-    {OpCode::SETARG, REGISTER, LITERAL},
-    {OpCode::GETLOCAL, REGISTER, LITERAL},
-    {OpCode::GETLOCALREF, REGISTER, LITERAL},
-    {OpCode::SETLOCAL, REGISTER, LITERAL},
-    {OpCode::CALL, REGISTER},
-    {OpCode::PCALL, REGISTER},
-    {OpCode::RET, REGISTER},
-    {OpCode::RETNIL},
-    {OpCode::RETTRUE},
-    {OpCode::RETFALSE},
-    {OpCode::RETK, CONSTANT},
-    {OpCode::TOINT, REGISTER, REGISTER},
-    {OpCode::TOFLOAT, REGISTER, REGISTER},
-    {OpCode::TOBOOL, REGISTER, REGISTER},
-    {OpCode::TOSTRING, REGISTER, REGISTER},
-    {OpCode::GETIMPORT, REGISTER, LITERAL, LITERAL},
+    {OpCode::PUSHMOVE, REGISTER, UNUSED, UNUSED, TAKEN},
+    {OpCode::GETTOP, REGISTER, UNUSED, UNUSED, WRITE | SHARE},
+    {OpCode::GETARG, REGISTER, LITERAL, UNUSED, WRITE},
+    {OpCode::GETARGREF, REGISTER, LITERAL, UNUSED, NONE, NONE, NONE, true},
+    {OpCode::SETARG, REGISTER, LITERAL, UNUSED, NONE, NONE, NONE, true},
+    {OpCode::GETCALLEE, REGISTER, UNUSED, UNUSED, WRITE | SHARE},
+    {OpCode::GETLOCAL, REGISTER, LITERAL, UNUSED, WRITE},
+    {OpCode::GETLOCALREF, REGISTER, LITERAL, UNUSED, WRITE | SHARE},
+    {OpCode::SETLOCAL, REGISTER, LITERAL, UNUSED, READ | SHARE},
+    {OpCode::CALL, REGISTER, UNUSED, UNUSED, READ | SHARE, NONE, NONE, true},
+    {OpCode::PCALL, REGISTER, UNUSED, UNUSED, READ | SHARE, NONE, NONE, true},
+    {OpCode::RET, REGISTER, UNUSED, UNUSED, READ | SHARE, NONE, NONE, true},
+    {OpCode::RETNIL, UNUSED, UNUSED, UNUSED, NONE, NONE, NONE, true},
+    {OpCode::RETTRUE, UNUSED, UNUSED, UNUSED, NONE, NONE, NONE, true},
+    {OpCode::RETFALSE, UNUSED, UNUSED, UNUSED, NONE, NONE, NONE, true},
+    {OpCode::RETK, CONSTANT, UNUSED, UNUSED, NONE, NONE, NONE, true},
+    {OpCode::TOINT, REGISTER, REGISTER, UNUSED, WRITE, READ},
+    {OpCode::TOFLOAT, REGISTER, REGISTER, UNUSED, WRITE, READ},
+    {OpCode::TOBOOL, REGISTER, REGISTER, UNUSED, WRITE, READ},
+    {OpCode::TOSTRING, REGISTER, REGISTER, UNUSED, WRITE, READ},
+    {OpCode::GETIMPORT, REGISTER, LITERAL, LITERAL, WRITE | SHARE},
 };
 
+static constexpr bool is_complete() noexcept
+{
+#define COUNT_OPCODE(OP) +1
+    if (std::size(OPERAND_INFO_MAP) != 0 FOR_EACH_OPCODE(COUNT_OPCODE))
+        return false;
+#undef COUNT_OPCODE
+
+    for (size_t i = 0; i < std::size(OPERAND_INFO_MAP); i++) {
+        if (static_cast<size_t>(OPERAND_INFO_MAP[i].op) != i)
+            return false;
+    }
+    return true;
+}
+
+static_assert(is_complete(), "operand info map out of sync with opcodes");
+
+const OpInfo& via::op_info(OpCode op) noexcept
+{
+    return OPERAND_INFO_MAP[static_cast<uint16_t>(op)];
+}
+
+bool via::is_valid_opcode(uint16_t op) noexcept
+{
+    return op < std::size(OPERAND_INFO_MAP);
+}
+
 std::string via::Instruction::to_string(bool color, size_t pc) const
 {
     std::string opcode(via::to_string(op));
@@ -174,24 +199,8 @@ std::string via::Instruction::to_string(bool color, size_t pc) const
                   : opcode)
         << "  ";
 
-    OpInfo info;
-    bool found = false;
-
-    for (const auto& pair: OPERAND_INFO_MAP) {
-        if (pair.op == op) {
-            info = pair;
-            found = true;
-            break;
-        }
-    }
-
-    if (!found) {
-        oss << std::right << std::setw(3) << a << std::setw(3) << b << std::setw(3) << c;
-        oss << ansi::format(" <info error>", ansi::Foreground::RED);
-        return oss.str();
-    }
-
-    std::array<Operand, 3> operand_types = {info.a, info.b, info.c};
+    const OpInfo& info = op_info(op);
+    std::array<OpInfo::Operand, 3> operand_types = {info.a, info.b, info.c};
 
     for (int i = 0; i < 3; ++i) {
         auto type = operand_types[i];
@@ -210,7 +219,7 @@ std::string via::Instruction::to_string(bool color, size_t pc) const
         } else if (type == OFFSET_HIGH && i + 1 < 3 &&
                    operand_types[i + 1] == OFFSET_LOW) {
             int64_t sign = (op == OpCode::JMPBACK || op == OpCode::JMPBACKIF ||
-                            op == OpCode::JMPBACKIFX)
+                            op == OpCode::JMPBACKIFX || op == OpCode::FORLOOP)
                                ? -1
                                : 1;
             uint16_t hi = operands[i];
@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <via/config.hpp>
@@ -28,6 +29,7 @@ namespace via {
     X(XCHG)                                                                              \
     X(COPY)                                                                              \
     X(COPYREF)                                                                           \
+    X(SELECT)                                                                            \
     X(LOADK)                                                                             \
     X(LOADNIL)                                                                           \
     X(LOADTRUE)                                                                          \
@@ -54,6 +56,14 @@ namespace via {
     X(IDIVK)                                                                             \
     X(FDIV)                                                                              \
     X(FDIVK)                                                                             \
+    X(IPOW)                                                                              \
+    X(IPOWK)                                                                             \
+    X(FPOW)                                                                              \
+    X(FPOWK)                                                                             \
+    X(IMOD)                                                                              \
+    X(IMODK)                                                                             \
+    X(FMOD)                                                                              \
+    X(FMODK)                                                                             \
     X(INEG)                                                                              \
     X(INEGK)                                                                             \
     X(FNEG)                                                                              \
@@ -114,14 +124,18 @@ namespace via {
     X(JMPBACK)                                                                           \
     X(JMPBACKIF)                                                                         \
     X(JMPBACKIFX)                                                                        \
+    X(FORPREP)                                                                           \
+    X(FORLOOP)                                                                           \
     X(SAVE)                                                                              \
     X(RESTORE)                                                                           \
     X(PUSH)                                                                              \
     X(PUSHK)                                                                             \
+    X(PUSHMOVE)                                                                          \
     X(GETTOP)                                                                            \
     X(GETARG)                                                                            \
     X(GETARGREF)                                                                         \
     X(SETARG)                                                                            \
+    X(GETCALLEE)                                                                         \
     X(GETLOCAL)                                                                          \
     X(GETLOCALREF)                                                                       \
     X(SETLOCAL)                                                                          \
@@ -153,4 +167,45 @@ struct Instruction
 
 DEFINE_TO_STRING(OpCode, FOR_EACH_OPCODE(DEFINE_CASE_TO_STRING));
 
+// Operand layout of an opcode and what it does to the registers it names
+struct OpInfo
+{
+    enum Operand : uint8_t
+    {
+        UNUSED,
+        LITERAL,
+        REGISTER,
+        CONSTANT,
+        HIGH,
+        LOW,
+        OFFSET_HIGH,
+        OFFSET_LOW,
+    };
+
+    enum Access : uint8_t
+    {
+        NONE = 0,
+        READ = 1 << 0,  // The value held by the register is used
+        WRITE = 1 << 1, // The register is assigned
+        SHARE = 1 << 2, // The value object ends up referenced somewhere else
+        FREE = 1 << 3,  // The register is left empty
+    };
+
+    OpCode op;
+    Operand a = UNUSED, b = UNUSED, c = UNUSED;
+    uint8_t access_a = NONE, access_b = NONE, access_c = NONE;
+
+    // Transfers control or touches registers beyond its operands
+    bool barrier = false;
+
+    Operand operand(size_t i) const noexcept { return i == 0 ? a : i == 1 ? b : c; }
+    uint8_t access(size_t i) const noexcept
+    {
+        return i == 0 ? access_a : i == 1 ? access_b : access_c;
+    }
+};
+
+const OpInfo& op_info(OpCode op) noexcept;
+bool is_valid_opcode(uint16_t op) noexcept;
+
 } // namespace via
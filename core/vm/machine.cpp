@@ -15,6 +15,7 @@
 #include "module/defs.hpp"
 #include "module/manager.hpp"
 #include "module/module.hpp"
+#include "profile.hpp"
 #include "ref.hpp"
 #include "value.hpp"
 
@@ -102,9 +103,39 @@ via::Closure* via::VirtualMachine::unwind_stack(StackUnwindCallback pred)
             callee->unref();
         }
     }
+
+    m_fp = nullptr;
     return nullptr;
 }
 
+// Points the machine at the code of another module, whose locals start at the
+// current top of the stack
+void via::VirtualMachine::load(Module* module, const Executable* exe)
+{
+    debug::require(!exe->bytecode().empty(), "illformed header");
+
+    m_exe = exe;
+    m_module = module;
+    m_bp = exe->bytecode().data();
+    m_pc = m_bp;
+    m_fp = nullptr;
+    m_stack.rebase(m_stack.end());
+}
+
+// Pops what the loaded module left on the stack, releasing the values it refers
+// to. Frames are still open if it stopped in a call, e.g. from the debugger.
+void via::VirtualMachine::unload()
+{
+    unwind_stack([](auto, auto, auto, auto) { return false; });
+
+    auto* base = m_stack.local_base();
+    for (auto* ptr = m_stack.end(); ptr-- > base;) {
+        if (*ptr != 0)
+            reinterpret_cast<Value*>(*ptr)->unref();
+    }
+    m_stack.jump(base);
+}
+
 via::ValueRef via::VirtualMachine::get_import(SymbolId module_id, SymbolId key_id)
 {
     auto& manager = m_module->manager();
@@ -147,34 +178,121 @@ void via::VirtualMachine::push_local(ValueRef val)
 via::ValueRef via::VirtualMachine::get_local(size_t sp)
 {
     // Ensure the stack pointer is within bounds
-    debug::require(sp < m_stack.size(), "invalid stack pointer");
+    debug::require(&m_stack.at(sp) < m_stack.end(), "invalid stack pointer");
     return ValueRef(this, (Value*) m_stack.at(sp));
 }
 
 via::ValueRef via::VirtualMachine::get_constant(uint16_t id)
 {
-    auto cv = m_exe->constants().at(id); // Get the constant value
-    auto* val = Value::create(this, cv); // Create a new value from the constant
+    auto* val = Value::create(this, m_exe->constants(), id);
     return ValueRef(this, val);
 }
 
+// Closures imported from other modules run bytecode that is not part of this
+// executable, and has no index in it
+static std::optional<size_t>
+index_of(const via::Executable* exe, const via::Instruction* pc) noexcept
+{
+    auto begin = reinterpret_cast<uintptr_t>(exe->bytecode().data());
+    auto addr = reinterpret_cast<uintptr_t>(pc);
+    if (addr < begin)
+        return std::nullopt;
+
+    size_t index = (addr - begin) / sizeof(via::Instruction);
+    if (index >= exe->bytecode().size())
+        return std::nullopt;
+
+    return index;
+}
+
+static std::optional<via::ProfileSite>
+site_of(const via::Executable* exe, const via::Instruction* pc) noexcept
+{
+    auto index = index_of(exe, pc);
+    return index ? exe->site_of(*index) : std::nullopt;
+}
+
+void via::VirtualMachine::profile_branch(const Instruction* pc, bool truthy) noexcept
+{
+    if (auto site = site_of(m_exe, pc))
+        m_profile->record_branch(*site, truthy);
+}
+
+void via::VirtualMachine::profile_call(const Closure* closure) noexcept
+{
+    if (closure->is_native())
+        return;
+
+    if (auto site = site_of(m_exe, closure->get_bytecode()))
+        m_profile->record_call(*site);
+}
+
+// Arguments are only keyed while they are all scalars, anything else is
+// compared by identity and could not be recognized on a later call
+std::optional<via::MemoKey> via::VirtualMachine::memo_key(
+    const Closure* closure,
+    const uintptr_t* args
+) const noexcept
+{
+    auto index = index_of(m_exe, closure->get_bytecode());
+    auto arity = index ? m_exe->memo_arity(*index) : std::nullopt;
+    if (!arity.has_value())
+        return std::nullopt;
+
+    MemoKey key{closure->get_bytecode(), {}};
+    for (size_t i = 0; i < *arity; i++) {
+        auto arg = MemoScalar::from(reinterpret_cast<const Value*>(*(args - i)));
+        if (!arg.has_value())
+            return std::nullopt;
+        key.args.push_back(*arg);
+    }
+    return key;
+}
+
+void via::VirtualMachine::memoize_result(const uintptr_t* fp, const Value* value)
+{
+    // Calls unwound by an error never return, and leave their keys behind
+    while (!m_memo_calls.empty() && m_memo_calls.back().fp > fp)
+        m_memo_calls.pop_back();
+    if (m_memo_calls.empty() || m_memo_calls.back().fp != fp)
+        return;
+
+    auto key = std::move(m_memo_calls.back().key);
+    m_memo_calls.pop_back();
+
+    if (auto result = MemoScalar::from(value))
+        m_memo.insert(std::move(key), *result);
+}
+
 void via::VirtualMachine::call(ValueRef callee, CallFlags flags)
 {
     callee->m_rc++; // Keep callee alive just in case
 
     // Get the closure from the callee value
     auto* closure = callee->function_value();
+    [[unlikely]] if (m_profile != nullptr)
+        profile_call(closure);
     auto* base = &m_stack.top();
 
-    m_stack.push((uintptr_t) callee.get());                 // Save callee pointer
-    m_stack.push((uintptr_t) flags);                        // Save flags
-    m_stack.push((uintptr_t) m_pc + !closure->is_native()); // Save return PC
-    m_stack.push((uintptr_t) m_fp);                         // Save old FP
+    // Memoized functions return a result recorded for the same arguments
+    // without running, the same way native functions return
+    auto key = closure->is_native() ? std::nullopt : memo_key(closure, base);
+    auto memo = key ? m_memo.find(*key) : std::nullopt;
+    bool runs_bytecode = !closure->is_native() && !memo.has_value();
+    if (key.has_value() && runs_bytecode)
+        flags |= CallFlags::MEMOIZE;
+
+    m_stack.push((uintptr_t) callee.get());         // Save callee pointer
+    m_stack.push((uintptr_t) flags);                // Save flags
+    m_stack.push((uintptr_t) m_pc + runs_bytecode); // Save return PC
+    m_stack.push((uintptr_t) m_fp);                 // Save old FP
 
     // Set the new frame pointer
     m_fp = &m_stack.top();
 
-    if (closure->is_native()) {
+    if (memo.has_value()) {
+        return_(ValueRef(this, memo->to_value(this)));
+    } else if (closure->is_native()) {
         CallInfo call_info; // Initialize the CallInfo structure
         call_info.callee = callee.get();
         call_info.flags = flags; // Propagate flags
@@ -187,6 +305,8 @@ void via::VirtualMachine::call(ValueRef callee, CallFlags flags)
         auto result = closure->get_callback()(this, call_info);
         return_(result); // Return the result of the native function call
     } else {
+        if (key.has_value())
+            m_memo_calls.push_back({m_fp, std::move(*key)});
         m_pc = closure->get_bytecode();
     }
 }
@@ -209,6 +329,8 @@ void via::VirtualMachine::return_(ValueRef value)
         }
     }
 
+    const uintptr_t* frame = m_fp;
+
     // Jump stack to frame pointer
     m_stack.jump(m_fp + 1);
 
@@ -219,6 +341,9 @@ void via::VirtualMachine::return_(ValueRef value)
     auto* callee = reinterpret_cast<Value*>(m_stack.pop()); // Callee
     callee->unref();                                        // Unreference the callee
 
+    if (flags & CallFlags::MEMOIZE)
+        memoize_result(frame, value.get());
+
     // Push return value
     push_local(value.is_null() ? ValueRef(this, Value::create(this)) : value);
 }
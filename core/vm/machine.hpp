@@ -12,12 +12,15 @@
 #include <cstddef>
 #include <functional>
 #include <iostream>
+#include <optional>
 #include <ostream>
 #include <string>
+#include <vector>
 #include <via/config.hpp>
 #include "debug.hpp"
 #include "executable.hpp"
 #include "instruction.hpp"
+#include "memo.hpp"
 #include "module/symbol.hpp"
 #include "stack.hpp"
 #include "support/utility.hpp"
@@ -55,6 +58,7 @@ enum class CallFlags : uint8_t
 {
     NONE = 0,
     PROTECT = 1 << 0,
+    MEMOIZE = 1 << 1, // Result is recorded in the memo table on return
     ALL = 0xFF,
 };
 
@@ -70,7 +74,7 @@ using StackUnwindCallback = std::function<bool(
 
 namespace detail {
 
-template <bool SingleStep, bool OverridePC>
+template <bool SingleStep, bool OverridePC, bool Profiling>
 void execute(VirtualMachine* vm);
 
 template <Interrupt Int>
@@ -106,10 +110,11 @@ struct ErrorInt
 
 class ValueRef;
 class ModuleManager;
+class Profile;
 class VirtualMachine final
 {
   public:
-    template <bool, bool>
+    template <bool, bool, bool>
     friend void detail::execute(VirtualMachine*);
 
     template <Interrupt>
@@ -132,11 +137,15 @@ class VirtualMachine final
     }
 
   public:
+    void load(Module* module, const Executable* exe);
+    void unload();
+
     Stack<uintptr_t>& get_stack() { return m_stack; }
     ScopedAllocator& allocator() { return m_alloc; }
     ValueRef get_import(SymbolId module_id, SymbolId key_id);
     ValueRef get_constant(uint16_t id);
     void set_interrupt_hook(InterruptHook hook) { m_int_hook = hook; }
+    void set_profile(Profile* profile) { m_profile = profile; }
     void set_interrupt(Interrupt code, void* arg = nullptr) noexcept;
     void push_local(ValueRef val);
     ValueRef get_local(size_t sp);
@@ -145,6 +154,7 @@ class VirtualMachine final
     void raise(std::string msg, std::ostream& out = std::cerr);
     void execute();
     void execute_once();
+    bool execute_bounded(size_t budget);
 
   protected:
     void save_stack();
@@ -153,6 +163,14 @@ class VirtualMachine final
     bool has_interrupt() const { return m_int != Interrupt::NONE; }
     IntAction handle_interrupt();
 
+    // Profiling hooks, only invoked while a profile is attached
+    void profile_branch(const Instruction* pc, bool truthy) noexcept;
+    void profile_call(const Closure* closure) noexcept;
+
+    std::optional<MemoKey>
+    memo_key(const Closure* closure, const uintptr_t* args) const noexcept;
+    void memoize_result(const uintptr_t* fp, const Value* value);
+
   protected:
     const Executable* m_exe;
     ScopedAllocator m_alloc;
@@ -164,6 +182,17 @@ class VirtualMachine final
     Interrupt m_int = Interrupt::NONE;
     InterruptHook m_int_hook = nullptr;
     void* m_int_arg;
+    Profile* m_profile = nullptr;
+    MemoTable m_memo;
+
+    // Memoized calls that have not returned yet, innermost last
+    struct MemoCall
+    {
+        const uintptr_t* fp;
+        MemoKey key;
+    };
+
+    std::vector<MemoCall> m_memo_calls;
     Stack<uintptr_t> m_stack;
     std::unique_ptr<Value*[]> m_registers;
 };
@@ -0,0 +1,85 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "memo.hpp"
+#include <bit>
+#include "support/math.hpp"
+#include "value.hpp"
+
+std::optional<via::MemoScalar> via::MemoScalar::from(const Value* value) noexcept
+{
+    if (value == nullptr)
+        return std::nullopt;
+
+    switch (value->kind()) {
+    case ValueKind::NIL:
+        return MemoScalar{ValueKind::NIL, 0};
+    case ValueKind::BOOL:
+        return MemoScalar{ValueKind::BOOL, value->bool_value() ? 1u : 0u};
+    case ValueKind::INT:
+        return MemoScalar{ValueKind::INT, std::bit_cast<uint64_t>(value->int_value())};
+    case ValueKind::FLOAT: {
+        auto bits = std::bit_cast<uint64_t>(value->float_value());
+        return MemoScalar{ValueKind::FLOAT, bits};
+    }
+    default:
+        return std::nullopt;
+    }
+}
+
+via::Value* via::MemoScalar::to_value(VirtualMachine* vm) const
+{
+    switch (kind) {
+    case ValueKind::BOOL:
+        return Value::create(vm, bits != 0);
+    case ValueKind::INT:
+        return Value::create(vm, std::bit_cast<int64_t>(bits));
+    case ValueKind::FLOAT:
+        return Value::create(vm, std::bit_cast<float64>(bits));
+    default:
+        return Value::create(vm);
+    }
+}
+
+size_t via::MemoKeyHash::operator()(const MemoKey& key) const noexcept
+{
+    return hash_all(
+        hash_ptr(key.function),
+        hash_range(key.args.begin(), key.args.end(), [](const MemoScalar& arg) {
+            return hash_all(static_cast<size_t>(arg.kind), static_cast<size_t>(arg.bits));
+        })
+    );
+}
+
+std::optional<via::MemoScalar> via::MemoTable::find(const MemoKey& key) noexcept
+{
+    auto it = m_index.find(key);
+    if (it == m_index.end())
+        return std::nullopt;
+
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return it->second->second;
+}
+
+void via::MemoTable::insert(MemoKey key, MemoScalar result)
+{
+    if (auto it = m_index.find(key); it != m_index.end()) {
+        it->second->second = result;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return;
+    }
+
+    if (m_index.size() >= m_capacity) {
+        m_index.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+
+    m_entries.emplace_front(std::move(key), result);
+    m_index.emplace(m_entries.front().first, m_entries.begin());
+}
@@ -0,0 +1,84 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <via/config.hpp>
+#include "instruction.hpp"
+#include "sema/const.hpp"
+
+namespace via {
+namespace config {
+
+// Maximum number of results a virtual machine remembers across all memoized
+// functions. The least recently used result is dropped to make room.
+VIA_CONSTANT size_t MEMO_CAPACITY = 4096;
+
+// Maximum number of parameters of a memoized function
+VIA_CONSTANT size_t MEMO_MAX_ARGS = 8;
+
+} // namespace config
+
+class Value;
+class VirtualMachine;
+
+// Scalar value with its payload widened to 64 bits, so that equal values have
+// equal bits
+struct MemoScalar
+{
+    ValueKind kind;
+    uint64_t bits;
+
+    bool operator==(const MemoScalar&) const noexcept = default;
+
+    static std::optional<MemoScalar> from(const Value* value) noexcept;
+    Value* to_value(VirtualMachine* vm) const;
+};
+
+struct MemoKey
+{
+    const Instruction* function; // Bytecode of the closure called
+    std::vector<MemoScalar> args;
+
+    bool operator==(const MemoKey&) const noexcept = default;
+};
+
+struct MemoKeyHash
+{
+    size_t operator()(const MemoKey& key) const noexcept;
+};
+
+class MemoTable final
+{
+  public:
+    explicit MemoTable(size_t capacity = config::MEMO_CAPACITY)
+        : m_capacity(capacity)
+    {}
+
+  public:
+    // Returns the result recorded for `key` and marks it as recently used
+    std::optional<MemoScalar> find(const MemoKey& key) noexcept;
+    void insert(MemoKey key, MemoScalar result);
+    size_t size() const noexcept { return m_index.size(); }
+
+  private:
+    using Entry = std::pair<MemoKey, MemoScalar>;
+
+    size_t m_capacity;
+    std::list<Entry> m_entries; // Most recently used first
+    std::unordered_map<MemoKey, std::list<Entry>::iterator, MemoKeyHash> m_index;
+};
+
+} // namespace via
@@ -0,0 +1,398 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "peephole.hpp"
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include "executable.hpp"
+#include "support/bit.hpp"
+
+using via::OpCode;
+using via::OpInfo;
+
+// Jumps come in a forward and a backward form, the offset being unsigned
+static constexpr std::pair<OpCode, OpCode> JUMP_FORMS[] = {
+    {OpCode::JMP, OpCode::JMPBACK},
+    {OpCode::JMPIF, OpCode::JMPBACKIF},
+    {OpCode::JMPIFX, OpCode::JMPBACKIFX},
+};
+
+struct Fold
+{
+    OpCode op;
+    OpCode rhs; // Form reading the right operand from a constant
+    OpCode lhs; // Form giving the same result with the constant on the left, or NOP
+};
+
+// Integer opcodes that have a form reading one operand from the constant pool
+static constexpr Fold FOLDS[] = {
+    {OpCode::IADD, OpCode::IADDK, OpCode::IADDK},
+    {OpCode::ISUB, OpCode::ISUBK, OpCode::NOP},
+    {OpCode::IMUL, OpCode::IMULK, OpCode::IMULK},
+    {OpCode::IDIV, OpCode::IDIVK, OpCode::NOP},
+    {OpCode::IPOW, OpCode::IPOWK, OpCode::NOP},
+    {OpCode::IMOD, OpCode::IMODK, OpCode::NOP},
+    {OpCode::BAND, OpCode::BANDK, OpCode::BANDK},
+    {OpCode::BOR, OpCode::BORK, OpCode::BORK},
+    {OpCode::BXOR, OpCode::BXORK, OpCode::BXORK},
+    {OpCode::BSHL, OpCode::BSHLK, OpCode::NOP},
+    {OpCode::BSHR, OpCode::BSHRK, OpCode::NOP},
+    {OpCode::IEQ, OpCode::IEQK, OpCode::IEQK},
+    {OpCode::INEQ, OpCode::INEQK, OpCode::INEQK},
+    {OpCode::ILT, OpCode::ILTK, OpCode::IGTK},
+    {OpCode::IGT, OpCode::IGTK, OpCode::ILTK},
+    {OpCode::ILTEQ, OpCode::ILTEQK, OpCode::IGTEQK},
+    {OpCode::IGTEQ, OpCode::IGTEQK, OpCode::ILTEQK},
+};
+
+static bool is_unconditional(OpCode op) noexcept
+{
+    return op == OpCode::JMP || op == OpCode::JMPBACK;
+}
+
+static bool is_backward(OpCode op) noexcept
+{
+    if (op == OpCode::FORLOOP)
+        return true;
+    for (const auto& [forward, backward]: JUMP_FORMS) {
+        if (op == backward)
+            return true;
+    }
+    return false;
+}
+
+// Index of the operand holding the high half of the jump offset, if any
+static std::optional<size_t> offset_operand(const OpInfo& info) noexcept
+{
+    for (size_t i = 0; i < 2; i++) {
+        if (info.operand(i) == OpInfo::OFFSET_HIGH)
+            return i;
+    }
+    return std::nullopt;
+}
+
+static std::array<uint16_t*, 3> operands_of(via::Instruction& insn) noexcept
+{
+    return {&insn.a, &insn.b, &insn.c};
+}
+
+static void encode_jump(via::Instruction& insn, size_t pc, size_t target) noexcept
+{
+    for (const auto& [forward, backward]: JUMP_FORMS) {
+        if (insn.op == forward || insn.op == backward) {
+            insn.op = target > pc ? forward : backward;
+            break;
+        }
+    }
+
+    auto ops = operands_of(insn);
+    size_t slot = *offset_operand(via::op_info(insn.op));
+    uint32_t offset = is_backward(insn.op) ? pc - target : target - pc;
+    via::unpack_halves(offset, *ops[slot], *ops[slot + 1]);
+}
+
+size_t via::Peephole::run() noexcept
+{
+    for (size_t id = 0; const ConstValue& cv: m_exe.m_constants) {
+        if (cv.kind() == ValueKind::INT)
+            m_int_constants.emplace(cv.value<ValueKind::INT>(), id);
+        id++;
+    }
+
+    // Removing instructions can line up new sequences, so rounds are repeated
+    // over the compacted code until one removes nothing
+    size_t removed = 0;
+    while (size_t count = run_once())
+        removed += count;
+
+    return removed;
+}
+
+size_t via::Peephole::run_once() noexcept
+{
+    auto& code = m_exe.m_bytecode;
+    m_removed.assign(code.size(), false);
+
+    decode_jumps();
+    thread_jumps();
+
+    m_targets.assign(code.size() + 1, false);
+    for (size_t pc = 0; pc < code.size(); pc++) {
+        if (m_removed[pc])
+            continue;
+        if (m_jumps[pc].has_value())
+            m_targets[*m_jumps[pc]] = true;
+
+        // Closure bodies are entered from their call sites
+        if (code[pc].op == OpCode::NEWCLOSURE)
+            m_targets[pc + 1] = true;
+    }
+
+    // A pair may start at a jump target but not continue into one, as the
+    // second instruction would then also run without the first
+    for (size_t pc = 0; pc + 1 < code.size(); pc++) {
+        if (m_removed[pc] || m_removed[pc + 1] || m_targets[pc + 1])
+            continue;
+        if (push_move(pc) || fold_constant(pc) || forward_result(pc))
+            pc++;
+    }
+
+    size_t removed = std::count(m_removed.begin(), m_removed.end(), true);
+    compact();
+    return removed;
+}
+
+void via::Peephole::decode_jumps() noexcept
+{
+    auto& code = m_exe.m_bytecode;
+    m_jumps.assign(code.size(), std::nullopt);
+
+    for (size_t pc = 0; pc < code.size(); pc++) {
+        auto slot = offset_operand(op_info(code[pc].op));
+        if (!slot.has_value())
+            continue;
+
+        auto ops = operands_of(code[pc]);
+        uint32_t offset = pack_halves<uint32_t>(*ops[*slot], *ops[*slot + 1]);
+        m_jumps[pc] = is_backward(code[pc].op) ? pc - offset : pc + offset;
+    }
+}
+
+// Jumps landing on an unconditional jump go straight to where it leads, and
+// unconditional jumps to the next instruction are dropped
+void via::Peephole::thread_jumps() noexcept
+{
+    auto& code = m_exe.m_bytecode;
+
+    for (size_t pc = 0; pc < code.size(); pc++) {
+        bool threadable = std::any_of(
+            std::begin(JUMP_FORMS),
+            std::end(JUMP_FORMS),
+            [&](const auto& forms) {
+                return code[pc].op == forms.first || code[pc].op == forms.second;
+            }
+        );
+
+        if (!threadable)
+            continue;
+
+        // Bounded so a cycle of jumps is left as is
+        size_t target = *m_jumps[pc];
+        for (size_t hops = 0; hops < code.size() && target < code.size() &&
+                              target != pc && is_unconditional(code[target].op);
+             hops++)
+            target = *m_jumps[target];
+
+        m_jumps[pc] = target;
+        if (is_unconditional(code[pc].op) && target == pc + 1)
+            m_removed[pc] = true;
+    }
+}
+
+// Whether the value held by `reg` is never read once the instruction at `pc`
+// has run. Only straight line code is followed, anything that leaves it or
+// may be entered from elsewhere counts as a read.
+bool via::Peephole::is_dead_after(size_t pc, uint16_t reg) const noexcept
+{
+    auto& code = m_exe.m_bytecode;
+
+    for (size_t i = pc + 1; i < code.size(); i++) {
+        if (m_removed[i])
+            continue;
+
+        const OpInfo& info = op_info(code[i].op);
+        if (m_targets[i] || info.barrier)
+            return false;
+
+        bool killed = false;
+        std::array<uint16_t, 3> ops{code[i].a, code[i].b, code[i].c};
+
+        for (size_t k = 0; k < 3; k++) {
+            if (info.operand(k) != OpInfo::REGISTER || ops[k] != reg)
+                continue;
+            if (info.access(k) & OpInfo::READ)
+                return false;
+            if (info.access(k) & (OpInfo::WRITE | OpInfo::FREE))
+                killed = true;
+        }
+
+        if (killed)
+            return true;
+    }
+
+    return false;
+}
+
+// PUSH r; FREE1 r -> PUSHMOVE r
+bool via::Peephole::push_move(size_t pc) noexcept
+{
+    auto& code = m_exe.m_bytecode;
+    Instruction& push = code[pc];
+    const Instruction& free = code[pc + 1];
+
+    if (push.op != OpCode::PUSH || free.op != OpCode::FREE1 || push.a != free.a)
+        return false;
+
+    push.op = OpCode::PUSHMOVE;
+    m_removed[pc + 1] = true;
+    return true;
+}
+
+// LOADINT r, k; IADD d, x, r -> IADDK d, x, K[k]
+bool via::Peephole::fold_constant(size_t pc) noexcept
+{
+    auto& code = m_exe.m_bytecode;
+    const Instruction& load = code[pc];
+    Instruction& use = code[pc + 1];
+
+    if (load.op != OpCode::LOADINT)
+        return false;
+
+    auto* fold = std::find_if(std::begin(FOLDS), std::end(FOLDS), [&](const Fold& f) {
+        return f.op == use.op;
+    });
+
+    if (fold == std::end(FOLDS))
+        return false;
+
+    OpCode op;
+    uint16_t reg = load.a, other;
+
+    if (use.c == reg && use.b != reg) {
+        op = fold->rhs;
+        other = use.b;
+    } else if (use.b == reg && use.c != reg && fold->lhs != OpCode::NOP) {
+        op = fold->lhs;
+        other = use.c;
+    } else {
+        return false;
+    }
+
+    // The register keeps what it held before the load, which only matters if
+    // something reads it later
+    if (use.a != reg && !is_dead_after(pc + 1, reg))
+        return false;
+
+    auto value = static_cast<int32_t>(pack_halves<uint32_t>(load.b, load.c));
+    auto id = int_constant(value);
+    if (!id.has_value())
+        return false;
+
+    use = Instruction{op, use.a, other, *id};
+    m_removed[pc] = true;
+    return true;
+}
+
+// OP r, ...; MOVE d, r -> OP d, ...
+bool via::Peephole::forward_result(size_t pc) noexcept
+{
+    auto& code = m_exe.m_bytecode;
+    Instruction& def = code[pc];
+    const Instruction& copy = code[pc + 1];
+
+    if (copy.op != OpCode::MOVE && copy.op != OpCode::COPY)
+        return false;
+
+    const OpInfo& info = op_info(def.op);
+    uint16_t reg = def.a, dst = copy.a;
+
+    if (info.barrier || info.a != OpInfo::REGISTER || copy.b != reg || dst == reg ||
+        (info.access_a & ~OpInfo::SHARE) != OpInfo::WRITE)
+        return false;
+
+    // Some opcodes release their destination before reading their operands
+    auto ops = operands_of(def);
+    for (size_t k = 1; k < 3; k++) {
+        if (info.operand(k) != OpInfo::REGISTER)
+            continue;
+        if ((info.access(k) & OpInfo::WRITE) || *ops[k] == dst)
+            return false;
+    }
+
+    // A copy leaves the source in place and must not end up sharing it
+    if (copy.op == OpCode::COPY &&
+        ((info.access_a & OpInfo::SHARE) || !is_dead_after(pc + 1, reg)))
+        return false;
+
+    def.a = dst;
+    m_removed[pc + 1] = true;
+    return true;
+}
+
+std::optional<uint16_t> via::Peephole::int_constant(int64_t value) noexcept
+{
+    if (auto it = m_int_constants.find(value); it != m_int_constants.end())
+        return static_cast<uint16_t>(it->second);
+
+    if (m_exe.m_constants.size() >= (size_t) std::numeric_limits<uint16_t>::max())
+        return std::nullopt;
+
+    m_exe.push_constant(ConstValue(value));
+    m_int_constants.emplace(value, m_exe.constant_id());
+    return static_cast<uint16_t>(m_exe.constant_id());
+}
+
+// Drops removed instructions and re-encodes every jump against the new
+// layout. A jump to a removed instruction lands on the next one kept.
+void via::Peephole::compact() noexcept
+{
+    auto& code = m_exe.m_bytecode;
+
+    std::vector<size_t> remap(code.size() + 1);
+    size_t kept = 0;
+
+    for (size_t pc = 0; pc < code.size(); pc++) {
+        remap[pc] = kept;
+        if (!m_removed[pc])
+            kept++;
+    }
+
+    remap[code.size()] = kept;
+
+    std::vector<Instruction> compacted;
+    compacted.reserve(kept);
+
+    for (size_t pc = 0; pc < code.size(); pc++) {
+        if (m_removed[pc])
+            continue;
+
+        Instruction insn = code[pc];
+        if (m_jumps[pc].has_value())
+            encode_jump(insn, remap[pc], remap[*m_jumps[pc]]);
+        compacted.push_back(insn);
+    }
+
+    code = std::move(compacted);
+
+    auto remap_table = [&](auto& table) {
+        std::remove_reference_t<decltype(table)> remapped;
+        for (const auto& [pc, value]: table) {
+            if (!m_removed[pc])
+                remapped.emplace(remap[pc], value);
+        }
+        table = std::move(remapped);
+    };
+
+    remap_table(m_exe.m_sites);
+    remap_table(m_exe.m_memoized);
+
+    // The line of a removed instruction carries over to the next one kept,
+    // unless a later statement starts there
+    std::vector<std::pair<size_t, size_t>> lines;
+    for (const auto& [pc, line]: m_exe.m_lines) {
+        if (!lines.empty() && lines.back().first == remap[pc])
+            lines.back().second = line;
+        else
+            lines.emplace_back(remap[pc], line);
+    }
+    m_exe.m_lines = std::move(lines);
+}
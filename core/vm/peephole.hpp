@@ -0,0 +1,61 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <via/config.hpp>
+#include "instruction.hpp"
+
+namespace via {
+
+class Executable;
+class Peephole final
+{
+  public:
+    Peephole(Executable& exe)
+        : m_exe(exe)
+    {}
+
+  public:
+    // Rewrites short instruction sequences left behind by lowering into
+    // cheaper equivalents and threads jumps through unconditional jumps. Jump
+    // offsets must already be resolved, they are fixed up after instructions
+    // are removed. Returns the number of instructions removed.
+    size_t run() noexcept;
+
+  private:
+    size_t run_once() noexcept;
+    void decode_jumps() noexcept;
+    void thread_jumps() noexcept;
+    bool is_dead_after(size_t pc, uint16_t reg) const noexcept;
+    bool push_move(size_t pc) noexcept;
+    bool fold_constant(size_t pc) noexcept;
+    bool forward_result(size_t pc) noexcept;
+    std::optional<uint16_t> int_constant(int64_t value) noexcept;
+    void compact() noexcept;
+
+  private:
+    Executable& m_exe;
+
+    // Absolute target of each instruction that branches, and whether an
+    // instruction may be entered other than from the one before it
+    std::vector<std::optional<size_t>> m_jumps;
+    std::vector<bool> m_targets;
+    std::vector<bool> m_removed;
+
+    // Integer constants already in the pool, mapped to their id
+    std::unordered_map<int64_t, size_t> m_int_constants;
+};
+
+} // namespace via
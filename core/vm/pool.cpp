@@ -0,0 +1,108 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "pool.hpp"
+#include <cstring>
+#include <format>
+#include <limits>
+
+void via::ConstantPool::pack(
+    const std::vector<ConstValue>& constants,
+    std::vector<PoolConstant>& entries,
+    std::string& strings
+)
+{
+    entries.clear();
+    strings.clear();
+
+    for (const ConstValue& cv: constants) {
+        PoolConstant entry;
+        entry.kind = cv.kind();
+        entry.offset = 0;
+
+        switch (cv.kind()) {
+        case ValueKind::NIL:
+            break;
+        case ValueKind::INT:
+            entry.integer = cv.value<ValueKind::INT>();
+            break;
+        case ValueKind::FLOAT:
+            entry.float_ = cv.value<ValueKind::FLOAT>();
+            break;
+        case ValueKind::BOOL:
+            entry.boolean = cv.value<ValueKind::BOOL>();
+            break;
+        case ValueKind::STRING: {
+            auto string = cv.value<ValueKind::STRING>();
+            debug::require(
+                string.size() < std::numeric_limits<uint32_t>::max(),
+                "string constant exceeds size limit"
+            );
+
+            entry.offset = strings.size();
+            entry.size = static_cast<uint32_t>(string.size());
+            strings.append(string);
+            strings.push_back('\0');
+            break;
+        }
+        default:
+            debug::unimplemented(std::format("pack({})", to_string(cv.kind())));
+        }
+
+        entries.push_back(entry);
+    }
+}
+
+via::ConstValue via::ConstantPool::value(size_t id) const
+{
+    const PoolConstant& entry = at(id);
+
+    switch (entry.kind) {
+    case ValueKind::INT:
+        return ConstValue(entry.integer);
+    case ValueKind::FLOAT:
+        return ConstValue(entry.float_);
+    case ValueKind::BOOL:
+        return ConstValue(entry.boolean);
+    case ValueKind::STRING:
+        return ConstValue(std::string(string(id), entry.size));
+    default:
+        return ConstValue();
+    }
+}
+
+bool via::ConstantPool::is_valid() const noexcept
+{
+    for (const PoolConstant& entry: m_entries) {
+        switch (entry.kind) {
+        case ValueKind::NIL:
+        case ValueKind::INT:
+        case ValueKind::FLOAT:
+            break;
+        case ValueKind::BOOL: {
+            // Any other byte is not a bool the VM could have produced
+            uint8_t byte;
+            std::memcpy(&byte, &entry.boolean, 1);
+            if (byte > 1)
+                return false;
+            break;
+        }
+        case ValueKind::STRING:
+            // The terminator must be in the pool too
+            if (entry.offset >= m_strings.size() ||
+                entry.size >= m_strings.size() - entry.offset ||
+                m_strings[entry.offset + entry.size] != '\0')
+                return false;
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <via/config.hpp>
+#include "debug.hpp"
+#include "sema/const.hpp"
+
+namespace via {
+
+// Constant as the VM reads it. Entries hold no pointers, so the pool of a
+// mapped module is used in place. Strings are stored NUL terminated after the
+// entries, `offset` being relative to the first of them.
+struct PoolConstant
+{
+    ValueKind kind;
+    uint8_t reserved[3] = {};
+    uint32_t size = 0;
+
+    union {
+        int64_t integer;
+        double_t float_;
+        bool boolean;
+        uint64_t offset;
+    };
+};
+
+static_assert(sizeof(PoolConstant) == 16, "pool constants are stored as is");
+
+class ConstantPool final
+{
+  public:
+    ConstantPool() = default;
+    ConstantPool(std::span<const PoolConstant> entries, std::string_view strings)
+        : m_entries(entries),
+          m_strings(strings)
+    {}
+
+    // Packs `constants` into `entries` and `strings`, which a pool can then view
+    static void pack(
+        const std::vector<ConstValue>& constants,
+        std::vector<PoolConstant>& entries,
+        std::string& strings
+    );
+
+  public:
+    size_t size() const noexcept { return m_entries.size(); }
+    auto entries() const noexcept { return m_entries; }
+    auto strings() const noexcept { return m_strings; }
+
+    const PoolConstant& at(size_t id) const noexcept
+    {
+        debug::require(id < m_entries.size(), "constant id out of range");
+        return m_entries[id];
+    }
+
+    int64_t integer(size_t id) const noexcept { return at(id).integer; }
+    double_t float_(size_t id) const noexcept { return at(id).float_; }
+    bool boolean(size_t id) const noexcept { return at(id).boolean; }
+    const char* string(size_t id) const noexcept
+    {
+        return m_strings.data() + at(id).offset;
+    }
+
+    // Copy of a constant for display, the VM reads entries directly
+    ConstValue value(size_t id) const;
+
+    // Whether every entry is well formed and its string lies within the pool
+    bool is_valid() const noexcept;
+
+  private:
+    std::span<const PoolConstant> m_entries;
+    std::string_view m_strings;
+};
+
+} // namespace via
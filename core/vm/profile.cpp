@@ -0,0 +1,147 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#include "profile.hpp"
+#include <format>
+#include <fstream>
+#include <sstream>
+
+namespace config = via::config;
+
+// Bumped whenever the layout of profile files changes
+static constexpr uint32_t PROFILE_VERSION = 2;
+
+// The name carries a hash of the absolute path of the module, so modules with
+// the same file name in different directories keep separate profiles
+std::filesystem::path via::Profile::path_for(
+    const std::filesystem::path& directory,
+    const std::filesystem::path& source
+)
+{
+    std::error_code ec;
+    auto absolute = std::filesystem::absolute(source, ec);
+    auto key = (ec ? source : absolute).lexically_normal().string();
+
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (char chr: key) {
+        hash ^= static_cast<uint8_t>(chr);
+        hash *= 0x100000001B3ULL;
+    }
+
+    return directory / std::format(
+                           "{}-{:016x}{}",
+                           source.stem().string(),
+                           hash,
+                           config::PROFILE_EXTENSION
+                       );
+}
+
+// Profiles are line based text of the form:
+//
+//   via-profile <version>
+//   module <path>
+//   hash <source hash>
+//   branch <site> <truthy> <falsy>
+//   call <site> <count>
+std::optional<via::Profile> via::Profile::load(
+    const std::filesystem::path& path,
+    const std::string& module_path,
+    uint64_t source_hash
+) noexcept
+{
+    std::ifstream ifs(path);
+    if (!ifs.is_open())
+        return std::nullopt;
+
+    std::string magic, module_key, module, hash_key;
+    uint32_t version;
+    uint64_t hash;
+
+    if (!(ifs >> magic >> version) || magic != "via-profile" ||
+        version != PROFILE_VERSION)
+        return std::nullopt;
+
+    ifs >> module_key >> std::ws;
+    if (module_key != "module" || !std::getline(ifs, module) || module != module_path)
+        return std::nullopt;
+
+    if (!(ifs >> hash_key >> std::hex >> hash >> std::dec) || hash_key != "hash" ||
+        hash != source_hash)
+        return std::nullopt;
+
+    Profile profile(module_path, source_hash);
+    std::string kind;
+
+    while (ifs >> kind) {
+        ProfileSite site;
+        if (!(ifs >> site))
+            return std::nullopt;
+
+        if (kind == "branch") {
+            auto& counts = profile.m_branches[site];
+            if (!(ifs >> counts.truthy >> counts.falsy))
+                return std::nullopt;
+        } else if (kind == "call") {
+            if (!(ifs >> profile.m_calls[site]))
+                return std::nullopt;
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    return profile;
+}
+
+bool via::Profile::save(const std::filesystem::path& path) const noexcept
+{
+    std::ostringstream oss;
+    oss << "via-profile " << PROFILE_VERSION << "\n";
+    oss << "module " << m_module_path << "\n";
+    oss << "hash " << std::hex << m_source_hash << std::dec << "\n";
+
+    for (const auto& [site, counts]: m_branches)
+        oss << "branch " << site << " " << counts.truthy << " " << counts.falsy << "\n";
+    for (const auto& [site, count]: m_calls)
+        oss << "call " << site << " " << count << "\n";
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    std::ofstream ofs(path, std::ios::trunc);
+    if (!ofs.is_open())
+        return false;
+
+    ofs << oss.str();
+    return ofs.good();
+}
+
+void via::Profile::merge(const Profile& other) noexcept
+{
+    for (const auto& [site, counts]: other.m_branches) {
+        auto& ours = m_branches[site];
+        ours.truthy += counts.truthy;
+        ours.falsy += counts.falsy;
+    }
+
+    for (const auto& [site, count]: other.m_calls)
+        m_calls[site] += count;
+}
+
+std::optional<via::BranchCounts> via::Profile::branch(ProfileSite site) const noexcept
+{
+    if (auto it = m_branches.find(site); it != m_branches.end())
+        return it->second;
+    return std::nullopt;
+}
+
+uint64_t via::Profile::calls(ProfileSite site) const noexcept
+{
+    auto it = m_calls.find(site);
+    return it != m_calls.end() ? it->second : 0;
+}
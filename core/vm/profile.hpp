@@ -0,0 +1,99 @@
+/* ===================================================== **
+**  This file is a part of the via Programming Language  **
+** ----------------------------------------------------- **
+**           Copyright (C) XnLogicaL 2024-2025           **
+**              Licensed under GNU GPLv3.0               **
+** ----------------------------------------------------- **
+**         https://github.com/XnLogicaL/via-lang         **
+** ===================================================== */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <via/config.hpp>
+#include "source.hpp"
+
+namespace via {
+namespace config {
+
+VIA_CONSTANT const char PROFILE_EXTENSION[] = ".prof";
+
+// Minimum number of times a branch must have run before its counts are trusted
+VIA_CONSTANT uint64_t PROFILE_MIN_SAMPLES = 64;
+
+// A branch edge taken at most this many times per thousand runs is cold
+VIA_CONSTANT uint64_t PROFILE_COLD_PERMILLE = 10;
+
+// Minimum number of calls for a function to be inlined with the hint budget
+VIA_CONSTANT uint64_t PROFILE_HOT_CALLS = 1024;
+
+} // namespace config
+
+// Profile sites are identified by source location rather than by bytecode
+// address, so that a profile stays valid across the layout changes it drives
+using ProfileSite = uint64_t;
+
+inline ProfileSite profile_site(SourceLoc loc) noexcept
+{
+    return (static_cast<uint64_t>(loc.begin) << 32) | (loc.end & 0xFFFFFFFF);
+}
+
+struct BranchCounts
+{
+    uint64_t truthy = 0;
+    uint64_t falsy = 0;
+
+    uint64_t total() const noexcept { return truthy + falsy; }
+};
+
+class Profile final
+{
+  public:
+    Profile(std::string module_path, uint64_t source_hash)
+        : m_module_path(std::move(module_path)),
+          m_source_hash(source_hash)
+    {}
+
+    // Profiles of every module are kept in `directory`, named after the module
+    static std::filesystem::path path_for(
+        const std::filesystem::path& directory,
+        const std::filesystem::path& source
+    );
+
+    // Returns nullopt if the file is missing, malformed or was recorded against
+    // a different module or revision of its source
+    static std::optional<Profile> load(
+        const std::filesystem::path& path,
+        const std::string& module_path,
+        uint64_t source_hash
+    ) noexcept;
+
+  public:
+    bool save(const std::filesystem::path& path) const noexcept;
+    void merge(const Profile& other) noexcept;
+
+    void record_branch(ProfileSite site, bool truthy) noexcept
+    {
+        auto& counts = m_branches[site];
+        (truthy ? counts.truthy : counts.falsy)++;
+    }
+
+    void record_call(ProfileSite site) noexcept { m_calls[site]++; }
+
+    std::optional<BranchCounts> branch(ProfileSite site) const noexcept;
+    uint64_t calls(ProfileSite site) const noexcept;
+    bool has_calls() const noexcept { return !m_calls.empty(); }
+
+  private:
+    std::string m_module_path;
+    uint64_t m_source_hash;
+    std::unordered_map<ProfileSite, BranchCounts> m_branches;
+    std::unordered_map<ProfileSite, uint64_t> m_calls;
+};
+
+} // namespace via
@@ -28,7 +28,8 @@ class Stack final
   public:
     explicit Stack(ScopedAllocator& alloc)
         : m_bp(alloc.emplace_array<T>(config::vm::STACK_SIZE)),
-          m_sp(m_bp)
+          m_sp(m_bp),
+          m_lp(m_bp)
     {}
 
     inline size_t size() const { return static_cast<size_t>(m_sp - m_bp); }
@@ -59,8 +60,9 @@ class Stack final
         return *(m_sp - 1);
     }
 
-    inline T& at(size_t idx) { return m_bp[idx]; }
-    inline const T& at(size_t idx) const { return m_bp[idx]; }
+    // Locals are indexed from the local base, see `rebase`
+    inline T& at(size_t idx) { return m_lp[idx]; }
+    inline const T& at(size_t idx) const { return m_lp[idx]; }
 
     inline T* begin() { return m_bp; }
     inline const T* begin() const { return m_bp; }
@@ -71,12 +73,19 @@ class Stack final
     inline T* base() { return m_bp; }
     inline const T* base() const { return m_bp; }
 
+    inline T* local_base() { return m_lp; }
+    inline const T* local_base() const { return m_lp; }
+
     inline void jump(T* dst) { m_sp = dst; }
     inline void jump(size_t dst) { m_sp = m_bp + dst; }
 
+    // Moves the local base to `dst`, leaving everything below it in place
+    inline void rebase(T* dst) { m_lp = dst; }
+
   private:
     T* const m_bp;
     T* m_sp;
+    T* m_lp; // Local base
 };
 
 } // namespace via
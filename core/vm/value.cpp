@@ -12,6 +12,7 @@
 #include "sema/const.hpp"
 #include "support/conv.hpp"
 #include "support/memory.hpp"
+#include "vm/pool.hpp"
 
 // clang-format off
 via::Value* via::Value::create(VirtualMachine* vm)
@@ -68,6 +69,30 @@ via::Value* via::Value::create(VirtualMachine* vm, const ConstValue& cv)
     debug::unimplemented();
 }
 
+via::Value* via::Value::create(VirtualMachine* vm, const ConstantPool& pool, size_t id)
+{
+    const PoolConstant& entry = pool.at(id);
+
+    switch (entry.kind) {
+    case ValueKind::NIL:
+        return create(vm);
+    case ValueKind::BOOL:
+        return create(vm, entry.boolean);
+    case ValueKind::INT:
+        return create(vm, entry.integer);
+    case ValueKind::FLOAT:
+        return create(vm, entry.float_);
+    case ValueKind::STRING: {
+        // Constants may live in a read only mapping, values own their string
+        auto buffer = vm->allocator().strdup(pool.string(id));
+        return create(vm, buffer);
+    }
+    default:
+        break;
+    }
+    debug::unimplemented();
+}
+
 bool via::Value::unref() noexcept
 {
     m_rc--;
@@ -93,9 +118,19 @@ void via::Value::free() noexcept
     m_kind = ValueKind::NIL;
 }
 
+// Values free their string or closure, so the copy gets its own
 via::Value* via::Value::clone() noexcept
 {
-    return create(m_vm, m_kind, m_data);
+    auto& alloc = m_vm->allocator();
+
+    switch (m_kind) {
+    case ValueKind::STRING:
+        return create(m_vm, alloc.strdup(m_data.string));
+    case ValueKind::FUNCTION:
+        return create(m_vm, alloc.emplace<Closure>(*m_data.function));
+    default:
+        return create(m_vm, m_kind, m_data);
+    }
 }
 
 std::optional<int64_t> via::Value::as_cint() const
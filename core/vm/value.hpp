@@ -25,6 +25,7 @@ using float64 = _Float64;
 using float64 = double;
 #endif
 
+class ConstantPool;
 class Value final
 {
   public:
@@ -39,7 +40,7 @@ class Value final
     friend class ValueRef;
     friend class VirtualMachine;
 
-    template <bool, bool>
+    template <bool, bool, bool>
     friend void detail::execute(VirtualMachine*);
 
   public:
@@ -50,6 +51,16 @@ class Value final
     static Value* create(VirtualMachine* vm, char* string);
     static Value* create(VirtualMachine* vm, Closure* closure);
     static Value* create(VirtualMachine* vm, const ConstValue& cv);
+    static Value* create(VirtualMachine* vm, const ConstantPool& pool, size_t id);
+
+    // Stores a scalar into `slot`. The value held by `slot` is overwritten in
+    // place when nothing else references it, sparing an allocation and a free.
+    static void store(VirtualMachine* vm, Value*& slot, int64_t integer);
+    static void store(VirtualMachine* vm, Value*& slot, float64 float_);
+    static void store(VirtualMachine* vm, Value*& slot, bool boolean);
+
+    // Stores a copy of `value` into `slot`, in place if both are scalars
+    static void store_copy(VirtualMachine* vm, Value*& slot, Value* value);
 
   public:
     auto kind() const { return m_kind; }
@@ -74,8 +85,15 @@ class Value final
     Value* as_string() const;
     std::string to_string() const noexcept;
 
+    bool is_scalar() const noexcept
+    {
+        return m_kind == ValueKind::NIL || m_kind == ValueKind::BOOL ||
+               m_kind == ValueKind::INT || m_kind == ValueKind::FLOAT;
+    }
+
   private:
     static Value* create(VirtualMachine* vm, ValueKind kind, Union data = {});
+    static void store(VirtualMachine* vm, Value*& slot, ValueKind kind, Union data);
 
   private:
     ValueKind m_kind = ValueKind::NIL;
@@ -84,4 +102,38 @@ class Value final
     VirtualMachine* m_vm;
 };
 
+inline void Value::store(VirtualMachine* vm, Value*& slot, ValueKind kind, Union data)
+{
+    [[likely]] if (slot != nullptr && slot->m_rc == 1 && slot->is_scalar()) {
+        slot->m_kind = kind;
+        slot->m_data = data;
+        return;
+    }
+
+    if (slot != nullptr)
+        slot->unref();
+    slot = create(vm, kind, data);
+}
+
+// clang-format off
+inline void Value::store(VirtualMachine* vm, Value*& slot, int64_t integer)
+    { store(vm, slot, ValueKind::INT, {.integer = integer}); }
+inline void Value::store(VirtualMachine* vm, Value*& slot, float64 float_)
+    { store(vm, slot, ValueKind::FLOAT, {.float_ = float_}); }
+inline void Value::store(VirtualMachine* vm, Value*& slot, bool boolean)
+    { store(vm, slot, ValueKind::BOOL, {.boolean = boolean}); }
+// clang-format on
+
+inline void Value::store_copy(VirtualMachine* vm, Value*& slot, Value* value)
+{
+    if (value->is_scalar())
+        return store(vm, slot, value->m_kind, value->m_data);
+
+    // Cloned first since `slot` may hold the only reference to `value`
+    Value* copy = value->clone();
+    if (slot != nullptr)
+        slot->unref();
+    slot = copy;
+}
+
 } // namespace via
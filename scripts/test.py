@@ -15,8 +15,24 @@ import sys
 from utils import error, info, warn
 
 
+# Options a test is run with, given on its first line as `// args: <options>`
+def read_args(file):
+    with open(file, "r") as f:
+        first = f.readline()
+
+    prefix = "// args:"
+    return first[len(prefix) :].split() if first.startswith(prefix) else []
+
+
 def test(binary, file):
-    result = subprocess.run([binary, "run", file], capture_output=True, text=True)
+    # Diagnostics are compared too, keep them free of color codes
+    env = dict(os.environ, TERM="dumb")
+    result = subprocess.run(
+        [binary, "run", *read_args(file), file],
+        capture_output=True,
+        text=True,
+        env=env,
+    )
     output = result.stdout.strip()
 
     with open(f"{file}.out", "r") as f: